@@ -49,6 +49,7 @@ def launch_setup(context, *args, **kwargs):
     gripper_max_force = LaunchConfiguration("gripper_max_force")
     use_fake_hardware = LaunchConfiguration("use_fake_hardware")
     fake_sensor_commands = LaunchConfiguration("fake_sensor_commands")
+    use_kortex_fake_hardware = LaunchConfiguration("use_kortex_fake_hardware")
     robot_traj_controller = LaunchConfiguration("robot_controller")
     robot_pos_controller = LaunchConfiguration("robot_pos_controller")
     robot_hand_controller = LaunchConfiguration("robot_hand_controller")
@@ -91,6 +92,9 @@ def launch_setup(context, *args, **kwargs):
             "fake_sensor_commands:=",
             fake_sensor_commands,
             " ",
+            "use_kortex_fake_hardware:=",
+            use_kortex_fake_hardware,
+            " ",
             "gripper:=",
             gripper,
             " ",
@@ -322,6 +326,15 @@ def generate_launch_description():
             Used only if 'use_fake_hardware' parameter is true.",
         )
     )
+    declared_arguments.append(
+        DeclareLaunchArgument(
+            "use_kortex_fake_hardware",
+            default_value="false",
+            description="Start robot with the fake hardware of kortex_driver, which \
+            exports the driver interfaces and simulates its timing. \
+            Ignored if 'use_fake_hardware' parameter is true.",
+        )
+    )
     declared_arguments.append(
         DeclareLaunchArgument(
             "robot_controller",
@@ -0,0 +1,307 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// Computes the pairs of links that need no collision check by sampling the joint space:
+//   ros2 run kortex_collision_matrix generate_collision_matrix robot.urdf robot.srdf [samples]
+//     [margin]
+// A pair is disabled when its links are adjacent, collide in the default state or in almost
+// every sample, or never come closer than margin (in m, 0.01 by default). The disabled pairs are
+// printed as SRDF elements, the statistics of every pair go to stderr.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <moveit/collision_detection_fcl/collision_env_fcl.h>
+#include <moveit/robot_model/robot_model.h>
+#include <moveit/robot_state/robot_state.h>
+#include <random_numbers/random_numbers.h>
+#include <rclcpp/rclcpp.hpp>
+#include <srdfdom/model.h>
+#include <urdf/model.h>
+
+namespace
+{
+const rclcpp::Logger LOGGER = rclcpp::get_logger("generate_collision_matrix");
+
+// a pair colliding in this fraction of the samples is always in collision
+constexpr double ALWAYS_IN_COLLISION = 0.95;
+constexpr std::uint32_t RANDOM_SEED = 0;
+
+using LinkPair = std::pair<std::string, std::string>;
+
+struct PairStatistics
+{
+  std::size_t collisions = 0;
+  double min_distance = std::numeric_limits<double>::infinity();
+};
+using Statistics = std::map<LinkPair, PairStatistics>;
+
+LinkPair makePair(const std::string & link1, const std::string & link2)
+{
+  return link1 < link2 ? LinkPair(link1, link2) : LinkPair(link2, link1);
+}
+
+bool readFile(const std::string & path, std::string & content)
+{
+  std::ifstream file(path);
+  if (!file)
+  {
+    return false;
+  }
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  content = buffer.str();
+  return true;
+}
+
+// Closest ancestor of the link with collision geometry, through the links without
+const moveit::core::LinkModel * parentWithGeometry(const moveit::core::LinkModel * link)
+{
+  for (link = link->getParentLinkModel(); link != nullptr; link = link->getParentLinkModel())
+  {
+    if (!link->getShapes().empty())
+    {
+      return link;
+    }
+  }
+  return nullptr;
+}
+
+// Collisions and closest distances of the pairs in statistics over random states
+void sample(
+  const collision_detection::CollisionEnvFCL & environment,
+  const moveit::core::RobotModelConstPtr & model,
+  const collision_detection::AllowedCollisionMatrix & acm, std::size_t count,
+  std::uint32_t seed, Statistics & statistics)
+{
+  moveit::core::RobotState state(model);
+  random_numbers::RandomNumberGenerator rng(seed);
+
+  collision_detection::CollisionRequest collision_request;
+  collision_request.contacts = true;
+  collision_request.max_contacts = statistics.size();
+  collision_request.max_contacts_per_pair = 1;
+  // the distance of a pair that collided once does not matter anymore
+  collision_detection::AllowedCollisionMatrix distance_acm = acm;
+  collision_detection::DistanceRequest distance_request;
+  distance_request.type = collision_detection::DistanceRequestType::SINGLE;
+  distance_request.acm = &distance_acm;
+
+  for (std::size_t i = 0; i < count; i++)
+  {
+    state.setToRandomPositions(rng);
+    state.update();
+
+    collision_detection::CollisionResult collision_result;
+    environment.checkSelfCollision(collision_request, collision_result, state, acm);
+    for (const auto & contact : collision_result.contacts)
+    {
+      const auto pair = statistics.find(makePair(contact.first.first, contact.first.second));
+      if (pair != statistics.end())
+      {
+        pair->second.collisions++;
+        distance_acm.setEntry(pair->first.first, pair->first.second, true);
+      }
+    }
+
+    collision_detection::DistanceResult distance_result;
+    environment.distanceSelf(distance_request, distance_result, state);
+    for (const auto & distances : distance_result.distances)
+    {
+      const auto pair = statistics.find(makePair(distances.first.first, distances.first.second));
+      if (pair == statistics.end())
+      {
+        continue;
+      }
+      for (const collision_detection::DistanceResultsData & distance : distances.second)
+      {
+        pair->second.min_distance = std::min(pair->second.min_distance, distance.distance);
+      }
+    }
+  }
+}
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  rclcpp::init(argc, argv);
+  const std::vector<std::string> args = rclcpp::remove_ros_arguments(argc, argv);
+  if (args.size() < 3)
+  {
+    std::fprintf(stderr, "usage: %s robot.urdf robot.srdf [samples] [margin]\n", args[0].c_str());
+    return 1;
+  }
+  const std::size_t sample_count = args.size() > 3 ? std::stoul(args[3]) : 10000;
+  const double margin = args.size() > 4 ? std::stod(args[4]) : 0.01;
+  if (sample_count == 0)
+  {
+    RCLCPP_ERROR(LOGGER, "At least one sample is needed");
+    return 1;
+  }
+
+  std::string urdf_xml;
+  std::string srdf_xml;
+  if (!readFile(args[1], urdf_xml) || !readFile(args[2], srdf_xml))
+  {
+    RCLCPP_ERROR(LOGGER, "Cannot read '%s' or '%s'", args[1].c_str(), args[2].c_str());
+    return 1;
+  }
+  auto urdf_model = std::make_shared<urdf::Model>();
+  auto srdf_model = std::make_shared<srdf::Model>();
+  if (!urdf_model->initString(urdf_xml) || !srdf_model->initString(*urdf_model, srdf_xml))
+  {
+    RCLCPP_ERROR(LOGGER, "Cannot parse the robot description");
+    return 1;
+  }
+  const auto robot_model = std::make_shared<moveit::core::RobotModel>(urdf_model, srdf_model);
+  const collision_detection::CollisionEnvFCL environment(robot_model);
+
+  // reason for every disabled pair, and the statistics of the others
+  std::map<LinkPair, std::string> disabled;
+  Statistics candidates;
+  collision_detection::AllowedCollisionMatrix acm;
+  const auto & links = robot_model->getLinkModelsWithCollisionGeometry();
+  for (const moveit::core::LinkModel * link : links)
+  {
+    const moveit::core::LinkModel * parent = parentWithGeometry(link);
+    if (parent != nullptr)
+    {
+      disabled[makePair(link->getName(), parent->getName())] = "Adjacent";
+      acm.setEntry(link->getName(), parent->getName(), true);
+    }
+  }
+  for (std::size_t i = 0; i < links.size(); i++)
+  {
+    for (std::size_t j = i + 1; j < links.size(); j++)
+    {
+      const LinkPair pair = makePair(links[i]->getName(), links[j]->getName());
+      if (disabled.count(pair) == 0)
+      {
+        candidates[pair] = PairStatistics();
+      }
+    }
+  }
+
+  moveit::core::RobotState state(robot_model);
+  state.setToDefaultValues();
+  state.update();
+  collision_detection::CollisionRequest request;
+  request.contacts = true;
+  request.max_contacts = candidates.size();
+  request.max_contacts_per_pair = 1;
+  collision_detection::CollisionResult result;
+  environment.checkSelfCollision(request, result, state, acm);
+  for (const auto & contact : result.contacts)
+  {
+    const LinkPair pair = makePair(contact.first.first, contact.first.second);
+    disabled[pair] = "Default";
+    candidates.erase(pair);
+    acm.setEntry(pair.first, pair.second, true);
+  }
+
+  // each thread samples its share of the states with its own seed
+  const std::size_t thread_count = std::max(1U, std::thread::hardware_concurrency());
+  std::vector<Statistics> thread_statistics(thread_count, candidates);
+  std::vector<std::thread> threads;
+  for (std::size_t i = 0; i < thread_count; i++)
+  {
+    const std::size_t count = sample_count / thread_count + (i < sample_count % thread_count);
+    threads.emplace_back(
+      sample, std::cref(environment), robot_model, std::cref(acm), count,
+      RANDOM_SEED + static_cast<std::uint32_t>(i), std::ref(thread_statistics[i]));
+  }
+  for (std::thread & thread : threads)
+  {
+    thread.join();
+  }
+  for (auto & [pair, statistics] : candidates)
+  {
+    for (const Statistics & other : thread_statistics)
+    {
+      statistics.collisions += other.at(pair).collisions;
+      statistics.min_distance = std::min(statistics.min_distance, other.at(pair).min_distance);
+    }
+  }
+
+  std::fprintf(
+    stderr, "%-32s %-32s %8s %10s  %s\n", "link1", "link2", "collide", "min (mm)", "disabled");
+  for (const auto & [pair, statistics] : candidates)
+  {
+    const double fraction =
+      static_cast<double>(statistics.collisions) / static_cast<double>(sample_count);
+    if (fraction >= ALWAYS_IN_COLLISION)
+    {
+      disabled[pair] = "Always";
+    }
+    else if (statistics.collisions == 0 && statistics.min_distance > margin)
+    {
+      disabled[pair] = "Never";
+    }
+    const auto reason = disabled.find(pair);
+    std::fprintf(
+      stderr, "%-32s %-32s %7.2f%% %10.1f  %s\n", pair.first.c_str(), pair.second.c_str(),
+      100.0 * fraction, statistics.collisions > 0 ? 0.0 : 1e3 * statistics.min_distance,
+      reason == disabled.end() ? "no" : reason->second.c_str());
+  }
+
+  // the pairs the SRDF should check but does not
+  std::size_t srdf_disabled = 0;
+  for (const srdf::Model::CollisionPair & srdf_pair : srdf_model->getDisabledCollisionPairs())
+  {
+    const LinkPair pair = makePair(srdf_pair.link1_, srdf_pair.link2_);
+    const auto statistics = candidates.find(pair);
+    srdf_disabled += disabled.count(pair) > 0 || statistics != candidates.end();
+    if (statistics == candidates.end() || disabled.count(pair) > 0)
+    {
+      continue;
+    }
+    if (statistics->second.collisions > 0)
+    {
+      RCLCPP_WARN(
+        LOGGER, "The SRDF disables '%s' and '%s', which collide in %zu samples",
+        pair.first.c_str(), pair.second.c_str(), statistics->second.collisions);
+    }
+    else
+    {
+      RCLCPP_WARN(
+        LOGGER, "The SRDF disables '%s' and '%s', which come within %.1f mm", pair.first.c_str(),
+        pair.second.c_str(), 1e3 * statistics->second.min_distance);
+    }
+  }
+  const std::size_t pair_count = links.size() * (links.size() - 1) / 2;
+  RCLCPP_INFO(
+    LOGGER, "%zu samples: %zu of %zu pairs to check, %zu with the SRDF", sample_count,
+    pair_count - disabled.size(), pair_count, pair_count - srdf_disabled);
+
+  for (const auto & [pair, reason] : disabled)
+  {
+    std::printf(
+      "    <disable_collisions link1=\"%s\" link2=\"%s\" reason=\"%s\"/>\n", pair.first.c_str(),
+      pair.second.c_str(), reason.c_str());
+  }
+
+  rclcpp::shutdown();
+  return 0;
+}
@@ -0,0 +1,519 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Simplified collision geometry for the arm meshes:
+//   convex_collision_mesh input.STL output.STL [tolerance]
+// writes the convex hull of the input mesh, built only from the vertices that move the hull by
+// more than tolerance (in m, 0.002 by default). The faces of that hull are then pushed outward by
+// the largest distance of a vertex outside of it, so that the output contains the whole mesh. That
+// distance is printed, along with the triangle counts.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace
+{
+constexpr double DEFAULT_TOLERANCE = 0.002;
+// corners of the grown hull closer than this to its other corners are dropped, in m
+constexpr double CORNER_TOLERANCE = 1e-7;
+constexpr std::size_t STL_HEADER_SIZE = 80;
+constexpr std::size_t STL_TRIANGLE_SIZE = 50;
+
+struct Vector
+{
+  double x;
+  double y;
+  double z;
+
+  bool operator<(const Vector & other) const
+  {
+    return std::tie(x, y, z) < std::tie(other.x, other.y, other.z);
+  }
+  bool operator==(const Vector & other) const
+  {
+    return x == other.x && y == other.y && z == other.z;
+  }
+};
+
+Vector operator+(const Vector & a, const Vector & b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+Vector operator-(const Vector & a, const Vector & b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+Vector operator*(const Vector & a, double s) { return {a.x * s, a.y * s, a.z * s}; }
+double dot(const Vector & a, const Vector & b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+double norm(const Vector & a) { return std::sqrt(dot(a, a)); }
+
+Vector cross(const Vector & a, const Vector & b)
+{
+  return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+struct Face
+{
+  std::array<int, 3> vertices;
+  Vector normal;
+  double offset;
+  // points further than the tolerance above this face, not on the hull yet
+  std::vector<int> outside;
+  bool removed = false;
+};
+
+// Corners of the triangles, three by three, from a binary or an ASCII STL file
+bool readStl(const std::string & path, std::vector<Vector> & corners)
+{
+  std::ifstream file(path, std::ios::binary);
+  const std::string content{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+  if (!file.good() && !file.eof())
+  {
+    return false;
+  }
+
+  std::uint32_t count = 0;
+  if (content.size() >= STL_HEADER_SIZE + sizeof(count))
+  {
+    std::memcpy(&count, content.data() + STL_HEADER_SIZE, sizeof(count));
+  }
+  if (content.size() == STL_HEADER_SIZE + sizeof(count) + count * STL_TRIANGLE_SIZE)
+  {
+    const char * triangle = content.data() + STL_HEADER_SIZE + sizeof(count);
+    for (std::uint32_t i = 0; i < count; i++, triangle += STL_TRIANGLE_SIZE)
+    {
+      // the normal comes first, then the three corners
+      float values[9];
+      std::memcpy(values, triangle + 3 * sizeof(float), sizeof(values));
+      for (int corner = 0; corner < 3; corner++)
+      {
+        corners.push_back({values[3 * corner], values[3 * corner + 1], values[3 * corner + 2]});
+      }
+    }
+    return true;
+  }
+
+  if (content.compare(0, 5, "solid") != 0)
+  {
+    return false;
+  }
+  std::istringstream stream(content);
+  std::string word;
+  while (stream >> word)
+  {
+    if (word == "vertex")
+    {
+      Vector corner;
+      if (!(stream >> corner.x >> corner.y >> corner.z))
+      {
+        return false;
+      }
+      corners.push_back(corner);
+    }
+  }
+  return corners.size() % 3 == 0;
+}
+
+bool writeStl(
+  const std::string & path, const std::vector<Vector> & points, const std::vector<Face> & faces)
+{
+  std::ofstream file(path, std::ios::binary);
+  char header[STL_HEADER_SIZE] = "convex collision mesh";
+  file.write(header, sizeof(header));
+  const auto count = static_cast<std::uint32_t>(faces.size());
+  file.write(reinterpret_cast<const char *>(&count), sizeof(count));
+  for (const Face & face : faces)
+  {
+    float values[12] = {
+      static_cast<float>(face.normal.x), static_cast<float>(face.normal.y),
+      static_cast<float>(face.normal.z)};
+    for (int corner = 0; corner < 3; corner++)
+    {
+      const Vector & point = points[face.vertices[corner]];
+      values[3 + 3 * corner] = static_cast<float>(point.x);
+      values[4 + 3 * corner] = static_cast<float>(point.y);
+      values[5 + 3 * corner] = static_cast<float>(point.z);
+    }
+    const std::uint16_t attributes = 0;
+    file.write(reinterpret_cast<const char *>(values), sizeof(values));
+    file.write(reinterpret_cast<const char *>(&attributes), sizeof(attributes));
+  }
+  return file.good();
+}
+
+// Closest point of the triangle (a, b, c) to the point, from Ericson's Real-Time Collision
+// Detection
+Vector closestPoint(const Vector & point, const Vector & a, const Vector & b, const Vector & c)
+{
+  const Vector ab = b - a;
+  const Vector ac = c - a;
+  const Vector ap = point - a;
+  const double d1 = dot(ab, ap);
+  const double d2 = dot(ac, ap);
+  if (d1 <= 0.0 && d2 <= 0.0)
+  {
+    return a;
+  }
+  const Vector bp = point - b;
+  const double d3 = dot(ab, bp);
+  const double d4 = dot(ac, bp);
+  if (d3 >= 0.0 && d4 <= d3)
+  {
+    return b;
+  }
+  const double vc = d1 * d4 - d3 * d2;
+  if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0)
+  {
+    return a + ab * (d1 / (d1 - d3));
+  }
+  const Vector cp = point - c;
+  const double d5 = dot(ab, cp);
+  const double d6 = dot(ac, cp);
+  if (d6 >= 0.0 && d5 <= d6)
+  {
+    return c;
+  }
+  const double vb = d5 * d2 - d1 * d6;
+  if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0)
+  {
+    return a + ac * (d2 / (d2 - d6));
+  }
+  const double va = d3 * d6 - d5 * d4;
+  if (va <= 0.0 && d4 - d3 >= 0.0 && d5 - d6 >= 0.0)
+  {
+    return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+  }
+  const double scale = 1.0 / (va + vb + vc);
+  return a + ab * (vb * scale) + ac * (vc * scale);
+}
+
+// Quickhull, except that the points less than the tolerance above the hull are dropped instead
+// of being added to it
+class ConvexHull
+{
+public:
+  ConvexHull(const std::vector<Vector> & points, double tolerance)
+  : points_(points), tolerance_(tolerance)
+  {
+  }
+
+  bool build();
+  // Largest distance of one of the points outside of the hull
+  double error(const std::vector<Vector> & points) const;
+
+  const std::vector<Face> & faces() const { return faces_; }
+
+private:
+  double distance(const Face & face, int point) const
+  {
+    return dot(face.normal, points_[point]) - face.offset;
+  }
+  // Facing away from the interior point
+  void addFace(int a, int b, int c);
+  // Hands the point to the face it is the furthest above, if by more than the tolerance
+  void assign(int point, std::size_t first_face);
+  void addPoint(std::size_t face);
+
+  const std::vector<Vector> & points_;
+  double tolerance_;
+  double epsilon_ = 0.0;
+  Vector interior_{0.0, 0.0, 0.0};
+  std::vector<Face> faces_;
+};
+
+bool ConvexHull::build()
+{
+  if (points_.size() < 4)
+  {
+    return false;
+  }
+  // the two furthest apart of the extreme points along the axes, and the points furthest from
+  // their line and from the plane of the three
+  std::array<int, 6> extremes{};
+  for (int i = 0; i < static_cast<int>(points_.size()); i++)
+  {
+    const Vector & point = points_[i];
+    extremes[0] = point.x < points_[extremes[0]].x ? i : extremes[0];
+    extremes[1] = point.x > points_[extremes[1]].x ? i : extremes[1];
+    extremes[2] = point.y < points_[extremes[2]].y ? i : extremes[2];
+    extremes[3] = point.y > points_[extremes[3]].y ? i : extremes[3];
+    extremes[4] = point.z < points_[extremes[4]].z ? i : extremes[4];
+    extremes[5] = point.z > points_[extremes[5]].z ? i : extremes[5];
+  }
+  int a = 0;
+  int b = 0;
+  double size = 0.0;
+  for (int i : extremes)
+  {
+    for (int j : extremes)
+    {
+      if (norm(points_[i] - points_[j]) > size)
+      {
+        size = norm(points_[i] - points_[j]);
+        a = i;
+        b = j;
+      }
+    }
+  }
+  epsilon_ = 1e-9 * size;
+
+  int c = a;
+  double line_distance = 0.0;
+  const Vector direction = (points_[b] - points_[a]) * (1.0 / std::max(size, epsilon_));
+  for (int i = 0; i < static_cast<int>(points_.size()); i++)
+  {
+    const double d = norm(cross(points_[i] - points_[a], direction));
+    if (d > line_distance)
+    {
+      line_distance = d;
+      c = i;
+    }
+  }
+  int d = a;
+  double plane_distance = 0.0;
+  const Vector normal = cross(points_[b] - points_[a], points_[c] - points_[a]);
+  for (int i = 0; i < static_cast<int>(points_.size()); i++)
+  {
+    const double distance = std::abs(dot(points_[i] - points_[a], normal)) / norm(normal);
+    if (distance > plane_distance)
+    {
+      plane_distance = distance;
+      d = i;
+    }
+  }
+  if (size <= 0.0 || line_distance <= epsilon_ || plane_distance <= epsilon_)
+  {
+    return false;
+  }
+
+  interior_ = (points_[a] + points_[b] + points_[c] + points_[d]) * 0.25;
+  addFace(a, b, c);
+  addFace(a, b, d);
+  addFace(a, c, d);
+  addFace(b, c, d);
+  for (int i = 0; i < static_cast<int>(points_.size()); i++)
+  {
+    assign(i, 0);
+  }
+  // the faces added along the way come after the current one
+  for (std::size_t face = 0; face < faces_.size(); face++)
+  {
+    while (!faces_[face].removed && !faces_[face].outside.empty())
+    {
+      addPoint(face);
+    }
+  }
+
+  faces_.erase(
+    std::remove_if(faces_.begin(), faces_.end(), [](const Face & face) { return face.removed; }),
+    faces_.end());
+  return true;
+}
+
+void ConvexHull::addFace(int a, int b, int c)
+{
+  Face face;
+  face.vertices = {a, b, c};
+  face.normal = cross(points_[b] - points_[a], points_[c] - points_[a]);
+  face.normal = face.normal * (1.0 / norm(face.normal));
+  face.offset = dot(face.normal, points_[a]);
+  if (dot(face.normal, interior_) > face.offset)
+  {
+    std::swap(face.vertices[1], face.vertices[2]);
+    face.normal = face.normal * -1.0;
+    face.offset = -face.offset;
+  }
+  faces_.push_back(std::move(face));
+}
+
+void ConvexHull::assign(int point, std::size_t first_face)
+{
+  std::size_t best_face = faces_.size();
+  double best_distance = tolerance_;
+  for (std::size_t face = first_face; face < faces_.size(); face++)
+  {
+    const double d = faces_[face].removed ? 0.0 : distance(faces_[face], point);
+    if (d > best_distance)
+    {
+      best_distance = d;
+      best_face = face;
+    }
+  }
+  if (best_face < faces_.size())
+  {
+    faces_[best_face].outside.push_back(point);
+  }
+  else if (first_face > 0)
+  {
+    // not above the new faces, maybe above one left as it was
+    assign(point, 0);
+  }
+}
+
+void ConvexHull::addPoint(std::size_t face)
+{
+  const std::vector<int> & outside = faces_[face].outside;
+  const int eye = *std::max_element(
+    outside.begin(), outside.end(),
+    [&](int a, int b) { return distance(faces_[face], a) < distance(faces_[face], b); });
+
+  // the horizon is made of the edges of the visible faces that only one of them has
+  std::set<std::pair<int, int>> edges;
+  std::vector<int> orphans;
+  for (Face & visible : faces_)
+  {
+    if (visible.removed || dot(visible.normal, points_[eye]) - visible.offset <= epsilon_)
+    {
+      continue;
+    }
+    for (int i = 0; i < 3; i++)
+    {
+      edges.emplace(visible.vertices[i], visible.vertices[(i + 1) % 3]);
+    }
+    orphans.insert(orphans.end(), visible.outside.begin(), visible.outside.end());
+    visible.outside.clear();
+    visible.removed = true;
+  }
+
+  const std::size_t first_new_face = faces_.size();
+  for (const auto & edge : edges)
+  {
+    if (edges.count({edge.second, edge.first}) == 0)
+    {
+      addFace(edge.first, edge.second, eye);
+    }
+  }
+  for (int orphan : orphans)
+  {
+    if (orphan != eye)
+    {
+      assign(orphan, first_new_face);
+    }
+  }
+}
+
+double ConvexHull::error(const std::vector<Vector> & points) const
+{
+  double error = 0.0;
+  for (const Vector & p : points)
+  {
+    const bool inside = std::all_of(faces_.begin(), faces_.end(), [&](const Face & face) {
+      return dot(face.normal, p) - face.offset <= 0.0;
+    });
+    if (inside)
+    {
+      continue;
+    }
+    double closest = INFINITY;
+    for (const Face & face : faces_)
+    {
+      const Vector projection = closestPoint(
+        p, points_[face.vertices[0]], points_[face.vertices[1]], points_[face.vertices[2]]);
+      closest = std::min(closest, norm(p - projection));
+    }
+    error = std::max(error, closest);
+  }
+  return error;
+}
+
+// Corners of the hull with its faces pushed outward by distance. Around an interior point, each
+// face plane n.x = h becomes the dual point n / h, and each facet m.y = k of the convex hull of
+// these points is a corner m / k where the planes of its vertices meet.
+bool growHull(
+  const std::vector<Vector> & points, const std::vector<Face> & faces, double distance,
+  std::vector<Vector> & corners)
+{
+  Vector center{0.0, 0.0, 0.0};
+  for (const Face & face : faces)
+  {
+    center = center + (points[face.vertices[0]] + points[face.vertices[1]] +
+                       points[face.vertices[2]]) * (1.0 / (3.0 * faces.size()));
+  }
+  std::vector<Vector> planes;
+  double size = 0.0;
+  for (const Face & face : faces)
+  {
+    const double height = face.offset + distance - dot(face.normal, center);
+    planes.push_back(face.normal * (1.0 / height));
+    size = std::max(size, norm(planes.back()));
+  }
+  std::sort(planes.begin(), planes.end());
+  planes.erase(std::unique(planes.begin(), planes.end()), planes.end());
+
+  // planes that hardly cut the others are dropped, which only makes the result larger
+  ConvexHull dual(planes, 1e-6 * size);
+  if (!dual.build())
+  {
+    return false;
+  }
+  corners.clear();
+  for (const Face & facet : dual.faces())
+  {
+    corners.push_back(center + facet.normal * (1.0 / facet.offset));
+  }
+  return true;
+}
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  if (argc < 3)
+  {
+    std::fprintf(stderr, "usage: %s input.STL output.STL [tolerance]\n", argv[0]);
+    return 1;
+  }
+  const double tolerance = argc > 3 ? std::atof(argv[3]) : DEFAULT_TOLERANCE;
+
+  std::vector<Vector> points;
+  if (!readStl(argv[1], points) || tolerance < 0.0)
+  {
+    std::fprintf(stderr, "Could not read the STL file %s\n", argv[1]);
+    return 1;
+  }
+  const std::size_t triangles = points.size() / 3;
+  std::sort(points.begin(), points.end());
+  points.erase(std::unique(points.begin(), points.end()), points.end());
+
+  ConvexHull hull(points, tolerance);
+  if (!hull.build())
+  {
+    std::fprintf(stderr, "%s is flat, it has no convex hull\n", argv[1]);
+    return 1;
+  }
+  // the dropped vertices are up to about tolerance outside of the hull, grow it to contain them
+  const double distance = hull.error(points);
+  std::vector<Vector> corners;
+  ConvexHull grown(corners, CORNER_TOLERANCE);
+  if (!growHull(points, hull.faces(), distance, corners) || !grown.build())
+  {
+    std::fprintf(stderr, "Could not grow the convex hull of %s\n", argv[1]);
+    return 1;
+  }
+  if (!writeStl(argv[2], corners, grown.faces()))
+  {
+    std::fprintf(stderr, "Could not write the STL file %s\n", argv[2]);
+    return 1;
+  }
+  std::printf(
+    "%s: %zu triangles, %zu for the hull, grown by %.2f mm to contain the mesh\n", argv[1],
+    triangles, grown.faces().size(), 1000.0 * distance);
+  return 0;
+}
@@ -0,0 +1,100 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef KORTEX_DRIVER__ACTUATOR_CYCLIC_CHANNEL_HPP_
+#define KORTEX_DRIVER__ACTUATOR_CYCLIC_CHANNEL_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "kortex_driver/feedback_snapshot.hpp"
+
+#include "ActuatorCyclicClientRpc.h"
+#include "RouterClient.h"
+#include "SessionManager.h"
+#include "TransportClientUdp.h"
+
+namespace kortex_driver
+{
+enum class ActuatorCyclicRouting
+{
+  // every actuator on the router of the base cyclic channel
+  SHARED,
+  // one UDP connection, router and session per actuator
+  DEDICATED,
+};
+
+// Accepts "shared" and "dedicated"
+bool parseActuatorCyclicRouting(const std::string & name, ActuatorCyclicRouting & routing);
+
+// Cyclic exchanges with each actuator through its ActuatorCyclic service instead of the base
+// cyclic loop. The commands of all actuators are sent before any feedback is awaited, so the
+// exchanges overlap and each actuator answers as soon as it can.
+class ActuatorCyclicChannel
+{
+public:
+  ActuatorCyclicChannel() = default;
+  ActuatorCyclicChannel(const ActuatorCyclicChannel &) = delete;
+  ActuatorCyclicChannel & operator=(const ActuatorCyclicChannel &) = delete;
+  ~ActuatorCyclicChannel();
+
+  // device_ids in joint order. Dedicated routing connects to ip:port and opens a session on
+  // each connection, shared routing only uses shared_router.
+  bool open(
+    const std::vector<std::uint32_t> & device_ids, ActuatorCyclicRouting routing,
+    k_api::RouterClient * shared_router, const std::string & ip, std::uint32_t port,
+    const k_api::Session::CreateSessionInfo & session_info);
+  void close();
+  bool isOpen() const { return !clients_.empty(); }
+
+  // Commands each actuator to positions (rad) and decodes its feedback into snapshot, whose
+  // arm state and base faults stay those of the last base frame. False when an exchange failed,
+  // the joints of failed exchanges keep their last feedback.
+  bool exchange(
+    const std::vector<double> & positions, std::uint32_t frame_id, std::uint32_t timeout_ms,
+    FeedbackSnapshot & snapshot);
+
+  // stable while the channel is open, exported as state interfaces. Time from sending the
+  // command to having the feedback (s), and the communication jitter the actuator reports (s).
+  std::vector<double> & roundTrips() { return round_trips_; }
+  std::vector<double> & jitters() { return jitters_; }
+
+private:
+  struct DedicatedLink
+  {
+    explicit DedicatedLink(k_api::ITransportClient * transport_client);
+
+    k_api::RouterClient router;
+    k_api::SessionManager session_manager;
+  };
+
+  std::vector<std::uint32_t> device_ids_;
+  std::vector<std::unique_ptr<k_api::TransportClientUdp>> transports_;
+  std::vector<std::unique_ptr<DedicatedLink>> links_;
+  std::vector<std::unique_ptr<k_api::ActuatorCyclic::ActuatorCyclicClient>> clients_;
+
+  std::vector<k_api::ActuatorCyclic::Command> commands_;
+  std::vector<std::future<k_api::ActuatorCyclic::Feedback>> pending_;
+  std::vector<double> actuator_faults_;
+  std::vector<double> round_trips_;
+  std::vector<double> jitters_;
+};
+
+}  // namespace kortex_driver
+
+#endif  // KORTEX_DRIVER__ACTUATOR_CYCLIC_CHANNEL_HPP_
@@ -0,0 +1,116 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef KORTEX_DRIVER__CAPTURE_TRANSPORT_HPP_
+#define KORTEX_DRIVER__CAPTURE_TRANSPORT_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "ITransportClient.h"
+
+namespace k_api = Kinova::Api;
+
+namespace kortex_driver
+{
+// Bounded lock-free queue of captured frames. Any thread may push, a single writer pops.
+// Frames longer than the snap length are truncated, pushes into a full queue are dropped.
+class CaptureRing
+{
+public:
+  struct Record
+  {
+    std::int64_t timestamp_ns;
+    std::uint32_t original_length;
+    std::uint32_t captured_length;
+    bool outbound;
+    const char * data;
+  };
+
+  CaptureRing(std::size_t capacity, std::uint32_t snap_length);
+
+  bool push(const char * data, std::uint32_t size, bool outbound, std::int64_t timestamp_ns);
+  // Hands the oldest frame to consume and releases it, returns false when empty
+  bool pop(const std::function<void(const Record &)> & consume);
+
+  std::uint32_t snapLength() const { return snap_length_; }
+
+private:
+  struct Cell
+  {
+    std::atomic<std::size_t> sequence;
+    std::int64_t timestamp_ns;
+    std::uint32_t original_length;
+    std::uint32_t captured_length;
+    bool outbound;
+  };
+
+  std::size_t mask_;
+  std::uint32_t snap_length_;
+  std::unique_ptr<Cell[]> cells_;
+  std::unique_ptr<char[]> data_;
+  std::atomic<std::size_t> enqueue_position_{0};
+  std::size_t dequeue_position_ = 0;
+};
+
+// Transport decorator copying every frame going through the wrapped transport into a
+// CaptureRing. A background thread streams them to a pcapng file with host timestamps.
+class CaptureTransport : public k_api::ITransportClient
+{
+public:
+  CaptureTransport(
+    k_api::ITransportClient * transport, const std::string & file_name,
+    const std::string & interface_name, std::size_t queue_size, std::uint32_t snap_length);
+  ~CaptureTransport() override;
+
+  // Opens the file and starts the writer, returns false when the file can't be created
+  bool start();
+
+  bool connect(std::string host, uint32_t port) override;
+  void disconnect() override;
+  void send(const char * tx_buffer, uint32_t tx_size) override;
+  void onMessage(std::function<void(const char *, uint32_t)> callback) override;
+  char * getTxBuffer() override;
+  size_t getMaxTxBufferSize() override;
+
+  std::uint64_t droppedFrames() const { return dropped_.load(std::memory_order_relaxed); }
+
+  // LINKTYPE_USER0, Kortex frames are captured without any network header
+  static constexpr std::uint16_t LINK_TYPE = 147;
+
+private:
+  void capture(const char * data, uint32_t size, bool outbound);
+  void writeLoop();
+  void writeHeader();
+  void writeRecord(const CaptureRing::Record & record);
+
+  k_api::ITransportClient * transport_;
+  std::string file_name_;
+  std::string interface_name_;
+  CaptureRing ring_;
+  std::FILE * file_ = nullptr;
+  std::atomic<bool> running_{false};
+  std::atomic<std::uint64_t> dropped_{0};
+  std::thread writer_thread_;
+};
+
+}  // namespace kortex_driver
+
+#endif  // KORTEX_DRIVER__CAPTURE_TRANSPORT_HPP_
@@ -0,0 +1,75 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef KORTEX_DRIVER__COLLISION_DETECTOR_HPP_
+#define KORTEX_DRIVER__COLLISION_DETECTOR_HPP_
+
+#include <cstddef>
+#include <vector>
+
+#include "kortex_driver/rigid_body_model.hpp"
+
+namespace kortex_driver
+{
+// Generalized momentum observer. Its residual r follows the external joint torques as a first
+// order system of bandwidth gain:
+//   r = gain * (M(q) qd - integral(tau + C(q, qd)^T qd - g(q) + r) dt)
+// with tau the measured joint torques. A contact is reported once a joint residual stays
+// above its threshold for a few cycles, and stays reported until it is cleared.
+class CollisionDetector
+{
+public:
+  // Allocates, not real-time safe. A single threshold applies to every joint.
+  void configure(
+    std::size_t joint_count, double gain, const std::vector<double> & thresholds,
+    int confirmation_cycles);
+  // The next update starts the observer again from the current momentum
+  void reset();
+
+  // One observer step, positions in rad, velocities in rad/s and efforts in N*m
+  void update(
+    RigidBodyModel & model, const std::vector<double> & positions,
+    const std::vector<double> & velocities, const std::vector<double> & efforts, double dt);
+
+  bool inContact() const { return contact_ != 0.0; }
+  void clearContact();
+
+  // stable for the lifetime of the detector, exported as state interfaces
+  std::vector<double> & externalTorques() { return external_torques_; }
+  double & contact() { return contact_; }
+
+private:
+  double gain_ = 50.0;
+  std::vector<double> thresholds_;
+  int confirmation_cycles_ = 2;
+  bool initialized_ = false;
+  int cycles_above_threshold_ = 0;
+
+  std::vector<double> external_torques_;
+  double contact_ = 0.0;
+
+  RigidBodyModel::JointVector q_;
+  RigidBodyModel::JointVector qd_;
+  RigidBodyModel::JointVector tau_;
+  RigidBodyModel::JointVector gravity_;
+  RigidBodyModel::JointVector coriolis_;
+  RigidBodyModel::JointVector residual_;
+  RigidBodyModel::JointVector integral_;
+  RigidBodyModel::JointMatrix mass_matrix_;
+  RigidBodyModel::JointMatrix previous_mass_matrix_;
+};
+
+}  // namespace kortex_driver
+
+#endif  // KORTEX_DRIVER__COLLISION_DETECTOR_HPP_
@@ -0,0 +1,131 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef KORTEX_DRIVER__CYCLIC_FRAME_CODEC_HPP_
+#define KORTEX_DRIVER__CYCLIC_FRAME_CODEC_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "kortex_driver/feedback_snapshot.hpp"
+
+#include "BaseCyclic.pb.h"
+
+namespace k_api = Kinova::Api;
+
+namespace kortex_driver
+{
+// Protocol buffers encoding of a BaseCyclic::Command laid out once, so that a cycle only
+// overwrites the bytes of its fields instead of serializing the message. Every field is
+// present, varints are padded to five bytes and floats are fixed32, so none of them moves
+// when its value changes. Parsers accept padded varints, the decoded message is the same.
+// Field numbers come from the message descriptors of the Kortex API.
+class CyclicCommandEncoder
+{
+public:
+  // Allocates the payload, not real-time safe. Lays out the frame id, actuator_count actuator
+  // commands with their command id and position, and the gripper motor command of the
+  // interconnect. false if a field of the messages could not be found.
+  bool layout(std::size_t actuator_count);
+  bool isLaidOut() const { return !payload_.empty(); }
+
+  void setFrameId(std::uint32_t frame_id) { writeVarint(frame_id_offset_, frame_id); }
+  // position in degrees, as in ActuatorCommand
+  void setActuator(std::size_t index, float position, std::uint32_t command_id)
+  {
+    writeVarint(actuator_offsets_[index].command_id, command_id);
+    writeFloat(actuator_offsets_[index].position, position);
+  }
+  // position, velocity and force in %, as in GripperCyclic::MotorCommand
+  void setGripper(float position, float velocity, float force)
+  {
+    writeFloat(gripper_position_offset_, position);
+    writeFloat(gripper_velocity_offset_, velocity);
+    writeFloat(gripper_force_offset_, force);
+  }
+
+  // Serialized BaseCyclic::Command, the buffer never moves once laid out
+  const std::string & payload() const { return payload_; }
+
+  // Whether the payload parses into the same message as command, which is how the layout is
+  // checked against the Kortex API before being used
+  bool encodes(const k_api::BaseCyclic::Command & command) const;
+
+private:
+  struct ActuatorOffsets
+  {
+    std::size_t command_id = 0;
+    std::size_t position = 0;
+  };
+
+  void writeVarint(std::size_t offset, std::uint32_t value);
+  void writeFloat(std::size_t offset, float value);
+
+  std::string payload_;
+  std::size_t frame_id_offset_ = 0;
+  std::vector<ActuatorOffsets> actuator_offsets_;
+  std::size_t gripper_position_offset_ = 0;
+  std::size_t gripper_velocity_offset_ = 0;
+  std::size_t gripper_force_offset_ = 0;
+};
+
+// Reads the fields of a FeedbackSnapshot straight from a serialized BaseCyclic::Feedback and
+// skips everything else, the diagnostics of the base, actuators and interconnect are never
+// parsed. Field numbers come from the message descriptors of the Kortex API.
+class CyclicFeedbackDecoder
+{
+public:
+  // Allocates for actuator_count joints, not real-time safe. false if a field of the messages
+  // could not be found.
+  bool configure(std::size_t actuator_count);
+  bool isConfigured() const { return configured_; }
+
+  // Same result as FeedbackSnapshot::decode() on the parsed message, does not allocate for
+  // snapshots of the configured size. false and snapshot untouched if the payload is malformed.
+  bool decode(const std::string & payload, FeedbackSnapshot & snapshot, bool with_gripper);
+
+  // Whether decoding the serialized feedback gives the snapshot of FeedbackSnapshot::decode(),
+  // which is how the field numbers are checked against the Kortex API before being used
+  bool decodes(const k_api::BaseCyclic::Feedback & feedback, bool with_gripper);
+
+private:
+  struct Fields
+  {
+    int base = 0;
+    int actuators = 0;
+    int interconnect = 0;
+    int base_active_state = 0;
+    int base_fault_bank_a = 0;
+    int base_fault_bank_b = 0;
+    int actuator_position = 0;
+    int actuator_velocity = 0;
+    int actuator_torque = 0;
+    int actuator_fault_bank_a = 0;
+    int actuator_fault_bank_b = 0;
+    int gripper_feedback = 0;
+    int gripper_motor = 0;
+    int motor_position = 0;
+  };
+
+  Fields fields_;
+  bool configured_ = false;
+  // joints of the frame being decoded, copied over once all of it parsed
+  FeedbackSnapshot joints_;
+};
+
+}  // namespace kortex_driver
+
+#endif  // KORTEX_DRIVER__CYCLIC_FRAME_CODEC_HPP_
@@ -0,0 +1,75 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef KORTEX_DRIVER__CYCLIC_RETRY_POLICY_HPP_
+#define KORTEX_DRIVER__CYCLIC_RETRY_POLICY_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace kortex_driver
+{
+// Outcome of a single exchange on the cyclic (UDP) channel
+enum class CyclicError : std::uint8_t
+{
+  NONE = 0,
+  KORTEX = 1,
+  RUNTIME = 2,
+  FUTURE = 3,
+  OTHER = 4,
+  COUNT = 5
+};
+
+// What to do with a cycle once all of its attempts failed
+enum class CyclicFailureAction : std::uint8_t
+{
+  // keep the last received feedback and move on to the next cycle
+  SKIP = 0,
+  // request one more feedback-only frame (behavior of the driver before the retry policy)
+  REFRESH_FEEDBACK = 1
+};
+
+struct CyclicRetryPolicy
+{
+  // number of additional attempts after the first failed one
+  std::uint32_t max_retries = 0;
+  // per attempt timeout handed to the router, bounds the worst case cycle time
+  std::uint32_t timeout_ms = 3000;
+  // write() reports an error after this many consecutive failed cycles, 0 disables the check
+  std::uint32_t max_consecutive_failures = 0;
+  CyclicFailureAction on_failure = CyclicFailureAction::SKIP;
+
+  static bool parseFailureAction(const std::string & name, CyclicFailureAction & action);
+};
+
+// Counters are kept as doubles so they can be exported directly as state interfaces
+struct CyclicStatistics
+{
+  std::array<double, static_cast<std::size_t>(CyclicError::COUNT)> errors{};
+  double retries = 0.0;
+  double failed_cycles = 0.0;
+  double consecutive_failures = 0.0;
+  double last_error_sub_code = 0.0;
+
+  void record(CyclicError error) { errors[static_cast<std::size_t>(error)] += 1.0; }
+  void reset() { *this = CyclicStatistics(); }
+};
+
+const char * toString(CyclicError error);
+
+}  // namespace kortex_driver
+
+#endif  // KORTEX_DRIVER__CYCLIC_RETRY_POLICY_HPP_
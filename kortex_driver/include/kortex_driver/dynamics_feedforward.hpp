@@ -0,0 +1,56 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef KORTEX_DRIVER__DYNAMICS_FEEDFORWARD_HPP_
+#define KORTEX_DRIVER__DYNAMICS_FEEDFORWARD_HPP_
+
+#include <cstddef>
+#include <vector>
+
+#include "kortex_driver/rigid_body_model.hpp"
+
+namespace kortex_driver
+{
+// Dynamics terms of the measured state, evaluated once per cycle for effort and impedance
+// controllers: gravity torques g(q), Coriolis and centrifugal torques C(q, qd) qd and the
+// diagonal of the joint space inertia M(q).
+class DynamicsFeedForward
+{
+public:
+  // Allocates the terms, not real-time safe
+  void configure(std::size_t joint_count);
+
+  // positions in rad and velocities in rad/s
+  void update(
+    RigidBodyModel & model, const std::vector<double> & positions,
+    const std::vector<double> & velocities);
+
+  // stable for the lifetime of the object, exported as state interfaces
+  std::vector<double> & gravityEfforts() { return gravity_efforts_; }
+  std::vector<double> & coriolisEfforts() { return coriolis_efforts_; }
+  std::vector<double> & inertias() { return inertias_; }
+
+private:
+  std::vector<double> gravity_efforts_;
+  std::vector<double> coriolis_efforts_;
+  std::vector<double> inertias_;
+
+  RigidBodyModel::JointVector q_;
+  RigidBodyModel::JointVector qd_;
+  RigidBodyModel::JointVector terms_;
+};
+
+}  // namespace kortex_driver
+
+#endif  // KORTEX_DRIVER__DYNAMICS_FEEDFORWARD_HPP_
@@ -0,0 +1,208 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef KORTEX_DRIVER__FAKE_HARDWARE_HPP_
+#define KORTEX_DRIVER__FAKE_HARDWARE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "rclcpp/macros.hpp"
+#include "rclcpp/node.hpp"
+#include "rclcpp/time.hpp"
+#include "rosgraph_msgs/msg/clock.hpp"
+
+#include "hardware_interface/handle.hpp"
+#include "hardware_interface/hardware_info.hpp"
+#include "hardware_interface/system_interface.hpp"
+#include "hardware_interface/types/hardware_interface_return_values.hpp"
+
+#include "kortex_driver/cyclic_retry_policy.hpp"
+#include "kortex_driver/dynamics_feedforward.hpp"
+#include "kortex_driver/joint_state_estimator.hpp"
+#include "kortex_driver/latency_predictor.hpp"
+#include "kortex_driver/metered_transport.hpp"
+#include "kortex_driver/sim_shared_memory.hpp"
+#include "kortex_driver/visibility_control.h"
+
+using hardware_interface::return_type;
+using CallbackReturn = rclcpp_lifecycle::node_interfaces::LifecycleNodeInterface::CallbackReturn;
+
+namespace kortex_driver
+{
+// Stand-in for KortexMultiInterfaceHardware without a robot. It exports the same interfaces
+// and follows the same mode switching rules. Joints and gripper track their commands as
+// first-order systems behind a cyclic dead time. Failed cyclic exchanges and arm faults can be
+// injected at random. In lockstep mode every read() advances a simulated clock by one fixed
+// period whatever the wall time, which makes runs reproducible and as fast as the CPU allows.
+// With a shared memory segment the internal model is replaced by a co-located simulator, the
+// joint targets are written to it and the joint states read back from it every cycle.
+class KortexFakeHardware : public hardware_interface::SystemInterface
+{
+public:
+  RCLCPP_SHARED_PTR_DEFINITIONS(KortexFakeHardware);
+
+  KORTEX_DRIVER_PUBLIC
+  CallbackReturn on_init(const hardware_interface::HardwareInfo & info) final;
+
+  KORTEX_DRIVER_PUBLIC
+  std::vector<hardware_interface::StateInterface> export_state_interfaces() final;
+
+  KORTEX_DRIVER_PUBLIC
+  std::vector<hardware_interface::CommandInterface> export_command_interfaces() final;
+
+  KORTEX_DRIVER_PUBLIC
+  return_type prepare_command_mode_switch(
+    const std::vector<std::string> & start_interfaces,
+    const std::vector<std::string> & stop_interfaces) final;
+  KORTEX_DRIVER_PUBLIC
+  return_type perform_command_mode_switch(
+    const std::vector<std::string> & start_interfaces,
+    const std::vector<std::string> & stop_interfaces) final;
+
+  KORTEX_DRIVER_PUBLIC
+  CallbackReturn on_activate(const rclcpp_lifecycle::State & previous_state) final;
+
+  KORTEX_DRIVER_PUBLIC
+  CallbackReturn on_deactivate(const rclcpp_lifecycle::State & previous_state) final;
+
+  KORTEX_DRIVER_PUBLIC
+  return_type read(const rclcpp::Time & time, const rclcpp::Duration & period) final;
+
+  KORTEX_DRIVER_PUBLIC
+  return_type write(const rclcpp::Time & time, const rclcpp::Duration & period) final;
+
+private:
+  static constexpr double NO_CMD = std::numeric_limits<double>::quiet_NaN();
+
+  // Commands sent to the simulated robot, delivered once the cyclic latency has elapsed
+  struct InFlightCommand
+  {
+    std::int64_t sent_ns = 0;
+    bool has_positions = false;
+    std::vector<double> positions;
+    bool has_gripper_position = false;
+    double gripper_position = 0.0;
+  };
+
+  bool injectFailure(double rate);
+  bool lockstep() const { return lockstep_period_ns_ > 0; }
+  void sendCommand(std::int64_t now_ns);
+  void deliverCommands(std::int64_t now_ns);
+  void sendSimCommand(std::int64_t now_ns);
+  void readSimState();
+  // copies the simulated robot into the state interfaces, as a successful exchange does
+  void publishRobotState();
+
+  std::string gripper_joint_name_;
+  std::vector<std::string> arm_joint_names_;
+  std::size_t actuator_count_ = 0;
+
+  // simulation parameters
+  double joint_time_constant_ = 0.02;
+  double gripper_time_constant_ = 0.1;
+  std::int64_t cyclic_latency_ns_ = 0;
+  double cyclic_failure_rate_ = 0.0;
+  double fault_rate_ = 0.0;
+  int mode_switch_latency_ms_ = 200;
+  std::int64_t fault_reset_latency_ns_ = 0;
+  std::int64_t lockstep_period_ns_ = 0;
+  std::mt19937 random_engine_;
+  std::uniform_real_distribution<double> uniform_{0.0, 1.0};
+
+  // the simulated robot, it keeps moving through failed exchanges
+  std::vector<double> robot_positions_;
+  std::vector<double> robot_velocities_;
+  std::vector<double> robot_efforts_;
+  double robot_gripper_position_ = 0.0;
+  double robot_gripper_velocity_ = 0.0;
+
+  // states, the robot as of the last successful exchange
+  std::vector<double> arm_positions_;
+  std::vector<double> arm_velocities_;
+  std::vector<double> arm_efforts_;
+  double gripper_position_ = 0.0;
+  double gripper_velocity_ = 0.0;
+  double in_fault_ = 0.0;
+  CyclicStatistics cyclic_statistics_;
+  TrafficRates tcp_traffic_rates_;
+  TrafficRates udp_traffic_rates_;
+  LatencyPredictionStatistics latency_statistics_;
+  // nothing collides in here, the external efforts and the contact stay at zero
+  std::vector<double> external_efforts_;
+  double contact_ = 0.0;
+  // with dynamics_feedforward, the terms of the model of the robot description at the state
+  // interfaces, NaN otherwise
+  bool dynamics_feedforward_ = false;
+  RigidBodyModel dynamics_model_;
+  DynamicsFeedForward dynamics_feedforward_terms_;
+  JointStateEstimator joint_state_estimator_;
+
+  // commands
+  std::vector<double> arm_commands_positions_;
+  std::vector<double> arm_commands_velocities_;
+  std::vector<double> arm_commands_efforts_;
+  std::vector<double> twist_commands_;
+  double gripper_command_position_ = 0.0;
+  double gripper_speed_command_ = 100.0;
+  double gripper_force_command_ = 100.0;
+  double reset_fault_cmd_ = NO_CMD;
+  double reset_fault_async_success_ = NO_CMD;
+
+  // fixed size ring of commands on their way to the robot, the oldest is overwritten when full
+  std::vector<InFlightCommand> in_flight_;
+  std::size_t in_flight_head_ = 0;
+  std::size_t in_flight_count_ = 0;
+  // what the simulated robot is tracking
+  std::vector<double> target_positions_;
+  double target_gripper_position_ = 0.0;
+
+  // servoing mode and controllers, as in KortexMultiInterfaceHardware
+  bool low_level_servoing_ = true;
+  bool joint_based_controller_running_ = false;
+  bool twist_controller_running_ = false;
+  bool gripper_controller_running_ = false;
+  bool fault_controller_running_ = false;
+  bool start_joint_based_controller_ = false;
+  bool start_twist_controller_ = false;
+  bool start_gripper_controller_ = false;
+  bool start_fault_controller_ = false;
+  bool stop_joint_based_controller_ = false;
+  bool stop_twist_controller_ = false;
+  bool stop_gripper_controller_ = false;
+  bool stop_fault_controller_ = false;
+
+  bool cycle_failed_ = false;
+  std::int64_t fault_reset_done_ns_ = -1;
+
+  // simulated time of the current cycle in lockstep mode, optionally published on /clock
+  std::int64_t lockstep_time_ns_ = 0;
+  rclcpp::Node::SharedPtr clock_node_;
+  rclcpp::Publisher<rosgraph_msgs::msg::Clock>::SharedPtr clock_publisher_;
+  rosgraph_msgs::msg::Clock clock_message_;
+
+  // exchange with an external simulator, the internal model is used while it is not open
+  SimSharedMemory sim_shared_memory_;
+  SimFrame sim_command_;
+  SimFrame sim_state_;
+  std::uint32_t sim_state_sequence_ = 0;
+};
+
+}  // namespace kortex_driver
+
+#endif  // KORTEX_DRIVER__FAKE_HARDWARE_HPP_
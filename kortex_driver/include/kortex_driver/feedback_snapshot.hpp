@@ -0,0 +1,52 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef KORTEX_DRIVER__FEEDBACK_SNAPSHOT_HPP_
+#define KORTEX_DRIVER__FEEDBACK_SNAPSHOT_HPP_
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "BaseCyclicClientRpc.h"
+
+namespace k_api = Kinova::Api;
+
+namespace kortex_driver
+{
+// Fields of the cyclic feedback used by the control loop, extracted into flat arrays once
+// per received frame. Everything else stays in the Feedback message for the consumers
+// that need it.
+struct FeedbackSnapshot
+{
+  std::vector<double> positions;   // rad, wrapped to [-pi, pi]
+  std::vector<double> velocities;  // rad/sec
+  std::vector<double> efforts;     // N*m
+  // sum of the fault banks of the base and of every actuator
+  double faults = 0.0;
+  // fault banks of the base alone
+  double base_faults = 0.0;
+  k_api::Common::ArmState active_state = k_api::Common::ArmState::ARMSTATE_IN_FAULT;
+  // % closed, only decoded when the gripper is on the internal bus
+  double gripper_position = std::numeric_limits<double>::quiet_NaN();
+
+  void resize(std::size_t actuator_count);
+  void decode(const k_api::BaseCyclic::Feedback & feedback, bool with_gripper);
+  // Everything but the joints, when these are exchanged with the actuators directly
+  void decodeBase(const k_api::BaseCyclic::Feedback & feedback, bool with_gripper);
+};
+
+}  // namespace kortex_driver
+
+#endif  // KORTEX_DRIVER__FEEDBACK_SNAPSHOT_HPP_
@@ -26,13 +26,16 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <cstdint>
+#include <future>
 #include <limits>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "rclcpp/clock.hpp"
 #include "rclcpp/macros.hpp"
 #include "rclcpp/time.hpp"
 
@@ -41,10 +44,28 @@
 #include "hardware_interface/system_interface.hpp"
 #include "hardware_interface/types/hardware_interface_return_values.hpp"
 
+#include "kortex_driver/actuator_cyclic_channel.hpp"
+#include "kortex_driver/capture_transport.hpp"
+#include "kortex_driver/collision_detector.hpp"
+#include "kortex_driver/cyclic_frame_codec.hpp"
+#include "kortex_driver/cyclic_retry_policy.hpp"
+#include "kortex_driver/dynamics_feedforward.hpp"
+#include "kortex_driver/feedback_snapshot.hpp"
+#include "kortex_driver/joint_state_estimator.hpp"
+#include "kortex_driver/latency_predictor.hpp"
+#include "kortex_driver/metered_transport.hpp"
+#include "kortex_driver/rigid_body_model.hpp"
+#include "kortex_driver/robot_config_cache.hpp"
+#include "kortex_driver/rt_memory.hpp"
+#include "kortex_driver/rpc_executor.hpp"
+#include "kortex_driver/sim_shared_memory.hpp"
+#include "kortex_driver/udp_realtime_transport.hpp"
 #include "kortex_driver/visibility_control.h"
 
 #include "BaseClientRpc.h"
 #include "BaseCyclicClientRpc.h"
+#include "DeviceConfigClientRpc.h"
+#include "DeviceManagerClientRpc.h"
 #include "RouterClient.h"
 #include "SessionManager.h"
 #include "TransportClientTcp.h"
@@ -115,11 +136,26 @@ public:
 
 private:
   k_api::TransportClientTcp transport_tcp_;
+  std::unique_ptr<CaptureTransport> capture_transport_tcp_;
+  MeteredTransport metered_transport_tcp_;
   k_api::RouterClient router_tcp_;
   k_api::SessionManager session_manager_;
   k_api::TransportClientUdp transport_udp_realtime_;
+  std::unique_ptr<CaptureTransport> capture_transport_udp_realtime_;
+  MeteredTransport metered_transport_udp_realtime_;
   k_api::RouterClient router_udp_realtime_;
+  // replaces transport_udp_realtime_ when udp_transport is not "kortex". Its receive thread
+  // calls into the capture, the metered transport and the router, it is declared after them
+  // so that it is stopped before they are destroyed.
+  std::unique_ptr<k_api::ITransportClient> driver_transport_udp_realtime_;
+  // driver_transport_udp_realtime_ when udp_transport is "driver", for its receive timestamps
+  UdpRealtimeTransport * udp_realtime_transport_ = nullptr;
   k_api::SessionManager session_manager_real_time_;
+  // joints exchanged with each actuator instead of the base while in low level servoing, the
+  // base frame then only refreshes the arm state every actuator_cyclic_base_period_ cycles
+  ActuatorCyclicChannel actuator_cyclic_channel_;
+  int actuator_cyclic_base_period_ = 10;
+  int actuator_cyclic_base_countdown_ = 0;
 
   // twist temporary command
   Kinova::Api::Base::Twist * k_api_twist_;
@@ -129,9 +165,31 @@ private:
   k_api::Base::BaseClient base_;
   k_api::BaseCyclic::BaseCyclicClient base_cyclic_;
   k_api::BaseCyclic::Command base_command_;
+  // actuator commands of base_command_, laid out once in on_activate() and patched every cycle
+  std::vector<k_api::BaseCyclic::ActuatorCommand *> actuator_commands_;
+  // base_command_ encoded once and patched in place, sent through router_udp_realtime_ instead
+  // of base_cyclic_ once it is known to encode the same message
+  bool cyclic_preencoded_command_ = true;
+  bool use_command_encoder_ = false;
+  CyclicCommandEncoder command_encoder_;
+  // the frames received by router_udp_realtime_ are decoded straight into feedback_snapshot_,
+  // feedback_ is then only parsed when feedback() is called
+  bool use_feedback_decoder_ = false;
+  CyclicFeedbackDecoder feedback_decoder_;
+  // last exchange of router_udp_realtime_, kept until the next one so that releasing them
+  // happens where allocations are allowed
+  std::future<k_api::Frame> cyclic_reply_;
+  k_api::Frame cyclic_frame_;
+  // last frame decoded by feedback_decoder_, swapped with cyclic_frame_ so that it outlives a
+  // failed exchange
+  k_api::Frame feedback_frame_;
+  bool feedback_parsed_ = true;
+  std::uint32_t frame_id_ = 0;
   std::size_t actuator_count_;
   // To minimize bandwidth we synchronize feedback with the robot only when write() is called
   k_api::BaseCyclic::Feedback feedback_;
+  // fields of feedback_ used by read() and write(), extracted once per received frame
+  FeedbackSnapshot feedback_snapshot_;
   std::vector<double> arm_commands_positions_;
   std::vector<double> arm_commands_velocities_;
   std::vector<double> arm_commands_efforts_;
@@ -202,18 +260,119 @@ private:
   // temp variables to use in update loop
   float cmd_degrees_tmp_;
   float cmd_vel_tmp_;
-  int num_turns_tmp_ = 0;
 
-  // fault control
-  double reset_fault_cmd_;
-  double reset_fault_async_success_;
-  double in_fault_;
+  // fault control, no command until the fault controller writes one
   static constexpr double NO_CMD = std::numeric_limits<double>::quiet_NaN();
+  double reset_fault_cmd_ = NO_CMD;
+  double reset_fault_async_success_ = NO_CMD;
+  double in_fault_;
 
+  // bounded retry on the cyclic channel and its per-error counters
+  CyclicRetryPolicy cyclic_retry_policy_;
+  CyclicStatistics cyclic_statistics_;
+  rclcpp::Clock steady_clock_{RCL_STEADY_TIME};
+
+  // keep-alive rate while no joint, twist or gripper controller is running, zero refreshes
+  // every cycle
+  std::int64_t idle_refresh_period_ns_ = 0;
+  std::int64_t last_cyclic_refresh_ns_ = 0;
+  bool idle_cycle_skipped_ = false;
+
+  // rolling throughput of the rpc (tcp) and cyclic (udp) channels
+  TrafficRates tcp_traffic_rates_;
+  TrafficRates udp_traffic_rates_;
+  double traffic_stats_window_ = 1.0;
+
+  // filtered joint states, acceleration included, computed once per cycle for all controllers
+  JointStateEstimator joint_state_estimator_;
+  // extrapolation of the joint states over the cyclic delay
+  LatencyPredictor latency_predictor_;
+
+  // rigid body model of the arm, only loaded when collision detection or feed-forward need it
+  RigidBodyModel dynamics_model_;
+  bool dynamics_feedforward_ = false;
+  DynamicsFeedForward dynamics_feedforward_terms_;
+  // momentum observer on the measured joint torques, the reflex holds the arm where the contact
+  // was detected until the next fault reset
+  bool collision_detection_ = false;
+  bool collision_reflex_ = false;
+  bool collision_reflex_active_ = false;
+  CollisionDetector collision_detector_;
+  std::vector<double> reflex_hold_positions_;
+
+  // joint commands of a co-located process, Servo for instance, through the layout of the
+  // simulator exchange with the roles swapped: the driver reads the command slot and writes the
+  // state slot. A fresh frame within the joint limits overrides the commands of the running joint
+  // controller, approached at a bounded velocity. Its positions stay held after the frames stop
+  // until that controller is switched.
+  SimSharedMemory command_shared_memory_;
+  SimFrame shared_command_;
+  SimFrame shared_state_;
+  std::uint32_t shared_command_sequence_ = 0;
+  std::int64_t shared_command_timeout_ns_ = 0;
+  std::int64_t shared_command_received_ns_ = 0;
+  bool shared_command_active_ = false;
+  std::vector<double> shared_command_positions_;
+  std::vector<double> shared_command_velocities_;
+  std::vector<double> shared_command_lower_limits_;
+  std::vector<double> shared_command_upper_limits_;
+  double shared_command_max_velocity_ = 1.0;
+
+  // latest values for the rpc executor, a newer command overwrites one not sent yet
+  std::array<std::atomic<float>, 6> twist_mailbox_{};
+  std::atomic<bool> twist_pending_{false};
+  std::atomic<float> gripper_mailbox_{0.0f};
+  std::atomic<bool> gripper_pending_{false};
+  // -1 while no fault reset completed, then 0 on failure and 1 on success
+  std::atomic<int> reset_fault_result_{-1};
+  std::atomic<bool> reset_fault_pending_{false};
+  // servoing mode of the last controller switch, set on the executor. The result holds the
+  // number of the request it completed shifted left by one, and 1 in the low bit on success.
+  k_api::Base::ServoingMode requested_arm_mode_;
+  bool servoing_mode_pending_ = false;
+  std::uint32_t servoing_mode_request_ = 0;
+  std::atomic<std::uint64_t> servoing_mode_result_{0};
+  // the last request failed, reported on internal_fault until a fault reset sets the mode
+  bool servoing_mode_failed_ = false;
+
+  // memory preparation done on activation, the stack of the control thread on its first read
+  bool rt_lock_memory_ = false;
+  std::size_t rt_prefault_heap_size_ = 0;
+  std::size_t rt_prefault_stack_size_ = 0;
+  bool rt_stack_prefaulted_ = false;
+
+  // static configuration of the robot, from the cache when serial number and firmware match
+  RobotConfiguration robot_configuration_;
+
+  // runs every blocking call on the tcp router, declared last to be stopped first
+  RpcExecutor rpc_executor_;
+
+  bool motionControllerRunning() const;
+  void requestServoingMode(k_api::Base::ServoingMode mode);
+  bool confirmServoingMode();
+  void setServoingMode(k_api::Base::ServoingMode mode, std::uint32_t request);
   void sendTwistCommand();
+  void sendPendingTwist();
+  void sendPendingGripperCommand();
+  void resetFaults(k_api::Base::ServoingMode arm_mode);
+  void queryRobotConfiguration(
+    RobotConfiguration & configuration, bool query_devices, bool query_gripper);
+  // the joints of the ros2_control tag but the gripper, one per actuator
+  bool armJointNames(std::vector<std::string> & joint_names) const;
+  bool loadDynamicsModel();
   void incrementId();
   void sendJointCommands();
+  void sendActuatorCommands();
+  CyclicError exchangeCyclic(bool send_command);
+  CyclicError exchangeEncoded(bool send_command, const k_api::RouterClientSendOptions & options);
+  // the whole last valid feedback. On the decoder path it is parsed from feedback_frame_ on the
+  // first call after each frame, which allocates.
+  const k_api::BaseCyclic::Feedback & feedback();
+  bool refreshCyclic(bool send_command);
   void prepareCommands();
+  bool validSharedCommand() const;
+  void applySharedCommand(double period);
+  void writeSharedState();
   void sendGripperCommand(
     k_api::Base::ServoingMode arm_mode, double position, double velocity, double force);
 
@@ -0,0 +1,58 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef KORTEX_DRIVER__HARDWARE_PARAMETERS_HPP_
+#define KORTEX_DRIVER__HARDWARE_PARAMETERS_HPP_
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "hardware_interface/hardware_info.hpp"
+
+namespace kortex_driver
+{
+inline bool isTrue(const std::string & value) { return value == "true" || value == "True"; }
+
+// Value of an optional hardware parameter, default_value when it is absent or empty
+inline std::string getOptionalParameter(
+  const hardware_interface::HardwareInfo & info, const std::string & name,
+  const std::string & default_value)
+{
+  const auto it = info.hardware_parameters.find(name);
+  if (it == info.hardware_parameters.end() || it->second.empty())
+  {
+    return default_value;
+  }
+  return it->second;
+}
+
+// Numbers of a list parameter, separated by spaces or commas
+inline std::vector<double> parseDoubles(std::string value)
+{
+  std::replace(value.begin(), value.end(), ',', ' ');
+  std::istringstream stream(value);
+  std::vector<double> numbers;
+  double number = 0.0;
+  while (stream >> number)
+  {
+    numbers.push_back(number);
+  }
+  return numbers;
+}
+
+}  // namespace kortex_driver
+
+#endif  // KORTEX_DRIVER__HARDWARE_PARAMETERS_HPP_
@@ -0,0 +1,163 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef KORTEX_DRIVER__IO_URING_TRANSPORT_HPP_
+#define KORTEX_DRIVER__IO_URING_TRANSPORT_HPP_
+
+#include <liburing.h>
+#include <sys/uio.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ITransportClient.h"
+
+namespace k_api = Kinova::Api;
+
+namespace kortex_driver
+{
+struct IoUringOptions
+{
+  // submission queue depth of the ring
+  unsigned entries = 64;
+  // let a kernel thread poll the submission queues, sends then need no syscall at all
+  bool sqpoll = false;
+  // number of sockets (arms) the ring has registered buffers for
+  std::size_t max_sockets = 8;
+
+  bool operator==(const IoUringOptions & other) const
+  {
+    return entries == other.entries && sqpoll == other.sqpoll && max_sockets == other.max_sockets;
+  }
+};
+
+// One io_uring shared by every transport of the process for receiving. The receive buffers of
+// all sockets are registered with the ring once, a single thread reaps the completions of
+// every socket and dispatches the received frames to the owning transport.
+class IoUringReactor
+{
+public:
+  using ReceiveCallback = std::function<void(const char *, uint32_t)>;
+
+  // Reactor shared by the process, created with options by the first caller. Later callers
+  // asking for other options get a warning and the existing reactor.
+  // Returns nullptr when the ring could not be set up.
+  static std::shared_ptr<IoUringReactor> shared(const IoUringOptions & options);
+
+  ~IoUringReactor();
+
+  // Start receiving on a connected datagram socket, returns the slot of the socket or -1
+  int attach(int fd, ReceiveCallback callback);
+  // Stop receiving, the socket can be closed once this returns
+  void detach(int slot);
+
+  const IoUringOptions & options() const { return options_; }
+  // send rings attach to it to share the submission queue poller thread
+  int ringFd() const { return ring_.ring_fd; }
+
+  static constexpr std::size_t MAX_FRAME_SIZE = 65507;
+
+private:
+
+  enum class SlotState : std::uint8_t
+  {
+    FREE = 0,
+    ACTIVE = 1,
+    CLOSING = 2
+  };
+
+  struct Slot
+  {
+    int fd = -1;
+    SlotState state = SlotState::FREE;
+    std::uint32_t generation = 0;
+    ReceiveCallback callback;
+  };
+
+  explicit IoUringReactor(const IoUringOptions & options);
+  bool initialize();
+  // requires mutex_ to be held
+  bool armReceive(std::size_t slot);
+  char * buffer(std::size_t index) { return &buffers_[index * MAX_FRAME_SIZE]; }
+  void run();
+  void handleCompletion(std::uint64_t user_data, int result);
+
+  IoUringOptions options_;
+  io_uring ring_;
+  bool ring_initialized_ = false;
+  std::vector<char> buffers_;
+  std::vector<iovec> iovecs_;
+  std::vector<Slot> slots_;
+  // taken by attach(), detach() and the reactor thread, never by the control thread
+  std::mutex mutex_;
+  std::condition_variable slot_freed_;
+  std::atomic<bool> running_{false};
+  std::thread thread_;
+};
+
+// Datagram transport for the realtime router receiving through the shared IoUringReactor.
+// With sqpoll, sends go through a ring of the transport alone, so that the control thread
+// submits without a lock and without a syscall. Without it a send costs a syscall either way
+// and a plain send() is used.
+class IoUringUdpTransport : public k_api::ITransportClient
+{
+public:
+  explicit IoUringUdpTransport(std::shared_ptr<IoUringReactor> reactor);
+  ~IoUringUdpTransport() override;
+
+  bool connect(std::string host, uint32_t port) override;
+  void disconnect() override;
+  void send(const char * tx_buffer, uint32_t tx_size) override;
+  void onMessage(std::function<void(const char *, uint32_t)> callback) override;
+  char * getTxBuffer() override;
+  size_t getMaxTxBufferSize() override;
+
+  // send() is called on the control thread, its failures are counted instead of logged
+  std::uint64_t sendFailures() const { return send_failures_.load(std::memory_order_relaxed); }
+
+private:
+  static constexpr std::uint32_t TX_DEPTH = 4;
+  static constexpr std::size_t MAX_FRAME_SIZE = IoUringReactor::MAX_FRAME_SIZE;
+
+  bool initializeSendRing();
+  void reapSendCompletions();
+  char * sendBuffer(std::uint32_t index) { return &send_buffers_[index * MAX_FRAME_SIZE]; }
+
+  std::shared_ptr<IoUringReactor> reactor_;
+  int socket_ = -1;
+  int slot_ = -1;
+  std::function<void(const char *, uint32_t)> callback_;
+  std::vector<char> tx_buffer_;
+
+  // only used by the thread calling send()
+  io_uring send_ring_;
+  bool send_ring_initialized_ = false;
+  std::vector<char> send_buffers_;
+  std::vector<iovec> send_iovecs_;
+  std::uint32_t next_tx_ = 0;
+  std::uint32_t tx_in_flight_ = 0;
+  std::atomic<std::uint64_t> send_failures_{0};
+};
+
+}  // namespace kortex_driver
+
+#endif  // KORTEX_DRIVER__IO_URING_TRANSPORT_HPP_
@@ -0,0 +1,56 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef KORTEX_DRIVER__JOINT_STATE_ESTIMATOR_HPP_
+#define KORTEX_DRIVER__JOINT_STATE_ESTIMATOR_HPP_
+
+#include <cstddef>
+#include <vector>
+
+namespace kortex_driver
+{
+// Alpha-beta-gamma tracker of each joint, fed with the measured positions once per cycle.
+// The gains are those of the critically damped fading memory filter, set by a single
+// discount factor in [0, 1): zero follows the measurements, closer to one smooths more.
+class JointStateEstimator
+{
+public:
+  // Allocates the estimates, not real-time safe
+  void configure(std::size_t joint_count, double discount);
+  // The next update starts again from its measurements
+  void reset();
+
+  // Positions are wrapped to [-pi, pi], velocities only seed the estimate after a reset
+  void update(
+    const std::vector<double> & positions, const std::vector<double> & velocities, double dt);
+
+  // stable for the lifetime of the estimator, exported as state interfaces
+  std::vector<double> & positions() { return positions_; }
+  std::vector<double> & velocities() { return velocities_; }
+  std::vector<double> & accelerations() { return accelerations_; }
+
+private:
+  double alpha_ = 1.0;
+  double beta_ = 0.0;
+  double gamma_ = 0.0;
+  bool initialized_ = false;
+
+  std::vector<double> positions_;
+  std::vector<double> velocities_;
+  std::vector<double> accelerations_;
+};
+
+}  // namespace kortex_driver
+
+#endif  // KORTEX_DRIVER__JOINT_STATE_ESTIMATOR_HPP_
@@ -0,0 +1,94 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef KORTEX_DRIVER__LATENCY_PREDICTOR_HPP_
+#define KORTEX_DRIVER__LATENCY_PREDICTOR_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace kortex_driver
+{
+// Doubles so they can be exported directly as state interfaces
+struct LatencyPredictionStatistics
+{
+  // measured delay between the sampling of a frame and the arrival of the command based on it, s
+  double horizon = 0.0;
+  // largest joint error of each checked prediction, rms over the smoothing window and max, rad
+  double error_rms = 0.0;
+  double error_max = 0.0;
+  double checked_predictions = 0.0;
+
+  void reset();
+};
+
+// Compensation of the cyclic delay in the spirit of a Smith predictor. A frame is sampled on
+// the robot about half a round trip before the driver receives it, the controllers compute a
+// command from it on the next cycle, and that command reaches the actuators half a round trip
+// after it is sent. Joint states are extrapolated over this horizon before the controllers see
+// them, so that their commands are computed for the state the arm is in when they apply.
+// Every prediction is checked against the frame later sampled at the time it aimed for.
+class LatencyPredictor
+{
+public:
+  // Allocates the buffers, not real-time safe. smoothing is the weight of a new sample in the
+  // running averages of the horizon, of the acceleration and of the error.
+  void configure(std::size_t joint_count, bool enabled, double max_horizon, double smoothing);
+  void reset();
+
+  // Timing of a successful cyclic exchange on the steady clock, a horizon is only measured
+  // when the exchange carried a command
+  void recordExchange(std::int64_t request_ns, std::int64_t response_ns, bool sent_command);
+
+  // Replaces the measured states of the last received frame by their prediction, does
+  // nothing while disabled
+  void predict(std::vector<double> & positions, std::vector<double> & velocities);
+
+  bool enabled() const { return enabled_; }
+  LatencyPredictionStatistics & statistics() { return statistics_; }
+
+private:
+  struct Prediction
+  {
+    std::int64_t target_ns = 0;
+    std::vector<double> positions;
+  };
+
+  void checkPredictions(const std::vector<double> & positions);
+
+  bool enabled_ = false;
+  double max_horizon_ = 0.0;
+  double smoothing_ = 0.1;
+  LatencyPredictionStatistics statistics_;
+  double error_mean_square_ = 0.0;
+
+  // estimated sampling time of the last received frame, and when it was received
+  std::int64_t sample_ns_ = -1;
+  std::int64_t previous_response_ns_ = -1;
+  // sampling time of the frame the states were last predicted from
+  std::int64_t predicted_sample_ns_ = -1;
+
+  std::vector<double> previous_velocities_;
+  std::vector<double> accelerations_;
+
+  // fixed size ring of predictions waiting for the frame sampled at their target time
+  std::vector<Prediction> pending_;
+  std::size_t pending_head_ = 0;
+  std::size_t pending_count_ = 0;
+};
+
+}  // namespace kortex_driver
+
+#endif  // KORTEX_DRIVER__LATENCY_PREDICTOR_HPP_
@@ -0,0 +1,93 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef KORTEX_DRIVER__METERED_TRANSPORT_HPP_
+#define KORTEX_DRIVER__METERED_TRANSPORT_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "ITransportClient.h"
+
+namespace k_api = Kinova::Api;
+
+namespace kortex_driver
+{
+struct TrafficCounters
+{
+  std::uint64_t tx_bytes = 0;
+  std::uint64_t tx_packets = 0;
+  std::uint64_t rx_bytes = 0;
+  std::uint64_t rx_packets = 0;
+};
+
+// Transport decorator counting the frames going through the wrapped transport.
+// send() is called from the thread using the router, the receive callback from the
+// transport's own thread, hence the atomic counters.
+// The wrapped transport can be replaced before connecting, which lets the router be built
+// in the hardware interface constructor while the transport is selected in on_init().
+class MeteredTransport : public k_api::ITransportClient
+{
+public:
+  explicit MeteredTransport(k_api::ITransportClient * transport);
+
+  bool connect(std::string host, uint32_t port) override;
+  void disconnect() override;
+  void send(const char * tx_buffer, uint32_t tx_size) override;
+  void onMessage(std::function<void(const char *, uint32_t)> callback) override;
+  char * getTxBuffer() override;
+  size_t getMaxTxBufferSize() override;
+
+  TrafficCounters counters() const;
+
+  // Must be called while disconnected, the router's receive callback is moved over
+  void setTransport(k_api::ITransportClient * transport);
+
+private:
+  void registerCallback();
+
+  k_api::ITransportClient * transport_;
+  std::function<void(const char *, uint32_t)> callback_;
+  std::atomic<std::uint64_t> tx_bytes_{0};
+  std::atomic<std::uint64_t> tx_packets_{0};
+  std::atomic<std::uint64_t> rx_bytes_{0};
+  std::atomic<std::uint64_t> rx_packets_{0};
+};
+
+// Rolling throughput of one channel, averaged over a fixed window.
+// Rates are doubles so they can be exported directly as state interfaces.
+struct TrafficRates
+{
+  double tx_bytes_per_second = 0.0;
+  double rx_bytes_per_second = 0.0;
+  double tx_packets_per_second = 0.0;
+  double rx_packets_per_second = 0.0;
+  double tx_packets_per_cycle = 0.0;
+
+  // Accumulate one cycle, the rates are refreshed each time window_seconds have elapsed
+  void update(const TrafficCounters & counters, double period_seconds, double window_seconds);
+
+private:
+  TrafficCounters window_start_;
+  double window_elapsed_ = 0.0;
+  std::uint64_t window_cycles_ = 0;
+  bool started_ = false;
+};
+
+}  // namespace kortex_driver
+
+#endif  // KORTEX_DRIVER__METERED_TRANSPORT_HPP_
@@ -0,0 +1,106 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef KORTEX_DRIVER__RIGID_BODY_MODEL_HPP_
+#define KORTEX_DRIVER__RIGID_BODY_MODEL_HPP_
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+namespace kortex_driver
+{
+// Dynamics of a serial chain of revolute joints, evaluated with the recursive Newton-Euler and
+// composite rigid body algorithms. Every vector and matrix has a fixed capacity so that no
+// evaluation allocates. Chains whose joints all turn about their z axis, as every Kinova arm
+// does, take a faster path for the joint rotations.
+class RigidBodyModel
+{
+public:
+  static constexpr int MAX_JOINTS = 8;
+  using JointVector = Eigen::Matrix<double, Eigen::Dynamic, 1, 0, MAX_JOINTS, 1>;
+  using JointMatrix =
+    Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, 0, MAX_JOINTS, MAX_JOINTS>;
+
+  // Moving body of a joint, with everything rigidly attached to it, in the frame of the joint
+  struct Body
+  {
+    // pose of the joint frame in the frame of the previous body, at zero joint position
+    Eigen::Matrix3d rotation = Eigen::Matrix3d::Identity();
+    Eigen::Vector3d translation = Eigen::Vector3d::Zero();
+    // unit rotation axis in the joint frame
+    Eigen::Vector3d axis = Eigen::Vector3d::UnitZ();
+    double mass = 0.0;
+    Eigen::Vector3d center_of_mass = Eigen::Vector3d::Zero();
+    // about the center of mass
+    Eigen::Matrix3d inertia = Eigen::Matrix3d::Zero();
+  };
+
+  // Builds the chain of joint_names, in order from the base, out of a URDF. Links fixed to a
+  // body are merged into it, and so is everything after the last joint (gripper fingers at
+  // their zero position included). gravity is expressed in the parent link of the first joint.
+  bool loadUrdf(
+    const std::string & urdf, const std::vector<std::string> & joint_names,
+    const Eigen::Vector3d & gravity);
+
+  void setBodies(const std::vector<Body> & bodies, const Eigen::Vector3d & gravity);
+
+  int jointCount() const { return joint_count_; }
+
+  // Joint torques producing the accelerations qdd at (q, qd), gravity included on request
+  void inverseDynamics(
+    const JointVector & q, const JointVector & qd, const JointVector & qdd, bool with_gravity,
+    JointVector & tau);
+  // Static torques, from the composite inertias instead of a full inverse dynamics pass
+  void gravityTorques(const JointVector & q, JointVector & tau);
+  // Coriolis and centrifugal torques C(q, qd) qd
+  void coriolisTorques(const JointVector & q, const JointVector & qd, JointVector & tau);
+  // Joint space inertia
+  void massMatrix(const JointVector & q, JointMatrix & mass_matrix);
+  void massMatrixDiagonal(const JointVector & q, JointVector & diagonal);
+
+private:
+  void updateRotations(const JointVector & q);
+  // Mass, first moment and inertia of every body with all its descendants, about the joint
+  // origin and in the joint frame. Needs the rotations of q.
+  void updateComposites();
+
+  std::array<Body, MAX_JOINTS> bodies_;
+  int joint_count_ = 0;
+  bool z_axes_ = false;
+  Eigen::Vector3d gravity_ = Eigen::Vector3d(0.0, 0.0, -9.81);
+  // constant per body mass properties about the joint origin
+  std::array<Eigen::Vector3d, MAX_JOINTS> first_moments_;
+  std::array<Eigen::Matrix3d, MAX_JOINTS> origin_inertias_;
+
+  // per body workspace of the recursion
+  std::array<Eigen::Matrix3d, MAX_JOINTS> rotations_;
+  std::array<Eigen::Vector3d, MAX_JOINTS> angular_velocities_;
+  std::array<Eigen::Vector3d, MAX_JOINTS> angular_accelerations_;
+  std::array<Eigen::Vector3d, MAX_JOINTS> linear_accelerations_;
+  std::array<Eigen::Vector3d, MAX_JOINTS> forces_;
+  std::array<Eigen::Vector3d, MAX_JOINTS> torques_;
+  std::array<double, MAX_JOINTS> composite_masses_;
+  std::array<Eigen::Vector3d, MAX_JOINTS> composite_moments_;
+  std::array<Eigen::Matrix3d, MAX_JOINTS> composite_inertias_;
+  JointVector zero_;
+};
+
+}  // namespace kortex_driver
+
+#endif  // KORTEX_DRIVER__RIGID_BODY_MODEL_HPP_
@@ -0,0 +1,68 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef KORTEX_DRIVER__ROBOT_CONFIG_CACHE_HPP_
+#define KORTEX_DRIVER__ROBOT_CONFIG_CACHE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace kortex_driver
+{
+// Static information about the robot, it only changes with the hardware or the firmware
+struct RobotConfiguration
+{
+  struct Device
+  {
+    std::uint32_t type = 0;
+    std::uint32_t identifier = 0;
+    std::uint32_t order = 0;
+  };
+
+  std::string serial_number;
+  std::uint32_t firmware_version = 0;
+  std::size_t actuator_count = 0;
+  // only queried with actuator_cyclic or for the cache
+  std::vector<Device> devices;
+  // only queried with use_internal_bus_gripper_comm or for the cache
+  bool gripper_installed = false;
+};
+
+// Stores one RobotConfiguration per robot in a directory, so that restarts only need to read
+// the serial number and the firmware version to know if the robot is still the same.
+class RobotConfigCache
+{
+public:
+  explicit RobotConfigCache(std::string directory);
+
+  // False if there is no entry for this robot or if it was written for another firmware
+  bool load(
+    const std::string & serial_number, std::uint32_t firmware_version,
+    RobotConfiguration & configuration) const;
+  bool store(const RobotConfiguration & configuration) const;
+
+  std::string path(const std::string & serial_number) const;
+
+  // $ROS_HOME/kortex_driver, ~/.ros/kortex_driver when ROS_HOME is not set
+  static std::string defaultDirectory();
+
+private:
+  std::string directory_;
+};
+
+}  // namespace kortex_driver
+
+#endif  // KORTEX_DRIVER__ROBOT_CONFIG_CACHE_HPP_
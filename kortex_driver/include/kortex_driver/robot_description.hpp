@@ -0,0 +1,56 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef KORTEX_DRIVER__ROBOT_DESCRIPTION_HPP_
+#define KORTEX_DRIVER__ROBOT_DESCRIPTION_HPP_
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "kortex_driver/rigid_body_model.hpp"
+
+#include "hardware_interface/hardware_info.hpp"
+
+namespace kortex_driver
+{
+// The hardware info only holds the ros2_control tag, these get the full URDF for the
+// components that need the dynamics of the robot
+namespace RobotDescription
+{
+bool readFile(const std::string & path, std::string & urdf);
+
+// Waits for the latched description published by robot_state_publisher
+bool waitForTopic(
+  const std::string & topic, std::chrono::milliseconds timeout, std::string & urdf);
+
+// The description given by the robot_description_file or robot_description_timeout_ms
+// parameters
+bool load(const hardware_interface::HardwareInfo & info, std::string & urdf);
+
+// Loads the arm joints of that description and the dynamics_gravity parameter into model
+bool loadModel(
+  const hardware_interface::HardwareInfo & info, const std::vector<std::string> & joint_names,
+  RigidBodyModel & model);
+
+// Position limits of the joints in that description, infinite for continuous joints
+bool loadPositionLimits(
+  const hardware_interface::HardwareInfo & info, const std::vector<std::string> & joint_names,
+  std::vector<double> & lower, std::vector<double> & upper);
+
+}  // namespace RobotDescription
+
+}  // namespace kortex_driver
+
+#endif  // KORTEX_DRIVER__ROBOT_DESCRIPTION_HPP_
@@ -0,0 +1,96 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef KORTEX_DRIVER__RPC_EXECUTOR_HPP_
+#define KORTEX_DRIVER__RPC_EXECUTOR_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <thread>
+#include <utility>
+
+namespace kortex_driver
+{
+// Single thread running every call on the TCP router, so that the control loop never waits
+// for an RPC round trip. Tasks are submitted through a bounded lock-free queue.
+class RpcExecutor
+{
+public:
+  using Task = std::function<void()>;
+
+  explicit RpcExecutor(std::size_t capacity = 64);
+  ~RpcExecutor();
+
+  void start();
+  void stop();
+
+  // Never blocks, returns false when the queue is full. Tasks posted from the control loop
+  // should only capture a pointer or two so that std::function does not allocate. The
+  // executor is woken through an eventfd, only when it sleeps, without taking any lock.
+  bool post(Task task);
+
+  // Runs function on the executor thread and waits for its result, exceptions are rethrown
+  // in the caller. Must not be called from the control loop nor from the executor itself.
+  template <typename Function>
+  auto call(Function && function) -> decltype(function())
+  {
+    using Result = decltype(function());
+    if (!running_)
+    {
+      return function();
+    }
+    auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(function));
+    std::future<Result> result = task->get_future();
+    while (!post([task]() { (*task)(); }))
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return result.get();
+  }
+
+  std::uint64_t rejectedTasks() const { return rejected_.load(std::memory_order_relaxed); }
+
+private:
+  struct Cell
+  {
+    std::atomic<std::size_t> sequence;
+    Task task;
+  };
+
+  bool pop(Task & task);
+  void run();
+
+  std::size_t mask_;
+  std::unique_ptr<Cell[]> cells_;
+  std::atomic<std::size_t> enqueue_position_{0};
+  std::size_t dequeue_position_ = 0;
+  std::atomic<std::uint64_t> rejected_{0};
+
+  std::atomic<bool> running_{false};
+  // set by the executor before it waits on wake_fd_
+  std::atomic<bool> sleeping_{false};
+  int wake_fd_ = -1;
+  std::thread thread_;
+
+  void wake();
+};
+
+}  // namespace kortex_driver
+
+#endif  // KORTEX_DRIVER__RPC_EXECUTOR_HPP_
@@ -0,0 +1,41 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef KORTEX_DRIVER__RT_MEMORY_HPP_
+#define KORTEX_DRIVER__RT_MEMORY_HPP_
+
+#include <cstddef>
+
+namespace kortex_driver
+{
+// Helpers moving page faults out of the control loop and into activation
+namespace RtMemory
+{
+// Locks current and future pages of the process into RAM and stops the allocator from giving
+// memory back to the system, so that freed blocks stay resident for the next allocation.
+// Fails without RLIMIT_MEMLOCK or CAP_IPC_LOCK.
+bool lockMemory();
+
+// Grows the heap by size bytes and touches every page of it, the memory is freed again but
+// stays mapped (and locked) in the allocator
+void prefaultHeap(std::size_t size);
+
+// Touches size bytes of the stack of the calling thread
+void prefaultStack(std::size_t size);
+
+}  // namespace RtMemory
+
+}  // namespace kortex_driver
+
+#endif  // KORTEX_DRIVER__RT_MEMORY_HPP_
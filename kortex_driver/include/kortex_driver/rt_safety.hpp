@@ -0,0 +1,92 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef KORTEX_DRIVER__RT_SAFETY_HPP_
+#define KORTEX_DRIVER__RT_SAFETY_HPP_
+
+// Markers for the real-time safety checker. The checker itself is the kortex_rt_checker
+// library, preloaded into the process with LD_PRELOAD. It only looks at code between
+// KORTEX_RT_SECTION and the end of its scope, KORTEX_RT_ALLOW suspends it for calls that are
+// known to allocate (the Kortex API). Without KORTEX_DRIVER_RT_CHECKS the markers compile to
+// nothing.
+
+#ifdef KORTEX_DRIVER_RT_CHECKS
+
+extern "C" {
+// defined by kortex_rt_checker, null when it is not preloaded
+void kortex_rt_checker_enter(const char * section) __attribute__((weak));
+void kortex_rt_checker_leave() __attribute__((weak));
+void kortex_rt_checker_allow(int allow) __attribute__((weak));
+}
+
+namespace kortex_driver
+{
+namespace RtSafety
+{
+class Section
+{
+public:
+  explicit Section(const char * name)
+  {
+    if (kortex_rt_checker_enter)
+    {
+      kortex_rt_checker_enter(name);
+    }
+  }
+  ~Section()
+  {
+    if (kortex_rt_checker_leave)
+    {
+      kortex_rt_checker_leave();
+    }
+  }
+  Section(const Section &) = delete;
+  Section & operator=(const Section &) = delete;
+};
+
+class Allow
+{
+public:
+  Allow()
+  {
+    if (kortex_rt_checker_allow)
+    {
+      kortex_rt_checker_allow(1);
+    }
+  }
+  ~Allow()
+  {
+    if (kortex_rt_checker_allow)
+    {
+      kortex_rt_checker_allow(0);
+    }
+  }
+  Allow(const Allow &) = delete;
+  Allow & operator=(const Allow &) = delete;
+};
+
+}  // namespace RtSafety
+}  // namespace kortex_driver
+
+#define KORTEX_RT_SECTION(name) const kortex_driver::RtSafety::Section kortex_rt_section_(name)
+#define KORTEX_RT_ALLOW() const kortex_driver::RtSafety::Allow kortex_rt_allow_
+
+#else
+
+#define KORTEX_RT_SECTION(name)
+#define KORTEX_RT_ALLOW()
+
+#endif  // KORTEX_DRIVER_RT_CHECKS
+
+#endif  // KORTEX_DRIVER__RT_SAFETY_HPP_
@@ -0,0 +1,107 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef KORTEX_DRIVER__SIM_SHARED_MEMORY_HPP_
+#define KORTEX_DRIVER__SIM_SHARED_MEMORY_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace kortex_driver
+{
+constexpr std::uint32_t SIM_SHARED_MEMORY_MAGIC = 0x4d49534b;  // "KSIM" in little endian
+constexpr std::uint32_t SIM_SHARED_MEMORY_VERSION = 1;
+constexpr std::size_t SIM_MAX_JOINTS = 8;
+
+// One snapshot of the arm and gripper. In the command slot positions are the targets and
+// velocities the feed forward, efforts are unused.
+struct SimFrame
+{
+  std::uint64_t stamp_ns = 0;
+  double gripper_position = 0.0;
+  double gripper_velocity = 0.0;
+  double positions[SIM_MAX_JOINTS] = {};
+  double velocities[SIM_MAX_JOINTS] = {};
+  double efforts[SIM_MAX_JOINTS] = {};
+};
+
+// Latest value slot guarded by a sequence lock, the sequence is odd while the writer is busy.
+// Readers never block the writer, they retry when the sequence moved during their copy.
+struct alignas(64) SimFrameSlot
+{
+  std::atomic<std::uint32_t> sequence;
+  std::uint32_t reserved;
+  SimFrame frame;
+};
+
+// Layout of the shared memory segment, the simulator side maps the same struct. All fields are
+// little endian with natural alignment, so that it can be read from python with mmap as well.
+struct SimSharedMemoryLayout
+{
+  std::uint32_t magic;
+  std::uint32_t version;
+  std::uint32_t joint_count;
+  std::uint32_t reserved;
+  // written by the side sending joint commands, the driver when it talks to a simulator
+  SimFrameSlot command;
+  // written by the side owning the arm, the simulator or the driver of a real arm
+  SimFrameSlot state;
+};
+
+// the sequence lock needs an address free atomic to work across processes
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "std::atomic<std::uint32_t> is not lock free");
+
+// POSIX shared memory segment exchanging joint commands and states with a co-located
+// simulator, or with a co-located command source such as Servo. Only the latest frame in each
+// direction matters for position control, so a newer frame replaces one that was not read yet
+// instead of queueing behind it.
+class SimSharedMemory
+{
+public:
+  SimSharedMemory() = default;
+  ~SimSharedMemory();
+  SimSharedMemory(const SimSharedMemory &) = delete;
+  SimSharedMemory & operator=(const SimSharedMemory &) = delete;
+
+  // Maps the segment called name, creating and initializing it if needed. Whichever side
+  // comes first creates it, an existing segment must have been made for joint_count joints.
+  bool open(const std::string & name, std::size_t joint_count);
+  void close();
+  bool isOpen() const { return layout_ != nullptr; }
+
+  void writeCommand(const SimFrame & frame) { write(layout_->command, frame); }
+  void writeState(const SimFrame & frame) { write(layout_->state, frame); }
+  // Copy out the latest frame, false if none was ever written or the writer kept overwriting
+  // it. sequence is set to the one of the frame, which tells a new frame from an old one.
+  bool readCommand(SimFrame & frame, std::uint32_t & sequence) const
+  {
+    return read(layout_->command, frame, sequence);
+  }
+  bool readState(SimFrame & frame, std::uint32_t & sequence) const
+  {
+    return read(layout_->state, frame, sequence);
+  }
+
+private:
+  static void write(SimFrameSlot & slot, const SimFrame & frame);
+  static bool read(const SimFrameSlot & slot, SimFrame & frame, std::uint32_t & sequence);
+
+  SimSharedMemoryLayout * layout_ = nullptr;
+};
+
+}  // namespace kortex_driver
+
+#endif  // KORTEX_DRIVER__SIM_SHARED_MEMORY_HPP_
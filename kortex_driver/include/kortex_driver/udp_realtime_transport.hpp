@@ -0,0 +1,104 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef KORTEX_DRIVER__UDP_REALTIME_TRANSPORT_HPP_
+#define KORTEX_DRIVER__UDP_REALTIME_TRANSPORT_HPP_
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ITransportClient.h"
+
+namespace k_api = Kinova::Api;
+
+namespace kortex_driver
+{
+struct UdpTransportOptions
+{
+  // SO_BUSY_POLL budget in microseconds, 0 leaves the socket default
+  int busy_poll_us = 0;
+  // SO_PRIORITY of outgoing frames, negative leaves the socket default
+  int socket_priority = -1;
+  // DSCP code point written in the IP header, negative leaves the socket default
+  int dscp = -1;
+  // software receive timestamps through SO_TIMESTAMPING
+  bool timestamping = false;
+  // poll the socket without sleeping instead of blocking in poll()
+  bool spin_wait = false;
+  // number of datagrams drained by a single recvmmsg() call
+  std::size_t receive_batch = 4;
+};
+
+// Driver-owned UDP transport for the cyclic router. Frames are received by a dedicated
+// thread with recvmmsg() into buffers allocated on construction and handed to the router
+// callback without copies.
+class UdpRealtimeTransport : public k_api::ITransportClient
+{
+public:
+  explicit UdpRealtimeTransport(const UdpTransportOptions & options);
+  ~UdpRealtimeTransport() override;
+
+  bool connect(std::string host, uint32_t port) override;
+  void disconnect() override;
+  void send(const char * tx_buffer, uint32_t tx_size) override;
+  void onMessage(std::function<void(const char *, uint32_t)> callback) override;
+  char * getTxBuffer() override;
+  size_t getMaxTxBufferSize() override;
+
+  // CLOCK_MONOTONIC time at which the last frame was received, taken by the kernel when
+  // timestamping is enabled and by the receive thread otherwise
+  std::int64_t lastReceiveTimestampNs() const
+  {
+    return last_rx_timestamp_ns_.load(std::memory_order_relaxed);
+  }
+  // send() is called on the control thread, its failures are counted instead of logged
+  std::uint64_t sendFailures() const { return send_failures_.load(std::memory_order_relaxed); }
+  int lastSendError() const { return last_send_error_.load(std::memory_order_relaxed); }
+
+private:
+  static constexpr std::size_t MAX_FRAME_SIZE = 65507;
+  static constexpr std::size_t CONTROL_SIZE = 256;
+  static constexpr int POLL_TIMEOUT_MS = 100;
+
+  void configureSocket();
+  void receiveLoop();
+  std::int64_t receiveTimestamp(const msghdr & header) const;
+
+  UdpTransportOptions options_;
+  int socket_ = -1;
+  std::atomic<bool> running_{false};
+  std::thread receive_thread_;
+  std::function<void(const char *, uint32_t)> callback_;
+  std::atomic<std::int64_t> last_rx_timestamp_ns_{0};
+  std::atomic<std::uint64_t> send_failures_{0};
+  std::atomic<int> last_send_error_{0};
+
+  std::vector<char> tx_buffer_;
+  std::vector<char> rx_buffers_;
+  std::vector<char> rx_control_;
+  std::vector<iovec> rx_iovecs_;
+  std::vector<mmsghdr> rx_headers_;
+};
+
+}  // namespace kortex_driver
+
+#endif  // KORTEX_DRIVER__UDP_REALTIME_TRANSPORT_HPP_
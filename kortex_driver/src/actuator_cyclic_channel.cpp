@@ -0,0 +1,202 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <utility>
+
+#include "kortex_driver/actuator_cyclic_channel.hpp"
+#include "kortex_driver/kortex_math_util.hpp"
+#include "kortex_driver/rt_safety.hpp"
+
+#include "rclcpp/rclcpp.hpp"
+
+namespace
+{
+const rclcpp::Logger LOGGER = rclcpp::get_logger("ActuatorCyclicChannel");
+
+// bit 0 of the command flags, the actuator follows the command
+constexpr std::uint32_t SERVO_ENABLE_FLAG = 1;
+}  // namespace
+
+namespace kortex_driver
+{
+bool parseActuatorCyclicRouting(const std::string & name, ActuatorCyclicRouting & routing)
+{
+  if (name == "shared")
+  {
+    routing = ActuatorCyclicRouting::SHARED;
+    return true;
+  }
+  if (name == "dedicated")
+  {
+    routing = ActuatorCyclicRouting::DEDICATED;
+    return true;
+  }
+  return false;
+}
+
+ActuatorCyclicChannel::DedicatedLink::DedicatedLink(k_api::ITransportClient * transport_client)
+: router{
+    transport_client,
+    [](k_api::KError err) { RCLCPP_ERROR(LOGGER, "Router error: %s", err.toString().c_str()); }},
+  session_manager{&router}
+{
+}
+
+ActuatorCyclicChannel::~ActuatorCyclicChannel() { close(); }
+
+bool ActuatorCyclicChannel::open(
+  const std::vector<std::uint32_t> & device_ids, ActuatorCyclicRouting routing,
+  k_api::RouterClient * shared_router, const std::string & ip, std::uint32_t port,
+  const k_api::Session::CreateSessionInfo & session_info)
+{
+  close();
+  device_ids_ = device_ids;
+  for (const std::uint32_t device_id : device_ids_)
+  {
+    k_api::RouterClient * router = shared_router;
+    if (routing == ActuatorCyclicRouting::DEDICATED)
+    {
+      auto transport = std::make_unique<k_api::TransportClientUdp>();
+      if (!transport->connect(ip, port))
+      {
+        RCLCPP_ERROR(LOGGER, "Could not connect the channel of actuator %u", device_id);
+        close();
+        return false;
+      }
+      auto link = std::make_unique<DedicatedLink>(transport.get());
+      try
+      {
+        link->session_manager.CreateSession(session_info);
+      }
+      catch (k_api::KDetailedException & ex)
+      {
+        RCLCPP_ERROR(
+          LOGGER, "Could not open a session for actuator %u: %s", device_id, ex.what());
+        transport->disconnect();
+        close();
+        return false;
+      }
+      router = &link->router;
+      transports_.push_back(std::move(transport));
+      links_.push_back(std::move(link));
+    }
+    clients_.push_back(std::make_unique<k_api::ActuatorCyclic::ActuatorCyclicClient>(router));
+  }
+
+  const std::size_t count = device_ids_.size();
+  commands_.assign(count, k_api::ActuatorCyclic::Command());
+  for (auto & command : commands_)
+  {
+    command.set_flags(SERVO_ENABLE_FLAG);
+  }
+  pending_.clear();
+  pending_.resize(count);
+  actuator_faults_.assign(count, 0.0);
+  round_trips_.assign(count, std::numeric_limits<double>::quiet_NaN());
+  jitters_.assign(count, std::numeric_limits<double>::quiet_NaN());
+  RCLCPP_INFO(
+    LOGGER, "Opened %zu actuator cyclic clients on %s routers", count,
+    routing == ActuatorCyclicRouting::DEDICATED ? "dedicated" : "the shared");
+  return true;
+}
+
+void ActuatorCyclicChannel::close()
+{
+  clients_.clear();
+  for (auto & link : links_)
+  {
+    try
+    {
+      link->session_manager.CloseSession();
+    }
+    catch (k_api::KDetailedException & ex)
+    {
+      RCLCPP_WARN(LOGGER, "Could not close an actuator session: %s", ex.what());
+    }
+    link->router.SetActivationStatus(false);
+  }
+  for (auto & transport : transports_)
+  {
+    transport->disconnect();
+  }
+  links_.clear();
+  transports_.clear();
+  pending_.clear();
+}
+
+bool ActuatorCyclicChannel::exchange(
+  const std::vector<double> & positions, std::uint32_t frame_id, std::uint32_t timeout_ms,
+  FeedbackSnapshot & snapshot)
+{
+  const k_api::RouterClientSendOptions options{false, 0, timeout_ms};
+  const auto start = std::chrono::steady_clock::now();
+  bool success = true;
+
+  // every command leaves before the first feedback is awaited
+  for (std::size_t i = 0; i < clients_.size(); i++)
+  {
+    commands_[i].set_position(static_cast<float>(
+      KortexMathUtil::wrapDegreesFromZeroTo360(KortexMathUtil::toDeg(positions[i]))));
+    commands_[i].set_command_id(frame_id);
+    try
+    {
+      // the Kortex API allocates the frame and the promise of every exchange
+      KORTEX_RT_ALLOW();
+      pending_[i] = clients_[i]->Refresh_async(commands_[i], device_ids_[i], options);
+    }
+    catch (std::exception & /*ex*/)
+    {
+      success = false;
+    }
+  }
+
+  for (std::size_t i = 0; i < clients_.size(); i++)
+  {
+    if (!pending_[i].valid())
+    {
+      continue;
+    }
+    try
+    {
+      k_api::ActuatorCyclic::Feedback feedback;
+      {
+        // the flat feedback message does not allocate, releasing the future does
+        KORTEX_RT_ALLOW();
+        feedback = pending_[i].get();
+      }
+      round_trips_[i] =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      jitters_[i] = feedback.jitter_comm() * 1e-6;
+      snapshot.positions[i] =
+        KortexMathUtil::wrapRadiansFromMinusPiToPi(KortexMathUtil::toRad(feedback.position()));
+      snapshot.velocities[i] = KortexMathUtil::toRad(feedback.velocity());
+      snapshot.efforts[i] = feedback.torque();
+      actuator_faults_[i] = feedback.fault_bank_a() + feedback.fault_bank_b();
+    }
+    catch (std::exception & /*ex*/)
+    {
+      success = false;
+    }
+  }
+
+  snapshot.faults =
+    std::accumulate(actuator_faults_.begin(), actuator_faults_.end(), snapshot.base_faults);
+  return success;
+}
+
+}  // namespace kortex_driver
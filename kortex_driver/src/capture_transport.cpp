@@ -0,0 +1,303 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include "kortex_driver/capture_transport.hpp"
+
+#include "rclcpp/rclcpp.hpp"
+
+namespace
+{
+const rclcpp::Logger LOGGER = rclcpp::get_logger("CaptureTransport");
+
+// pcapng block types and options, see https://www.ietf.org/archive/id/draft-ietf-opsawg-pcapng
+constexpr std::uint32_t SECTION_HEADER_BLOCK = 0x0A0D0D0A;
+constexpr std::uint32_t INTERFACE_DESCRIPTION_BLOCK = 0x00000001;
+constexpr std::uint32_t ENHANCED_PACKET_BLOCK = 0x00000006;
+constexpr std::uint32_t BYTE_ORDER_MAGIC = 0x1A2B3C4D;
+constexpr std::uint16_t OPT_ENDOFOPT = 0;
+constexpr std::uint16_t IF_NAME = 2;
+constexpr std::uint16_t IF_TSRESOL = 9;
+constexpr std::uint16_t EPB_FLAGS = 2;
+constexpr std::uint32_t EPB_FLAGS_INBOUND = 0x1;
+constexpr std::uint32_t EPB_FLAGS_OUTBOUND = 0x2;
+
+std::size_t padded(std::size_t length) { return (length + 3) & ~static_cast<std::size_t>(3); }
+
+template <typename T>
+void append(std::string & block, T value)
+{
+  block.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void appendPadded(std::string & block, const char * data, std::size_t length)
+{
+  if (length > 0)
+  {
+    block.append(data, length);
+    block.append(padded(length) - length, '\0');
+  }
+}
+
+void appendOption(std::string & block, std::uint16_t code, const char * data, std::uint16_t length)
+{
+  append(block, code);
+  append(block, length);
+  appendPadded(block, data, length);
+}
+
+// Fills in both total length fields once the body of the block is complete
+void finishBlock(std::string & block)
+{
+  const std::uint32_t total_length = static_cast<std::uint32_t>(block.size() + 4);
+  std::memcpy(&block[4], &total_length, sizeof(total_length));
+  append(block, total_length);
+}
+
+std::int64_t now()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::system_clock::now().time_since_epoch())
+    .count();
+}
+}  // namespace
+
+namespace kortex_driver
+{
+CaptureRing::CaptureRing(std::size_t capacity, std::uint32_t snap_length)
+: snap_length_(snap_length)
+{
+  std::size_t size = 1;
+  while (size < capacity)
+  {
+    size <<= 1;
+  }
+  mask_ = size - 1;
+  cells_.reset(new Cell[size]);
+  data_.reset(new char[size * snap_length_]);
+  for (std::size_t i = 0; i < size; i++)
+  {
+    cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+bool CaptureRing::push(
+  const char * data, std::uint32_t size, bool outbound, std::int64_t timestamp_ns)
+{
+  std::size_t position = enqueue_position_.load(std::memory_order_relaxed);
+  Cell * cell = nullptr;
+  for (;;)
+  {
+    cell = &cells_[position & mask_];
+    const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    const std::intptr_t difference =
+      static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+    if (difference == 0)
+    {
+      if (enqueue_position_.compare_exchange_weak(
+            position, position + 1, std::memory_order_relaxed))
+      {
+        break;
+      }
+    }
+    else if (difference < 0)
+    {
+      return false;
+    }
+    else
+    {
+      position = enqueue_position_.load(std::memory_order_relaxed);
+    }
+  }
+
+  cell->timestamp_ns = timestamp_ns;
+  cell->original_length = size;
+  cell->captured_length = std::min(size, snap_length_);
+  cell->outbound = outbound;
+  std::memcpy(&data_[(position & mask_) * snap_length_], data, cell->captured_length);
+  cell->sequence.store(position + 1, std::memory_order_release);
+  return true;
+}
+
+bool CaptureRing::pop(const std::function<void(const Record &)> & consume)
+{
+  Cell & cell = cells_[dequeue_position_ & mask_];
+  if (cell.sequence.load(std::memory_order_acquire) != dequeue_position_ + 1)
+  {
+    return false;
+  }
+  consume(Record{
+    cell.timestamp_ns, cell.original_length, cell.captured_length, cell.outbound,
+    &data_[(dequeue_position_ & mask_) * snap_length_]});
+  cell.sequence.store(dequeue_position_ + mask_ + 1, std::memory_order_release);
+  dequeue_position_++;
+  return true;
+}
+
+CaptureTransport::CaptureTransport(
+  k_api::ITransportClient * transport, const std::string & file_name,
+  const std::string & interface_name, std::size_t queue_size, std::uint32_t snap_length)
+: transport_(transport),
+  file_name_(file_name),
+  interface_name_(interface_name),
+  ring_(queue_size, snap_length)
+{
+}
+
+CaptureTransport::~CaptureTransport()
+{
+  running_ = false;
+  if (writer_thread_.joinable())
+  {
+    writer_thread_.join();
+  }
+  if (file_ != nullptr)
+  {
+    std::fclose(file_);
+  }
+  if (dropped_ > 0)
+  {
+    RCLCPP_WARN(
+      LOGGER, "%lu frames were dropped from capture '%s'", static_cast<unsigned long>(dropped_),
+      file_name_.c_str());
+  }
+}
+
+bool CaptureTransport::start()
+{
+  file_ = std::fopen(file_name_.c_str(), "wb");
+  if (file_ == nullptr)
+  {
+    RCLCPP_ERROR(
+      LOGGER, "Could not open capture file '%s': %s", file_name_.c_str(), std::strerror(errno));
+    return false;
+  }
+  writeHeader();
+  running_ = true;
+  writer_thread_ = std::thread(&CaptureTransport::writeLoop, this);
+  RCLCPP_INFO(LOGGER, "Capturing %s frames to '%s'", interface_name_.c_str(), file_name_.c_str());
+  return true;
+}
+
+bool CaptureTransport::connect(std::string host, uint32_t port)
+{
+  return transport_->connect(std::move(host), port);
+}
+
+void CaptureTransport::disconnect() { transport_->disconnect(); }
+
+void CaptureTransport::send(const char * tx_buffer, uint32_t tx_size)
+{
+  capture(tx_buffer, tx_size, true);
+  transport_->send(tx_buffer, tx_size);
+}
+
+void CaptureTransport::onMessage(std::function<void(const char *, uint32_t)> callback)
+{
+  transport_->onMessage(
+    [this, callback = std::move(callback)](const char * rx_buffer, uint32_t rx_size)
+    {
+      capture(rx_buffer, rx_size, false);
+      callback(rx_buffer, rx_size);
+    });
+}
+
+char * CaptureTransport::getTxBuffer() { return transport_->getTxBuffer(); }
+
+size_t CaptureTransport::getMaxTxBufferSize() { return transport_->getMaxTxBufferSize(); }
+
+void CaptureTransport::capture(const char * data, uint32_t size, bool outbound)
+{
+  if (running_ && !ring_.push(data, size, outbound, now()))
+  {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void CaptureTransport::writeLoop()
+{
+  const std::function<void(const CaptureRing::Record &)> write =
+    [this](const CaptureRing::Record & record) { writeRecord(record); };
+  while (running_)
+  {
+    if (!ring_.pop(write))
+    {
+      std::fflush(file_);
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+  // drain what was captured before stopping
+  while (ring_.pop(write))
+  {
+  }
+  std::fflush(file_);
+}
+
+void CaptureTransport::writeHeader()
+{
+  std::string block;
+  append(block, SECTION_HEADER_BLOCK);
+  append(block, std::uint32_t{0});
+  append(block, BYTE_ORDER_MAGIC);
+  append(block, std::uint16_t{1});
+  append(block, std::uint16_t{0});
+  // section length is not known in advance
+  append(block, std::int64_t{-1});
+  finishBlock(block);
+  std::fwrite(block.data(), 1, block.size(), file_);
+
+  block.clear();
+  append(block, INTERFACE_DESCRIPTION_BLOCK);
+  append(block, std::uint32_t{0});
+  append(block, LINK_TYPE);
+  append(block, std::uint16_t{0});
+  append(block, ring_.snapLength());
+  appendOption(
+    block, IF_NAME, interface_name_.data(), static_cast<std::uint16_t>(interface_name_.size()));
+  // nanosecond timestamps
+  const char resolution = 9;
+  appendOption(block, IF_TSRESOL, &resolution, 1);
+  appendOption(block, OPT_ENDOFOPT, nullptr, 0);
+  finishBlock(block);
+  std::fwrite(block.data(), 1, block.size(), file_);
+}
+
+void CaptureTransport::writeRecord(const CaptureRing::Record & record)
+{
+  std::string block;
+  block.reserve(48 + padded(record.captured_length));
+  append(block, ENHANCED_PACKET_BLOCK);
+  append(block, std::uint32_t{0});
+  // interface id
+  append(block, std::uint32_t{0});
+  const std::uint64_t timestamp = static_cast<std::uint64_t>(record.timestamp_ns);
+  append(block, static_cast<std::uint32_t>(timestamp >> 32));
+  append(block, static_cast<std::uint32_t>(timestamp & 0xffffffff));
+  append(block, record.captured_length);
+  append(block, record.original_length);
+  appendPadded(block, record.data, record.captured_length);
+  const std::uint32_t flags = record.outbound ? EPB_FLAGS_OUTBOUND : EPB_FLAGS_INBOUND;
+  appendOption(block, EPB_FLAGS, reinterpret_cast<const char *>(&flags), sizeof(flags));
+  appendOption(block, OPT_ENDOFOPT, nullptr, 0);
+  finishBlock(block);
+  std::fwrite(block.data(), 1, block.size(), file_);
+}
+
+}  // namespace kortex_driver
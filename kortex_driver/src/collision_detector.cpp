@@ -0,0 +1,111 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+
+#include "kortex_driver/collision_detector.hpp"
+
+namespace kortex_driver
+{
+void CollisionDetector::configure(
+  std::size_t joint_count, double gain, const std::vector<double> & thresholds,
+  int confirmation_cycles)
+{
+  gain_ = std::max(gain, 0.0);
+  confirmation_cycles_ = std::max(confirmation_cycles, 1);
+  thresholds_.assign(joint_count, thresholds.empty() ? 0.0 : thresholds.front());
+  if (thresholds.size() == joint_count)
+  {
+    thresholds_ = thresholds;
+  }
+  external_torques_.assign(joint_count, 0.0);
+
+  const int count = static_cast<int>(joint_count);
+  q_.setZero(count);
+  qd_.setZero(count);
+  tau_.setZero(count);
+  gravity_.setZero(count);
+  coriolis_.setZero(count);
+  residual_.setZero(count);
+  integral_.setZero(count);
+  mass_matrix_.setZero(count, count);
+  previous_mass_matrix_.setZero(count, count);
+  reset();
+}
+
+void CollisionDetector::reset()
+{
+  initialized_ = false;
+  cycles_above_threshold_ = 0;
+  residual_.setZero();
+  std::fill(external_torques_.begin(), external_torques_.end(), 0.0);
+}
+
+void CollisionDetector::clearContact()
+{
+  contact_ = 0.0;
+  cycles_above_threshold_ = 0;
+}
+
+void CollisionDetector::update(
+  RigidBodyModel & model, const std::vector<double> & positions,
+  const std::vector<double> & velocities, const std::vector<double> & efforts, double dt)
+{
+  const std::size_t count = external_torques_.size();
+  for (std::size_t i = 0; i < count; i++)
+  {
+    q_[i] = positions[i];
+    qd_[i] = velocities[i];
+    tau_[i] = efforts[i];
+  }
+
+  model.massMatrix(q_, mass_matrix_);
+  if (!initialized_)
+  {
+    // the observer starts at rest, whatever the arm is carrying or touching right now
+    integral_.noalias() = mass_matrix_ * qd_;
+    previous_mass_matrix_ = mass_matrix_;
+    initialized_ = true;
+    return;
+  }
+  if (dt <= 0.0)
+  {
+    return;
+  }
+
+  model.gravityTorques(q_, gravity_);
+  model.coriolisTorques(q_, qd_, coriolis_);
+  // C^T qd = dM/dt qd - C qd, with the derivative of the mass matrix along the motion
+  coriolis_.noalias() = (mass_matrix_ - previous_mass_matrix_) * qd_ / dt - coriolis_;
+  previous_mass_matrix_ = mass_matrix_;
+
+  integral_ += (tau_ + coriolis_ - gravity_ + residual_) * dt;
+  residual_.noalias() = mass_matrix_ * qd_;
+  residual_ = gain_ * (residual_ - integral_);
+
+  bool above_threshold = false;
+  for (std::size_t i = 0; i < count; i++)
+  {
+    external_torques_[i] = residual_[static_cast<int>(i)];
+    above_threshold |= std::abs(external_torques_[i]) > thresholds_[i];
+  }
+  cycles_above_threshold_ = above_threshold ? cycles_above_threshold_ + 1 : 0;
+  if (cycles_above_threshold_ >= confirmation_cycles_)
+  {
+    contact_ = 1.0;
+  }
+}
+
+}  // namespace kortex_driver
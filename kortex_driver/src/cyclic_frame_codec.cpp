@@ -0,0 +1,522 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include "kortex_driver/cyclic_frame_codec.hpp"
+#include "kortex_driver/kortex_math_util.hpp"
+
+#include "google/protobuf/descriptor.h"
+
+namespace
+{
+using google::protobuf::Descriptor;
+using google::protobuf::FieldDescriptor;
+
+constexpr std::uint32_t WIRE_VARINT = 0;
+constexpr std::uint32_t WIRE_FIXED64 = 1;
+constexpr std::uint32_t WIRE_LENGTH_DELIMITED = 2;
+constexpr std::uint32_t WIRE_FIXED32 = 5;
+// longest varint encoding of a uint32
+constexpr std::size_t PADDED_VARINT_SIZE = 5;
+
+// number of the field called name, 0 if the message has no such field of this type
+int fieldNumber(const Descriptor * message, const char * name, FieldDescriptor::Type type)
+{
+  const FieldDescriptor * field = message->FindFieldByName(name);
+  return field != nullptr && field->type() == type ? field->number() : 0;
+}
+
+void writePaddedVarint(char * out, std::uint32_t value)
+{
+  for (std::size_t i = 0; i + 1 < PADDED_VARINT_SIZE; i++)
+  {
+    out[i] = static_cast<char>(((value >> (7 * i)) & 0x7f) | 0x80);
+  }
+  out[PADDED_VARINT_SIZE - 1] = static_cast<char>((value >> 28) & 0x0f);
+}
+
+// Appends fields to a payload and returns the offsets of their values
+class Writer
+{
+public:
+  explicit Writer(std::string & out) : out_(out) {}
+
+  std::size_t paddedVarint(int number)
+  {
+    tag(number, WIRE_VARINT);
+    const std::size_t offset = out_.size();
+    out_.append(PADDED_VARINT_SIZE, '\0');
+    writePaddedVarint(&out_[offset], 0);
+    return offset;
+  }
+
+  std::size_t fixed32(int number)
+  {
+    tag(number, WIRE_FIXED32);
+    const std::size_t offset = out_.size();
+    out_.append(4, '\0');
+    return offset;
+  }
+
+  // nested messages are short, their length is patched in a single byte once they end
+  std::size_t beginMessage(int number)
+  {
+    tag(number, WIRE_LENGTH_DELIMITED);
+    out_.push_back('\0');
+    return out_.size();
+  }
+
+  bool endMessage(std::size_t begin)
+  {
+    const std::size_t length = out_.size() - begin;
+    out_[begin - 1] = static_cast<char>(length);
+    return length < 0x80;
+  }
+
+private:
+  void tag(int number, std::uint32_t wire_type)
+  {
+    std::uint32_t key = (static_cast<std::uint32_t>(number) << 3) | wire_type;
+    while (key >= 0x80)
+    {
+      out_.push_back(static_cast<char>((key & 0x7f) | 0x80));
+      key >>= 7;
+    }
+    out_.push_back(static_cast<char>(key));
+  }
+
+  std::string & out_;
+};
+
+// Walks the fields of a serialized message without allocating
+class Reader
+{
+public:
+  Reader(const char * begin, const char * end) : position_(begin), end_(end) {}
+
+  bool atEnd() const { return position_ == end_; }
+
+  // false at the end of the message or on a malformed key
+  bool next(int & number, std::uint32_t & wire_type)
+  {
+    std::uint64_t key = 0;
+    if (atEnd() || !varint(key))
+    {
+      return false;
+    }
+    number = static_cast<int>(key >> 3);
+    wire_type = static_cast<std::uint32_t>(key & 0x7);
+    return true;
+  }
+
+  bool varint(std::uint64_t & value)
+  {
+    value = 0;
+    for (int shift = 0; shift < 64 && position_ < end_; shift += 7)
+    {
+      const auto byte = static_cast<std::uint8_t>(*position_++);
+      value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool fixed32(float & value)
+  {
+    if (end_ - position_ < 4)
+    {
+      return false;
+    }
+    std::memcpy(&value, position_, sizeof(value));
+    position_ += 4;
+    return true;
+  }
+
+  // the content of a length delimited field, the reader moves past it
+  bool message(Reader & content)
+  {
+    std::uint64_t length = 0;
+    if (!varint(length) || length > static_cast<std::uint64_t>(end_ - position_))
+    {
+      return false;
+    }
+    content = Reader(position_, position_ + length);
+    position_ += length;
+    return true;
+  }
+
+  bool skip(std::uint32_t wire_type)
+  {
+    std::uint64_t value = 0;
+    Reader content(end_, end_);
+    switch (wire_type)
+    {
+      case WIRE_VARINT:
+        return varint(value);
+      case WIRE_FIXED64:
+        return advance(8);
+      case WIRE_LENGTH_DELIMITED:
+        return message(content);
+      case WIRE_FIXED32:
+        return advance(4);
+      default:
+        // groups are not used by the Kortex messages
+        return false;
+    }
+  }
+
+  // a scalar of the expected wire type, anything else is skipped
+  bool uint32Field(std::uint32_t wire_type, double & value)
+  {
+    std::uint64_t raw = 0;
+    if (wire_type != WIRE_VARINT)
+    {
+      return skip(wire_type);
+    }
+    if (!varint(raw))
+    {
+      return false;
+    }
+    value = static_cast<double>(static_cast<std::uint32_t>(raw));
+    return true;
+  }
+
+  bool floatField(std::uint32_t wire_type, float & value)
+  {
+    return wire_type == WIRE_FIXED32 ? fixed32(value) : skip(wire_type);
+  }
+
+private:
+  bool advance(std::ptrdiff_t count)
+  {
+    if (end_ - position_ < count)
+    {
+      return false;
+    }
+    position_ += count;
+    return true;
+  }
+
+  const char * position_;
+  const char * end_;
+};
+}  // namespace
+
+namespace kortex_driver
+{
+bool CyclicCommandEncoder::layout(std::size_t actuator_count)
+{
+  payload_.clear();
+  actuator_offsets_.assign(actuator_count, ActuatorOffsets());
+
+  const Descriptor * command = k_api::BaseCyclic::Command::descriptor();
+  const Descriptor * actuator = k_api::BaseCyclic::ActuatorCommand::descriptor();
+  const Descriptor * interconnect = k_api::InterconnectCyclic::Command::descriptor();
+  const Descriptor * gripper = k_api::GripperCyclic::Command::descriptor();
+  const Descriptor * motor = k_api::GripperCyclic::MotorCommand::descriptor();
+  const int frame_id = fieldNumber(command, "frame_id", FieldDescriptor::TYPE_UINT32);
+  const int actuators = fieldNumber(command, "actuators", FieldDescriptor::TYPE_MESSAGE);
+  const int interconnect_command =
+    fieldNumber(command, "interconnect", FieldDescriptor::TYPE_MESSAGE);
+  const int command_id = fieldNumber(actuator, "command_id", FieldDescriptor::TYPE_UINT32);
+  const int position = fieldNumber(actuator, "position", FieldDescriptor::TYPE_FLOAT);
+  const int interconnect_command_id =
+    fieldNumber(interconnect, "command_id", FieldDescriptor::TYPE_MESSAGE);
+  const int gripper_command =
+    fieldNumber(interconnect, "gripper_command", FieldDescriptor::TYPE_MESSAGE);
+  const int motor_command = fieldNumber(gripper, "motor_cmd", FieldDescriptor::TYPE_MESSAGE);
+  const int motor_position = fieldNumber(motor, "position", FieldDescriptor::TYPE_FLOAT);
+  const int motor_velocity = fieldNumber(motor, "velocity", FieldDescriptor::TYPE_FLOAT);
+  const int motor_force = fieldNumber(motor, "force", FieldDescriptor::TYPE_FLOAT);
+  if (
+    frame_id == 0 || actuators == 0 || interconnect_command == 0 || command_id == 0 ||
+    position == 0 || interconnect_command_id == 0 || gripper_command == 0 || motor_command == 0 ||
+    motor_position == 0 || motor_velocity == 0 || motor_force == 0)
+  {
+    actuator_offsets_.clear();
+    return false;
+  }
+
+  std::string payload;
+  Writer writer(payload);
+  bool fits = true;
+  frame_id_offset_ = writer.paddedVarint(frame_id);
+  for (auto & offsets : actuator_offsets_)
+  {
+    const std::size_t begin = writer.beginMessage(actuators);
+    offsets.command_id = writer.paddedVarint(command_id);
+    offsets.position = writer.fixed32(position);
+    fits &= writer.endMessage(begin);
+  }
+  // the interconnect command of the driver: an empty command id and a single motor command
+  const std::size_t interconnect_begin = writer.beginMessage(interconnect_command);
+  fits &= writer.endMessage(writer.beginMessage(interconnect_command_id));
+  const std::size_t gripper_begin = writer.beginMessage(gripper_command);
+  const std::size_t motor_begin = writer.beginMessage(motor_command);
+  gripper_position_offset_ = writer.fixed32(motor_position);
+  gripper_velocity_offset_ = writer.fixed32(motor_velocity);
+  gripper_force_offset_ = writer.fixed32(motor_force);
+  fits &= writer.endMessage(motor_begin);
+  fits &= writer.endMessage(gripper_begin);
+  fits &= writer.endMessage(interconnect_begin);
+  if (!fits)
+  {
+    actuator_offsets_.clear();
+    return false;
+  }
+  payload_ = payload;
+  return true;
+}
+
+bool CyclicCommandEncoder::encodes(const k_api::BaseCyclic::Command & command) const
+{
+  // both serializations are canonical, equal messages give equal bytes
+  k_api::BaseCyclic::Command parsed;
+  return parsed.ParseFromString(payload_) &&
+         parsed.SerializeAsString() == command.SerializeAsString();
+}
+
+void CyclicCommandEncoder::writeVarint(std::size_t offset, std::uint32_t value)
+{
+  writePaddedVarint(&payload_[offset], value);
+}
+
+void CyclicCommandEncoder::writeFloat(std::size_t offset, float value)
+{
+  // fixed32 is little endian, as every host the Kortex API is built for
+  std::memcpy(&payload_[offset], &value, sizeof(value));
+}
+
+bool CyclicFeedbackDecoder::configure(std::size_t actuator_count)
+{
+  joints_.resize(actuator_count);
+  const Descriptor * feedback = k_api::BaseCyclic::Feedback::descriptor();
+  const Descriptor * base = k_api::BaseCyclic::BaseFeedback::descriptor();
+  const Descriptor * actuator = k_api::BaseCyclic::ActuatorFeedback::descriptor();
+  const Descriptor * interconnect = k_api::InterconnectCyclic::Feedback::descriptor();
+  const Descriptor * gripper = k_api::GripperCyclic::Feedback::descriptor();
+  const Descriptor * motor = k_api::GripperCyclic::MotorFeedback::descriptor();
+  Fields & f = fields_;
+  f.base = fieldNumber(feedback, "base", FieldDescriptor::TYPE_MESSAGE);
+  f.actuators = fieldNumber(feedback, "actuators", FieldDescriptor::TYPE_MESSAGE);
+  f.interconnect = fieldNumber(feedback, "interconnect", FieldDescriptor::TYPE_MESSAGE);
+  f.base_active_state = fieldNumber(base, "active_state", FieldDescriptor::TYPE_ENUM);
+  f.base_fault_bank_a = fieldNumber(base, "fault_bank_a", FieldDescriptor::TYPE_UINT32);
+  f.base_fault_bank_b = fieldNumber(base, "fault_bank_b", FieldDescriptor::TYPE_UINT32);
+  f.actuator_position = fieldNumber(actuator, "position", FieldDescriptor::TYPE_FLOAT);
+  f.actuator_velocity = fieldNumber(actuator, "velocity", FieldDescriptor::TYPE_FLOAT);
+  f.actuator_torque = fieldNumber(actuator, "torque", FieldDescriptor::TYPE_FLOAT);
+  f.actuator_fault_bank_a = fieldNumber(actuator, "fault_bank_a", FieldDescriptor::TYPE_UINT32);
+  f.actuator_fault_bank_b = fieldNumber(actuator, "fault_bank_b", FieldDescriptor::TYPE_UINT32);
+  f.gripper_feedback =
+    fieldNumber(interconnect, "gripper_feedback", FieldDescriptor::TYPE_MESSAGE);
+  f.gripper_motor = fieldNumber(gripper, "motor", FieldDescriptor::TYPE_MESSAGE);
+  f.motor_position = fieldNumber(motor, "position", FieldDescriptor::TYPE_FLOAT);
+  configured_ =
+    f.base != 0 && f.actuators != 0 && f.interconnect != 0 && f.base_active_state != 0 &&
+    f.base_fault_bank_a != 0 && f.base_fault_bank_b != 0 && f.actuator_position != 0 &&
+    f.actuator_velocity != 0 && f.actuator_torque != 0 && f.actuator_fault_bank_a != 0 &&
+    f.actuator_fault_bank_b != 0 && f.gripper_feedback != 0 && f.gripper_motor != 0 &&
+    f.motor_position != 0;
+  return configured_;
+}
+
+bool CyclicFeedbackDecoder::decode(
+  const std::string & payload, FeedbackSnapshot & snapshot, bool with_gripper)
+{
+  const std::size_t count = snapshot.positions.size();
+  joints_.resize(count);
+  const Fields & f = fields_;
+  Reader reader(payload.data(), payload.data() + payload.size());
+  // absent fields read as zero, as with the parsed message
+  double base_fault_bank_a = 0.0;
+  double base_fault_bank_b = 0.0;
+  double active_state = 0.0;
+  double actuator_faults = 0.0;
+  float gripper_position = 0.0f;
+  std::size_t actuator = 0;
+
+  int number = 0;
+  std::uint32_t wire_type = 0;
+  while (reader.next(number, wire_type))
+  {
+    Reader content(nullptr, nullptr);
+    if (wire_type != WIRE_LENGTH_DELIMITED)
+    {
+      if (!reader.skip(wire_type))
+      {
+        return false;
+      }
+    }
+    else if (number == f.actuators)
+    {
+      if (!reader.message(content))
+      {
+        return false;
+      }
+      float position = 0.0f;
+      float velocity = 0.0f;
+      float torque = 0.0f;
+      double fault_bank_a = 0.0;
+      double fault_bank_b = 0.0;
+      bool ok = true;
+      while (ok && content.next(number, wire_type))
+      {
+        ok = number == f.actuator_position         ? content.floatField(wire_type, position)
+             : number == f.actuator_velocity       ? content.floatField(wire_type, velocity)
+             : number == f.actuator_torque         ? content.floatField(wire_type, torque)
+             : number == f.actuator_fault_bank_a   ? content.uint32Field(wire_type, fault_bank_a)
+             : number == f.actuator_fault_bank_b   ? content.uint32Field(wire_type, fault_bank_b)
+                                                   : content.skip(wire_type);
+      }
+      if (!ok || !content.atEnd())
+      {
+        return false;
+      }
+      if (actuator < count)
+      {
+        joints_.positions[actuator] =
+          KortexMathUtil::wrapRadiansFromMinusPiToPi(KortexMathUtil::toRad(position));
+        joints_.velocities[actuator] = KortexMathUtil::toRad(velocity);
+        joints_.efforts[actuator] = torque;
+        actuator_faults += fault_bank_a + fault_bank_b;
+      }
+      actuator++;
+    }
+    else if (number == f.base)
+    {
+      if (!reader.message(content))
+      {
+        return false;
+      }
+      bool ok = true;
+      while (ok && content.next(number, wire_type))
+      {
+        ok = number == f.base_active_state   ? content.uint32Field(wire_type, active_state)
+             : number == f.base_fault_bank_a ? content.uint32Field(wire_type, base_fault_bank_a)
+             : number == f.base_fault_bank_b ? content.uint32Field(wire_type, base_fault_bank_b)
+                                             : content.skip(wire_type);
+      }
+      if (!ok || !content.atEnd())
+      {
+        return false;
+      }
+    }
+    else if (number == f.interconnect && with_gripper)
+    {
+      // interconnect.gripper_feedback.motor[0].position
+      Reader gripper(nullptr, nullptr);
+      Reader motor(nullptr, nullptr);
+      bool first_motor = true;
+      if (!reader.message(content))
+      {
+        return false;
+      }
+      while (content.next(number, wire_type))
+      {
+        if (number != f.gripper_feedback || wire_type != WIRE_LENGTH_DELIMITED)
+        {
+          if (!content.skip(wire_type))
+          {
+            return false;
+          }
+          continue;
+        }
+        if (!content.message(gripper))
+        {
+          return false;
+        }
+        while (gripper.next(number, wire_type))
+        {
+          if (number != f.gripper_motor || wire_type != WIRE_LENGTH_DELIMITED || !first_motor)
+          {
+            if (!gripper.skip(wire_type))
+            {
+              return false;
+            }
+            continue;
+          }
+          first_motor = false;
+          if (!gripper.message(motor))
+          {
+            return false;
+          }
+          bool ok = true;
+          while (ok && motor.next(number, wire_type))
+          {
+            ok = number == f.motor_position ? motor.floatField(wire_type, gripper_position)
+                                            : motor.skip(wire_type);
+          }
+          if (!ok || !motor.atEnd())
+          {
+            return false;
+          }
+        }
+        if (!gripper.atEnd())
+        {
+          return false;
+        }
+      }
+      if (!content.atEnd())
+      {
+        return false;
+      }
+    }
+    else if (!reader.skip(wire_type))
+    {
+      return false;
+    }
+  }
+  if (!reader.atEnd())
+  {
+    return false;
+  }
+
+  const std::size_t decoded = std::min(actuator, count);
+  std::copy_n(joints_.positions.begin(), decoded, snapshot.positions.begin());
+  std::copy_n(joints_.velocities.begin(), decoded, snapshot.velocities.begin());
+  std::copy_n(joints_.efforts.begin(), decoded, snapshot.efforts.begin());
+  snapshot.base_faults = base_fault_bank_a + base_fault_bank_b;
+  snapshot.faults = snapshot.base_faults + actuator_faults;
+  snapshot.active_state = static_cast<k_api::Common::ArmState>(static_cast<int>(active_state));
+  if (with_gripper)
+  {
+    snapshot.gripper_position = gripper_position;
+  }
+  return true;
+}
+
+bool CyclicFeedbackDecoder::decodes(const k_api::BaseCyclic::Feedback & feedback, bool with_gripper)
+{
+  FeedbackSnapshot parsed;
+  FeedbackSnapshot decoded;
+  parsed.resize(joints_.positions.size());
+  decoded.resize(joints_.positions.size());
+  parsed.decode(feedback, with_gripper);
+  return configured_ && decode(feedback.SerializeAsString(), decoded, with_gripper) &&
+         decoded.positions == parsed.positions && decoded.velocities == parsed.velocities &&
+         decoded.efforts == parsed.efforts && decoded.faults == parsed.faults &&
+         decoded.base_faults == parsed.base_faults &&
+         decoded.active_state == parsed.active_state &&
+         (!with_gripper || decoded.gripper_position == parsed.gripper_position);
+}
+
+}  // namespace kortex_driver
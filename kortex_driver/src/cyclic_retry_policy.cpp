@@ -0,0 +1,55 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "kortex_driver/cyclic_retry_policy.hpp"
+
+namespace kortex_driver
+{
+bool CyclicRetryPolicy::parseFailureAction(const std::string & name, CyclicFailureAction & action)
+{
+  if (name == "skip")
+  {
+    action = CyclicFailureAction::SKIP;
+    return true;
+  }
+  if (name == "refresh_feedback")
+  {
+    action = CyclicFailureAction::REFRESH_FEEDBACK;
+    return true;
+  }
+  return false;
+}
+
+const char * toString(CyclicError error)
+{
+  switch (error)
+  {
+    case CyclicError::NONE:
+      return "none";
+    case CyclicError::KORTEX:
+      return "kortex_errors";
+    case CyclicError::RUNTIME:
+      return "runtime_errors";
+    case CyclicError::FUTURE:
+      return "future_errors";
+    case CyclicError::OTHER:
+      return "other_errors";
+    default:
+      return "unknown";
+  }
+}
+
+}  // namespace kortex_driver
@@ -0,0 +1,58 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <limits>
+
+#include "kortex_driver/dynamics_feedforward.hpp"
+
+namespace kortex_driver
+{
+void DynamicsFeedForward::configure(std::size_t joint_count)
+{
+  gravity_efforts_.assign(joint_count, std::numeric_limits<double>::quiet_NaN());
+  coriolis_efforts_.assign(joint_count, std::numeric_limits<double>::quiet_NaN());
+  inertias_.assign(joint_count, std::numeric_limits<double>::quiet_NaN());
+  q_.setZero(static_cast<int>(joint_count));
+  qd_.setZero(static_cast<int>(joint_count));
+}
+
+void DynamicsFeedForward::update(
+  RigidBodyModel & model, const std::vector<double> & positions,
+  const std::vector<double> & velocities)
+{
+  const std::size_t count = gravity_efforts_.size();
+  for (std::size_t i = 0; i < count; i++)
+  {
+    q_[i] = positions[i];
+    qd_[i] = velocities[i];
+  }
+
+  model.gravityTorques(q_, terms_);
+  for (std::size_t i = 0; i < count; i++)
+  {
+    gravity_efforts_[i] = terms_[i];
+  }
+  model.coriolisTorques(q_, qd_, terms_);
+  for (std::size_t i = 0; i < count; i++)
+  {
+    coriolis_efforts_[i] = terms_[i];
+  }
+  model.massMatrixDiagonal(q_, terms_);
+  for (std::size_t i = 0; i < count; i++)
+  {
+    inertias_[i] = terms_[i];
+  }
+}
+
+}  // namespace kortex_driver
@@ -0,0 +1,737 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "kortex_driver/fake_hardware.hpp"
+#include "kortex_driver/hardware_parameters.hpp"
+#include "kortex_driver/robot_description.hpp"
+#include "kortex_driver/rt_safety.hpp"
+
+#include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "rclcpp/rclcpp.hpp"
+
+namespace
+{
+const rclcpp::Logger LOGGER = rclcpp::get_logger("KortexFakeHardware");
+
+// Which controller a command interface belongs to, with the rules of
+// KortexMultiInterfaceHardware::prepare_command_mode_switch
+enum class InterfaceOwner
+{
+  NONE,
+  JOINTS,
+  TWIST,
+  GRIPPER,
+  FAULT
+};
+
+InterfaceOwner owner(
+  const std::string & key, const hardware_interface::HardwareInfo & info,
+  const std::string & gripper_joint_name)
+{
+  if (key.compare(0, 10, "tcp/twist.") == 0)
+  {
+    return InterfaceOwner::TWIST;
+  }
+  if ((key == "reset_fault/command") || (key == "reset_fault/async_success"))
+  {
+    return InterfaceOwner::FAULT;
+  }
+  for (const auto & joint : info.joints)
+  {
+    if (key == joint.name + "/" + hardware_interface::HW_IF_POSITION)
+    {
+      return joint.name == gripper_joint_name ? InterfaceOwner::GRIPPER : InterfaceOwner::JOINTS;
+    }
+    if (key == joint.name + "/" + hardware_interface::HW_IF_VELOCITY)
+    {
+      return joint.name == gripper_joint_name ? InterfaceOwner::NONE : InterfaceOwner::JOINTS;
+    }
+  }
+  // effort commands are not supported by the driver either
+  return InterfaceOwner::NONE;
+}
+
+double initialPosition(const hardware_interface::ComponentInfo & joint)
+{
+  for (const auto & state_interface : joint.state_interfaces)
+  {
+    if (
+      state_interface.name == hardware_interface::HW_IF_POSITION &&
+      !state_interface.initial_value.empty())
+    {
+      return std::stod(state_interface.initial_value);
+    }
+  }
+  return 0.0;
+}
+
+// Fraction of the remaining distance a first-order system covers in dt
+double firstOrderGain(double dt, double time_constant)
+{
+  return time_constant > 0.0 ? 1.0 - std::exp(-dt / time_constant) : 1.0;
+}
+}  // namespace
+
+namespace kortex_driver
+{
+CallbackReturn KortexFakeHardware::on_init(const hardware_interface::HardwareInfo & info)
+{
+  if (hardware_interface::SystemInterface::on_init(info) != CallbackReturn::SUCCESS)
+  {
+    return CallbackReturn::ERROR;
+  }
+  info_ = info;
+
+  gripper_joint_name_ = getOptionalParameter(info_, "gripper_joint_name", "");
+  gripper_speed_command_ = std::stod(getOptionalParameter(info_, "gripper_max_velocity", "100.0"));
+  gripper_force_command_ = std::stod(getOptionalParameter(info_, "gripper_max_force", "100.0"));
+
+  joint_time_constant_ =
+    std::stod(getOptionalParameter(info_, "fake_joint_time_constant_ms", "20")) / 1000.0;
+  gripper_time_constant_ =
+    std::stod(getOptionalParameter(info_, "fake_gripper_time_constant_ms", "100")) / 1000.0;
+  const int cyclic_latency_ms =
+    std::max(0, std::stoi(getOptionalParameter(info_, "fake_cyclic_latency_ms", "2")));
+  cyclic_latency_ns_ = static_cast<std::int64_t>(cyclic_latency_ms) * 1000000;
+  cyclic_failure_rate_ = std::stod(getOptionalParameter(info_, "fake_cyclic_failure_rate", "0"));
+  fault_rate_ = std::stod(getOptionalParameter(info_, "fake_fault_rate", "0"));
+  mode_switch_latency_ms_ =
+    std::max(0, std::stoi(getOptionalParameter(info_, "fake_mode_switch_latency_ms", "200")));
+  fault_reset_latency_ns_ =
+    static_cast<std::int64_t>(
+      std::max(0, std::stoi(getOptionalParameter(info_, "fake_fault_reset_latency_ms", "500")))) *
+    1000000;
+  random_engine_.seed(static_cast<std::mt19937::result_type>(
+    std::stoul(getOptionalParameter(info_, "fake_seed", "0"))));
+
+  lockstep_period_ns_ = static_cast<std::int64_t>(
+    std::stod(getOptionalParameter(info_, "fake_lockstep_period_ms", "0")) * 1e6);
+  if (lockstep() && isTrue(getOptionalParameter(info_, "fake_publish_clock", "false")))
+  {
+    // controllers and the controller manager follow the simulated time with use_sim_time
+    rclcpp::NodeOptions options;
+    options.start_parameter_services(false).start_parameter_event_publisher(false);
+    clock_node_ = std::make_shared<rclcpp::Node>("kortex_fake_clock", options);
+    clock_publisher_ =
+      clock_node_->create_publisher<rosgraph_msgs::msg::Clock>("/clock", rclcpp::ClockQoS());
+  }
+
+  const std::string sim_shared_memory_name = getOptionalParameter(info_, "sim_shared_memory", "");
+
+  arm_joint_names_.clear();
+  arm_positions_.clear();
+  for (const auto & joint : info_.joints)
+  {
+    if (joint.name == gripper_joint_name_)
+    {
+      gripper_position_ = initialPosition(joint);
+    }
+    else
+    {
+      arm_joint_names_.push_back(joint.name);
+      arm_positions_.push_back(initialPosition(joint));
+    }
+  }
+  actuator_count_ = arm_joint_names_.size();
+
+  arm_velocities_.assign(actuator_count_, 0.0);
+  arm_efforts_.assign(actuator_count_, 0.0);
+  external_efforts_.assign(actuator_count_, 0.0);
+  robot_positions_ = arm_positions_;
+  robot_velocities_ = arm_velocities_;
+  robot_efforts_ = arm_efforts_;
+  robot_gripper_position_ = gripper_position_;
+  joint_state_estimator_.configure(
+    actuator_count_, std::stod(getOptionalParameter(info_, "joint_state_filter_discount", "0.9")));
+  arm_commands_positions_ = arm_positions_;
+  arm_commands_velocities_.assign(actuator_count_, 0.0);
+  arm_commands_efforts_.assign(actuator_count_, 0.0);
+  target_positions_ = arm_positions_;
+  twist_commands_.assign(6, 0.0);
+  gripper_command_position_ = target_gripper_position_ = gripper_position_;
+
+  dynamics_feedforward_ = isTrue(getOptionalParameter(info_, "dynamics_feedforward", "false"));
+  dynamics_feedforward_terms_.configure(actuator_count_);
+  if (
+    dynamics_feedforward_ && !RobotDescription::loadModel(info_, arm_joint_names_, dynamics_model_))
+  {
+    return CallbackReturn::ERROR;
+  }
+
+  // one entry per millisecond of latency covers update rates up to 1 kHz
+  in_flight_.resize(static_cast<std::size_t>(cyclic_latency_ms) + 2);
+  for (auto & command : in_flight_)
+  {
+    command.positions.resize(actuator_count_);
+  }
+
+  if (!sim_shared_memory_name.empty())
+  {
+    if (!sim_shared_memory_.open(sim_shared_memory_name, actuator_count_))
+    {
+      return CallbackReturn::ERROR;
+    }
+    RCLCPP_INFO(
+      LOGGER, "Exchanging %zu actuators with a simulator through %s", actuator_count_,
+      sim_shared_memory_name.c_str());
+  }
+  else
+  {
+    RCLCPP_INFO(
+      LOGGER, "Simulating %zu actuators with a %d ms cyclic latency", actuator_count_,
+      cyclic_latency_ms);
+  }
+  if (lockstep())
+  {
+    RCLCPP_INFO(LOGGER, "Lockstep mode, each cycle advances %.3f ms", lockstep_period_ns_ / 1e6);
+  }
+  return CallbackReturn::SUCCESS;
+}
+
+std::vector<hardware_interface::StateInterface> KortexFakeHardware::export_state_interfaces()
+{
+  std::vector<hardware_interface::StateInterface> state_interfaces;
+
+  if (!gripper_joint_name_.empty())
+  {
+    state_interfaces.emplace_back(hardware_interface::StateInterface(
+      gripper_joint_name_, hardware_interface::HW_IF_POSITION, &gripper_position_));
+    state_interfaces.emplace_back(hardware_interface::StateInterface(
+      gripper_joint_name_, hardware_interface::HW_IF_VELOCITY, &gripper_velocity_));
+  }
+  for (std::size_t i = 0; i < actuator_count_; i++)
+  {
+    state_interfaces.emplace_back(hardware_interface::StateInterface(
+      arm_joint_names_[i], hardware_interface::HW_IF_POSITION, &arm_positions_[i]));
+    state_interfaces.emplace_back(hardware_interface::StateInterface(
+      arm_joint_names_[i], hardware_interface::HW_IF_VELOCITY, &arm_velocities_[i]));
+    state_interfaces.emplace_back(hardware_interface::StateInterface(
+      arm_joint_names_[i], hardware_interface::HW_IF_EFFORT, &arm_efforts_[i]));
+    state_interfaces.emplace_back(hardware_interface::StateInterface(
+      arm_joint_names_[i], "position_filtered", &joint_state_estimator_.positions()[i]));
+    state_interfaces.emplace_back(hardware_interface::StateInterface(
+      arm_joint_names_[i], "velocity_filtered", &joint_state_estimator_.velocities()[i]));
+    state_interfaces.emplace_back(hardware_interface::StateInterface(
+      arm_joint_names_[i], "acceleration", &joint_state_estimator_.accelerations()[i]));
+    state_interfaces.emplace_back(hardware_interface::StateInterface(
+      arm_joint_names_[i], "external_effort", &external_efforts_[i]));
+    state_interfaces.emplace_back(hardware_interface::StateInterface(
+      arm_joint_names_[i], "gravity_effort", &dynamics_feedforward_terms_.gravityEfforts()[i]));
+    state_interfaces.emplace_back(hardware_interface::StateInterface(
+      arm_joint_names_[i], "coriolis_effort", &dynamics_feedforward_terms_.coriolisEfforts()[i]));
+    state_interfaces.emplace_back(hardware_interface::StateInterface(
+      arm_joint_names_[i], "inertia", &dynamics_feedforward_terms_.inertias()[i]));
+  }
+
+  state_interfaces.emplace_back(
+    hardware_interface::StateInterface("reset_fault", "internal_fault", &in_fault_));
+
+  for (std::size_t i = 1; i < cyclic_statistics_.errors.size(); i++)
+  {
+    state_interfaces.emplace_back(hardware_interface::StateInterface(
+      "cyclic_stats", toString(static_cast<CyclicError>(i)), &cyclic_statistics_.errors[i]));
+  }
+  state_interfaces.emplace_back(
+    hardware_interface::StateInterface("cyclic_stats", "retries", &cyclic_statistics_.retries));
+  state_interfaces.emplace_back(hardware_interface::StateInterface(
+    "cyclic_stats", "failed_cycles", &cyclic_statistics_.failed_cycles));
+  state_interfaces.emplace_back(hardware_interface::StateInterface(
+    "cyclic_stats", "consecutive_failures", &cyclic_statistics_.consecutive_failures));
+  state_interfaces.emplace_back(hardware_interface::StateInterface(
+    "cyclic_stats", "last_error_sub_code", &cyclic_statistics_.last_error_sub_code));
+
+  state_interfaces.emplace_back(
+    hardware_interface::StateInterface("collision_detection", "contact", &contact_));
+
+  // there is no prediction of the states, these stay at zero
+  state_interfaces.emplace_back(hardware_interface::StateInterface(
+    "latency_compensation", "horizon", &latency_statistics_.horizon));
+  state_interfaces.emplace_back(hardware_interface::StateInterface(
+    "latency_compensation", "error_rms", &latency_statistics_.error_rms));
+  state_interfaces.emplace_back(hardware_interface::StateInterface(
+    "latency_compensation", "error_max", &latency_statistics_.error_max));
+  state_interfaces.emplace_back(hardware_interface::StateInterface(
+    "latency_compensation", "checked_predictions", &latency_statistics_.checked_predictions));
+
+  // there is no network, these stay at zero
+  for (const auto & channel :
+       {std::make_pair(std::string("tcp"), &tcp_traffic_rates_),
+        std::make_pair(std::string("udp"), &udp_traffic_rates_)})
+  {
+    state_interfaces.emplace_back(hardware_interface::StateInterface(
+      "network_stats", channel.first + "_tx_bytes_per_second",
+      &channel.second->tx_bytes_per_second));
+    state_interfaces.emplace_back(hardware_interface::StateInterface(
+      "network_stats", channel.first + "_rx_bytes_per_second",
+      &channel.second->rx_bytes_per_second));
+    state_interfaces.emplace_back(hardware_interface::StateInterface(
+      "network_stats", channel.first + "_tx_packets_per_second",
+      &channel.second->tx_packets_per_second));
+    state_interfaces.emplace_back(hardware_interface::StateInterface(
+      "network_stats", channel.first + "_rx_packets_per_second",
+      &channel.second->rx_packets_per_second));
+    state_interfaces.emplace_back(hardware_interface::StateInterface(
+      "network_stats", channel.first + "_tx_packets_per_cycle",
+      &channel.second->tx_packets_per_cycle));
+  }
+
+  return state_interfaces;
+}
+
+std::vector<hardware_interface::CommandInterface> KortexFakeHardware::export_command_interfaces()
+{
+  std::vector<hardware_interface::CommandInterface> command_interfaces;
+
+  if (!gripper_joint_name_.empty())
+  {
+    command_interfaces.emplace_back(hardware_interface::CommandInterface(
+      gripper_joint_name_, hardware_interface::HW_IF_POSITION, &gripper_command_position_));
+    command_interfaces.emplace_back(hardware_interface::CommandInterface(
+      gripper_joint_name_, "set_gripper_max_velocity", &gripper_speed_command_));
+    command_interfaces.emplace_back(hardware_interface::CommandInterface(
+      gripper_joint_name_, "set_gripper_max_effort", &gripper_force_command_));
+  }
+  for (std::size_t i = 0; i < actuator_count_; i++)
+  {
+    command_interfaces.emplace_back(hardware_interface::CommandInterface(
+      arm_joint_names_[i], hardware_interface::HW_IF_POSITION, &arm_commands_positions_[i]));
+    command_interfaces.emplace_back(hardware_interface::CommandInterface(
+      arm_joint_names_[i], hardware_interface::HW_IF_VELOCITY, &arm_commands_velocities_[i]));
+    command_interfaces.emplace_back(hardware_interface::CommandInterface(
+      arm_joint_names_[i], hardware_interface::HW_IF_EFFORT, &arm_commands_efforts_[i]));
+  }
+
+  const char * twist_names[] = {"twist.linear.x",  "twist.linear.y",  "twist.linear.z",
+                                "twist.angular.x", "twist.angular.y", "twist.angular.z"};
+  for (std::size_t i = 0; i < twist_commands_.size(); i++)
+  {
+    command_interfaces.emplace_back(
+      hardware_interface::CommandInterface("tcp", twist_names[i], &twist_commands_[i]));
+  }
+
+  command_interfaces.emplace_back(
+    hardware_interface::CommandInterface("reset_fault", "command", &reset_fault_cmd_));
+  command_interfaces.emplace_back(hardware_interface::CommandInterface(
+    "reset_fault", "async_success", &reset_fault_async_success_));
+
+  return command_interfaces;
+}
+
+return_type KortexFakeHardware::prepare_command_mode_switch(
+  const std::vector<std::string> & start_interfaces,
+  const std::vector<std::string> & stop_interfaces)
+{
+  stop_joint_based_controller_ = stop_twist_controller_ = stop_fault_controller_ =
+    stop_gripper_controller_ = false;
+  start_joint_based_controller_ = start_twist_controller_ = start_fault_controller_ =
+    start_gripper_controller_ = false;
+
+  // the driver blocks writes for this long before every switch, the simulated clock of the
+  // lockstep mode does not run meanwhile
+  if (!lockstep())
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(mode_switch_latency_ms_));
+  }
+
+  for (const auto & key : stop_interfaces)
+  {
+    switch (owner(key, info_, gripper_joint_name_))
+    {
+      case InterfaceOwner::JOINTS:
+        stop_joint_based_controller_ = true;
+        break;
+      case InterfaceOwner::TWIST:
+        stop_twist_controller_ = true;
+        break;
+      case InterfaceOwner::GRIPPER:
+        stop_gripper_controller_ = true;
+        break;
+      case InterfaceOwner::FAULT:
+        stop_fault_controller_ = true;
+        break;
+      case InterfaceOwner::NONE:
+        break;
+    }
+  }
+  for (const auto & key : start_interfaces)
+  {
+    switch (owner(key, info_, gripper_joint_name_))
+    {
+      case InterfaceOwner::JOINTS:
+        start_joint_based_controller_ = true;
+        break;
+      case InterfaceOwner::TWIST:
+        start_twist_controller_ = true;
+        break;
+      case InterfaceOwner::GRIPPER:
+        start_gripper_controller_ = true;
+        break;
+      case InterfaceOwner::FAULT:
+        start_fault_controller_ = true;
+        break;
+      case InterfaceOwner::NONE:
+        break;
+    }
+  }
+
+  if (twist_controller_running_ && start_joint_based_controller_ && !stop_twist_controller_)
+  {
+    RCLCPP_ERROR(LOGGER, "Can't start joint based controller while twist controller is running!");
+    return return_type::ERROR;
+  }
+  if (joint_based_controller_running_ && start_twist_controller_ && !stop_joint_based_controller_)
+  {
+    RCLCPP_ERROR(LOGGER, "Can't start twist controller while joint based controller is running!");
+    return return_type::ERROR;
+  }
+  return return_type::OK;
+}
+
+return_type KortexFakeHardware::perform_command_mode_switch(
+  const std::vector<std::string> & /*start_interfaces*/,
+  const std::vector<std::string> & /*stop_interfaces*/)
+{
+  KORTEX_RT_SECTION("perform_command_mode_switch");
+  if (stop_joint_based_controller_)
+  {
+    joint_based_controller_running_ = false;
+    arm_commands_positions_ = arm_positions_;
+    std::fill(arm_commands_velocities_.begin(), arm_commands_velocities_.end(), 0.0);
+  }
+  if (stop_twist_controller_)
+  {
+    twist_controller_running_ = false;
+    std::fill(twist_commands_.begin(), twist_commands_.end(), 0.0);
+  }
+  if (stop_gripper_controller_)
+  {
+    gripper_controller_running_ = false;
+    gripper_command_position_ = gripper_position_;
+  }
+  if (stop_fault_controller_)
+  {
+    fault_controller_running_ = false;
+  }
+
+  if (start_joint_based_controller_)
+  {
+    low_level_servoing_ = true;
+    twist_controller_running_ = false;
+    arm_commands_positions_ = arm_positions_;
+    std::fill(arm_commands_velocities_.begin(), arm_commands_velocities_.end(), 0.0);
+    joint_based_controller_running_ = true;
+  }
+  if (start_twist_controller_)
+  {
+    low_level_servoing_ = false;
+    joint_based_controller_running_ = false;
+    std::fill(twist_commands_.begin(), twist_commands_.end(), 0.0);
+    twist_controller_running_ = true;
+  }
+  if (start_gripper_controller_)
+  {
+    gripper_command_position_ = gripper_position_;
+    gripper_controller_running_ = true;
+  }
+  if (start_fault_controller_)
+  {
+    fault_controller_running_ = true;
+  }
+  return return_type::OK;
+}
+
+CallbackReturn KortexFakeHardware::on_activate(const rclcpp_lifecycle::State & /*previous_state*/)
+{
+  if (sim_shared_memory_.isOpen())
+  {
+    // hold the arm where the simulator has it rather than at the initial values of the urdf
+    readSimState();
+  }
+  publishRobotState();
+  target_positions_ = arm_positions_;
+  arm_commands_positions_ = arm_positions_;
+  target_gripper_position_ = gripper_command_position_ = gripper_position_;
+  in_flight_count_ = 0;
+  in_fault_ = 0.0;
+  fault_reset_done_ns_ = -1;
+  cyclic_statistics_.reset();
+  joint_state_estimator_.reset();
+  RCLCPP_INFO(LOGGER, "KortexFakeHardware successfully activated!");
+  return CallbackReturn::SUCCESS;
+}
+
+CallbackReturn KortexFakeHardware::on_deactivate(
+  const rclcpp_lifecycle::State & /*previous_state*/)
+{
+  RCLCPP_INFO(
+    LOGGER, "Cyclic channel: %.0f failed cycles, %.0f retries", cyclic_statistics_.failed_cycles,
+    cyclic_statistics_.retries);
+  return CallbackReturn::SUCCESS;
+}
+
+return_type KortexFakeHardware::read(const rclcpp::Time & time, const rclcpp::Duration & period)
+{
+  KORTEX_RT_SECTION("read");
+  std::int64_t now_ns = time.nanoseconds();
+  double dt = period.seconds();
+  if (lockstep())
+  {
+    lockstep_time_ns_ += lockstep_period_ns_;
+    now_ns = lockstep_time_ns_;
+    dt = lockstep_period_ns_ / 1e9;
+    if (clock_publisher_)
+    {
+      // publishing goes through the middleware, which allocates
+      KORTEX_RT_ALLOW();
+      clock_message_.clock.sec = static_cast<std::int32_t>(now_ns / 1000000000);
+      clock_message_.clock.nanosec = static_cast<std::uint32_t>(now_ns % 1000000000);
+      clock_publisher_->publish(clock_message_);
+    }
+  }
+
+  if (fault_reset_done_ns_ >= 0 && now_ns >= fault_reset_done_ns_)
+  {
+    fault_reset_done_ns_ = -1;
+    in_fault_ = 0.0;
+    reset_fault_async_success_ = 1.0;
+    target_positions_ = robot_positions_;
+  }
+
+  if (!sim_shared_memory_.isOpen())
+  {
+    deliverCommands(now_ns);
+  }
+
+  if (in_fault_ == 0.0 && injectFailure(fault_rate_))
+  {
+    KORTEX_RT_ALLOW();
+    RCLCPP_WARN(LOGGER, "Injected an arm fault");
+    in_fault_ = 1.0;
+  }
+  if (in_fault_ != 0.0)
+  {
+    // a faulted arm brakes where it is
+    target_positions_ = robot_positions_;
+  }
+
+  // the robot moves on whether or not its feedback gets through
+  if (sim_shared_memory_.isOpen())
+  {
+    readSimState();
+  }
+  else if (dt > 0.0)
+  {
+    const double joint_gain = firstOrderGain(dt, joint_time_constant_);
+    for (std::size_t i = 0; i < actuator_count_; i++)
+    {
+      const double step = (target_positions_[i] - robot_positions_[i]) * joint_gain;
+      robot_positions_[i] += step;
+      robot_velocities_[i] = step / dt;
+    }
+    const double gripper_step = (target_gripper_position_ - robot_gripper_position_) *
+                                firstOrderGain(dt, gripper_time_constant_);
+    robot_gripper_position_ += gripper_step;
+    robot_gripper_velocity_ = gripper_step / dt;
+  }
+
+  // a failed exchange keeps the previous feedback and loses this cycle's command
+  cycle_failed_ = injectFailure(cyclic_failure_rate_);
+  if (cycle_failed_)
+  {
+    cyclic_statistics_.record(CyclicError::KORTEX);
+    cyclic_statistics_.failed_cycles += 1.0;
+    cyclic_statistics_.consecutive_failures += 1.0;
+    return return_type::OK;
+  }
+  cyclic_statistics_.consecutive_failures = 0.0;
+
+  publishRobotState();
+  if (dt > 0.0)
+  {
+    joint_state_estimator_.update(arm_positions_, arm_velocities_, dt);
+  }
+  if (dynamics_feedforward_)
+  {
+    dynamics_feedforward_terms_.update(
+      dynamics_model_, arm_positions_, joint_state_estimator_.velocities());
+  }
+  return return_type::OK;
+}
+
+return_type KortexFakeHardware::write(
+  const rclcpp::Time & time, const rclcpp::Duration & /*period*/)
+{
+  KORTEX_RT_SECTION("write");
+  const std::int64_t now_ns = lockstep() ? lockstep_time_ns_ : time.nanoseconds();
+
+  if (!std::isnan(reset_fault_cmd_) && fault_controller_running_)
+  {
+    if (fault_reset_done_ns_ < 0)
+    {
+      fault_reset_done_ns_ = now_ns + fault_reset_latency_ns_;
+    }
+    reset_fault_cmd_ = NO_CMD;
+  }
+
+  if (sim_shared_memory_.isOpen())
+  {
+    // a faulted arm keeps receiving its braking targets
+    if (!cycle_failed_)
+    {
+      sendSimCommand(now_ns);
+    }
+  }
+  else if (in_fault_ == 0.0 && !cycle_failed_)
+  {
+    sendCommand(now_ns);
+  }
+  return return_type::OK;
+}
+
+bool KortexFakeHardware::injectFailure(double rate)
+{
+  return rate > 0.0 && uniform_(random_engine_) < rate;
+}
+
+void KortexFakeHardware::sendCommand(std::int64_t now_ns)
+{
+  // twist commands are accepted but not simulated, there is no kinematic model in here
+  const bool send_positions = low_level_servoing_ && joint_based_controller_running_;
+  const bool send_gripper =
+    gripper_controller_running_ && !gripper_joint_name_.empty() &&
+    !std::isnan(gripper_command_position_);
+  if (!send_positions && !send_gripper)
+  {
+    return;
+  }
+
+  if (in_flight_count_ == in_flight_.size())
+  {
+    in_flight_head_ = (in_flight_head_ + 1) % in_flight_.size();
+    in_flight_count_--;
+  }
+  InFlightCommand & command = in_flight_[(in_flight_head_ + in_flight_count_) % in_flight_.size()];
+  in_flight_count_++;
+
+  command.sent_ns = now_ns;
+  command.has_positions = send_positions;
+  if (send_positions)
+  {
+    for (std::size_t i = 0; i < actuator_count_; i++)
+    {
+      // the robot keeps its previous target when it receives an invalid one
+      command.positions[i] = std::isnan(arm_commands_positions_[i]) ? target_positions_[i]
+                                                                    : arm_commands_positions_[i];
+    }
+  }
+  command.has_gripper_position = send_gripper;
+  command.gripper_position = gripper_command_position_;
+}
+
+void KortexFakeHardware::deliverCommands(std::int64_t now_ns)
+{
+  while (in_flight_count_ > 0 && in_flight_[in_flight_head_].sent_ns + cyclic_latency_ns_ <= now_ns)
+  {
+    const InFlightCommand & command = in_flight_[in_flight_head_];
+    if (command.has_positions)
+    {
+      std::copy(command.positions.begin(), command.positions.end(), target_positions_.begin());
+    }
+    if (command.has_gripper_position)
+    {
+      target_gripper_position_ = command.gripper_position;
+    }
+    in_flight_head_ = (in_flight_head_ + 1) % in_flight_.size();
+    in_flight_count_--;
+  }
+}
+
+void KortexFakeHardware::sendSimCommand(std::int64_t now_ns)
+{
+  const bool send_positions = low_level_servoing_ && joint_based_controller_running_;
+  if (in_fault_ == 0.0)
+  {
+    if (send_positions)
+    {
+      for (std::size_t i = 0; i < actuator_count_; i++)
+      {
+        if (!std::isnan(arm_commands_positions_[i]))
+        {
+          target_positions_[i] = arm_commands_positions_[i];
+        }
+      }
+    }
+    if (
+      gripper_controller_running_ && !gripper_joint_name_.empty() &&
+      !std::isnan(gripper_command_position_))
+    {
+      target_gripper_position_ = gripper_command_position_;
+    }
+  }
+
+  // the stamp follows the simulated clock in lockstep mode, the simulator may step on it
+  sim_command_.stamp_ns = static_cast<std::uint64_t>(now_ns);
+  for (std::size_t i = 0; i < actuator_count_; i++)
+  {
+    sim_command_.positions[i] = target_positions_[i];
+    sim_command_.velocities[i] =
+      send_positions && in_fault_ == 0.0 && !std::isnan(arm_commands_velocities_[i])
+        ? arm_commands_velocities_[i]
+        : 0.0;
+  }
+  sim_command_.gripper_position = target_gripper_position_;
+  sim_shared_memory_.writeCommand(sim_command_);
+}
+
+void KortexFakeHardware::readSimState()
+{
+  // without a newer frame the previous states are kept, as with a skipped cyclic exchange
+  std::uint32_t sequence = 0;
+  if (!sim_shared_memory_.readState(sim_state_, sequence) || sequence == sim_state_sequence_)
+  {
+    return;
+  }
+  sim_state_sequence_ = sequence;
+  for (std::size_t i = 0; i < actuator_count_; i++)
+  {
+    robot_positions_[i] = sim_state_.positions[i];
+    robot_velocities_[i] = sim_state_.velocities[i];
+    robot_efforts_[i] = sim_state_.efforts[i];
+  }
+  robot_gripper_position_ = sim_state_.gripper_position;
+  robot_gripper_velocity_ = sim_state_.gripper_velocity;
+}
+
+void KortexFakeHardware::publishRobotState()
+{
+  std::copy(robot_positions_.begin(), robot_positions_.end(), arm_positions_.begin());
+  std::copy(robot_velocities_.begin(), robot_velocities_.end(), arm_velocities_.begin());
+  std::copy(robot_efforts_.begin(), robot_efforts_.end(), arm_efforts_.begin());
+  gripper_position_ = robot_gripper_position_;
+  gripper_velocity_ = robot_gripper_velocity_;
+}
+
+}  // namespace kortex_driver
+
+#include "pluginlib/class_list_macros.hpp"
+
+PLUGINLIB_EXPORT_CLASS(kortex_driver::KortexFakeHardware, hardware_interface::SystemInterface)
@@ -0,0 +1,59 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+
+#include "kortex_driver/feedback_snapshot.hpp"
+#include "kortex_driver/kortex_math_util.hpp"
+
+namespace kortex_driver
+{
+void FeedbackSnapshot::resize(std::size_t actuator_count)
+{
+  positions.resize(actuator_count, 0.0);
+  velocities.resize(actuator_count, 0.0);
+  efforts.resize(actuator_count, 0.0);
+}
+
+void FeedbackSnapshot::decode(const k_api::BaseCyclic::Feedback & feedback, bool with_gripper)
+{
+  const std::size_t count =
+    std::min(positions.size(), static_cast<std::size_t>(feedback.actuators_size()));
+
+  decodeBase(feedback, with_gripper);
+  for (std::size_t i = 0; i < count; i++)
+  {
+    const auto & actuator = feedback.actuators(static_cast<int>(i));
+    positions[i] =
+      KortexMathUtil::wrapRadiansFromMinusPiToPi(KortexMathUtil::toRad(actuator.position()));
+    velocities[i] = KortexMathUtil::toRad(actuator.velocity());
+    efforts[i] = actuator.torque();
+    faults += actuator.fault_bank_a() + actuator.fault_bank_b();
+  }
+}
+
+void FeedbackSnapshot::decodeBase(const k_api::BaseCyclic::Feedback & feedback, bool with_gripper)
+{
+  base_faults = feedback.base().fault_bank_a() + feedback.base().fault_bank_b();
+  faults = base_faults;
+  active_state = feedback.base().active_state();
+  if (with_gripper)
+  {
+    // a frame without gripper motor reads as zero, as the fields of an absent message do
+    const auto & motors = feedback.interconnect().gripper_feedback().motor();
+    gripper_position = motors.empty() ? 0.0 : motors[0].position();
+  }
+}
+
+}  // namespace kortex_driver
@@ -22,34 +22,57 @@
  */
 //----------------------------------------------------------------------
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <cstring>
 #include <exception>
+#include <future>
 #include <limits>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "kortex_driver/hardware_interface.hpp"
+#include "kortex_driver/hardware_parameters.hpp"
 #include "kortex_driver/kortex_math_util.hpp"
+#include "kortex_driver/robot_description.hpp"
+#include "kortex_driver/rt_safety.hpp"
+#include "kortex_driver/udp_realtime_transport.hpp"
+#ifdef KORTEX_DRIVER_WITH_IO_URING
+#include "kortex_driver/io_uring_transport.hpp"
+#endif
 
 #include "hardware_interface/types/hardware_interface_type_values.hpp"
 #include "rclcpp/rclcpp.hpp"
 
+#include "HeaderInfo.h"
+
 namespace
 {
 const rclcpp::Logger LOGGER = rclcpp::get_logger("KortexMultiInterfaceHardware");
+// version of the BaseCyclic service the frames sent through the router are addressed to
+constexpr std::uint32_t BASE_CYCLIC_SERVICE_VERSION = 1;
+
+std::int64_t steadyNanoseconds()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch())
+    .count();
 }
+}  // namespace
 
 namespace kortex_driver
 {
 KortexMultiInterfaceHardware::KortexMultiInterfaceHardware()
-: router_tcp_{
-    &transport_tcp_,
+: metered_transport_tcp_{&transport_tcp_},
+  router_tcp_{
+    &metered_transport_tcp_,
     [](k_api::KError err) { cout << "_________ callback error _________" << err.toString(); }},
   session_manager_{&router_tcp_},
+  metered_transport_udp_realtime_{&transport_udp_realtime_},
   router_udp_realtime_{
-    &transport_udp_realtime_,
+    &metered_transport_udp_realtime_,
     [](k_api::KError err) { cout << "_________ callback error _________" << err.toString(); }},
   session_manager_real_time_{&router_udp_realtime_},
   k_api_twist_(nullptr),
@@ -179,11 +202,180 @@ CallbackReturn KortexMultiInterfaceHardware::on_init(const hardware_interface::H
   gripper_command_max_velocity_ = std::stod(info_.hardware_parameters["gripper_max_velocity"]);
   gripper_command_max_force_ = std::stod(info_.hardware_parameters["gripper_max_force"]);
 
+  // retry and skip policy of the cyclic channel
+  int cyclic_max_retries = std::stoi(getOptionalParameter(info_, "cyclic_max_retries", "0"));
+  int cyclic_timeout = std::stoi(getOptionalParameter(info_, "cyclic_timeout_ms", "3000"));
+  int cyclic_max_consecutive_failures =
+    std::stoi(getOptionalParameter(info_, "cyclic_max_consecutive_failures", "0"));
+  if (cyclic_max_retries < 0 || cyclic_timeout <= 0 || cyclic_max_consecutive_failures < 0)
+  {
+    RCLCPP_ERROR(LOGGER, "Incorrect cyclic retry policy!");
+    return CallbackReturn::ERROR;
+  }
+  cyclic_retry_policy_.max_retries = static_cast<std::uint32_t>(cyclic_max_retries);
+  cyclic_retry_policy_.timeout_ms = static_cast<std::uint32_t>(cyclic_timeout);
+  cyclic_retry_policy_.max_consecutive_failures =
+    static_cast<std::uint32_t>(cyclic_max_consecutive_failures);
+  cyclic_preencoded_command_ =
+    isTrue(getOptionalParameter(info_, "cyclic_preencoded_command", "true"));
+  const std::string cyclic_on_failure = getOptionalParameter(info_, "cyclic_on_failure", "skip");
+  if (!CyclicRetryPolicy::parseFailureAction(cyclic_on_failure, cyclic_retry_policy_.on_failure))
+  {
+    RCLCPP_ERROR(
+      LOGGER, "Unknown cyclic_on_failure '%s'. Expected 'skip' or 'refresh_feedback'.",
+      cyclic_on_failure.c_str());
+    return CallbackReturn::ERROR;
+  }
+  RCLCPP_INFO(
+    LOGGER, "Cyclic retry policy: %u retries, %u ms timeout, on failure '%s'",
+    cyclic_retry_policy_.max_retries, cyclic_retry_policy_.timeout_ms, cyclic_on_failure.c_str());
+
+  // keep-alive rate when no controller is running, it has to stay below the session timeouts
+  int idle_refresh_period = std::stoi(getOptionalParameter(info_, "idle_refresh_period_ms", "0"));
+  const int max_idle_refresh_period =
+    std::min(session_inactivity_timeout, connection_inactivity_timeout) / 2;
+  if (idle_refresh_period < 0)
+  {
+    RCLCPP_ERROR(LOGGER, "Incorrect idle refresh period!");
+    return CallbackReturn::ERROR;
+  }
+  if (idle_refresh_period > max_idle_refresh_period)
+  {
+    RCLCPP_WARN(
+      LOGGER, "Idle refresh period of %d ms is too close to the inactivity timeouts, using %d ms",
+      idle_refresh_period, max_idle_refresh_period);
+    idle_refresh_period = max_idle_refresh_period;
+  }
+  idle_refresh_period_ns_ = static_cast<std::int64_t>(idle_refresh_period) * 1000000;
+  RCLCPP_INFO(LOGGER, "Idle refresh period is '%d' ms", idle_refresh_period);
+
+  int traffic_stats_window =
+    std::stoi(getOptionalParameter(info_, "traffic_stats_window_ms", "1000"));
+  if (traffic_stats_window <= 0)
+  {
+    RCLCPP_ERROR(LOGGER, "Incorrect traffic statistics window!");
+    return CallbackReturn::ERROR;
+  }
+  traffic_stats_window_ = traffic_stats_window / 1000.0;
+
+  // configured once the number of actuators is known
+  const double joint_state_filter_discount =
+    std::stod(getOptionalParameter(info_, "joint_state_filter_discount", "0.9"));
+  const bool latency_compensation =
+    isTrue(getOptionalParameter(info_, "latency_compensation", "false"));
+  const double latency_compensation_max_horizon =
+    std::stod(getOptionalParameter(info_, "latency_compensation_max_horizon_ms", "20")) / 1000.0;
+  const double latency_compensation_smoothing =
+    std::stod(getOptionalParameter(info_, "latency_compensation_smoothing", "0.05"));
+
+  rt_lock_memory_ = isTrue(getOptionalParameter(info_, "rt_lock_memory", "false"));
+  rt_prefault_heap_size_ = static_cast<std::size_t>(
+    std::max(0, std::stoi(getOptionalParameter(info_, "rt_prefault_heap_kb", "8192")))) * 1024;
+  rt_prefault_stack_size_ = static_cast<std::size_t>(
+    std::max(0, std::stoi(getOptionalParameter(info_, "rt_prefault_stack_kb", "64")))) * 1024;
+
+  // transport of the cyclic channel
+  const std::string udp_transport = getOptionalParameter(info_, "udp_transport", "kortex");
+  if (udp_transport == "driver")
+  {
+    UdpTransportOptions udp_options;
+    udp_options.busy_poll_us = std::stoi(getOptionalParameter(info_, "udp_busy_poll_us", "0"));
+    udp_options.socket_priority =
+      std::stoi(getOptionalParameter(info_, "udp_socket_priority", "-1"));
+    udp_options.dscp = std::stoi(getOptionalParameter(info_, "udp_dscp", "-1"));
+    udp_options.timestamping = isTrue(getOptionalParameter(info_, "udp_timestamping", "false"));
+    udp_options.spin_wait = isTrue(getOptionalParameter(info_, "udp_spin_wait", "false"));
+    udp_options.receive_batch = static_cast<std::size_t>(
+      std::max(1, std::stoi(getOptionalParameter(info_, "udp_receive_batch", "4"))));
+    auto udp_realtime_transport = std::make_unique<UdpRealtimeTransport>(udp_options);
+    udp_realtime_transport_ = udp_realtime_transport.get();
+    driver_transport_udp_realtime_ = std::move(udp_realtime_transport);
+    metered_transport_udp_realtime_.setTransport(driver_transport_udp_realtime_.get());
+    RCLCPP_INFO(LOGGER, "Using the driver UDP transport for the realtime channel");
+  }
+  else if (udp_transport == "io_uring")
+  {
+#ifdef KORTEX_DRIVER_WITH_IO_URING
+    // the ring is shared with every other arm driven by this process
+    const int uring_entries = std::stoi(getOptionalParameter(info_, "io_uring_entries", "64"));
+    const int uring_max_sockets =
+      std::stoi(getOptionalParameter(info_, "io_uring_max_sockets", "8"));
+    if (uring_entries <= 0 || (uring_entries & (uring_entries - 1)) != 0)
+    {
+      RCLCPP_ERROR(LOGGER, "io_uring_entries must be a positive power of two!");
+      return CallbackReturn::ERROR;
+    }
+    if (uring_max_sockets <= 0)
+    {
+      RCLCPP_ERROR(LOGGER, "Incorrect io_uring_max_sockets!");
+      return CallbackReturn::ERROR;
+    }
+    IoUringOptions uring_options;
+    uring_options.entries = static_cast<unsigned>(uring_entries);
+    uring_options.sqpoll = isTrue(getOptionalParameter(info_, "io_uring_sqpoll", "false"));
+    uring_options.max_sockets = static_cast<std::size_t>(uring_max_sockets);
+    auto reactor = IoUringReactor::shared(uring_options);
+    if (!reactor)
+    {
+      return CallbackReturn::ERROR;
+    }
+    driver_transport_udp_realtime_ = std::make_unique<IoUringUdpTransport>(reactor);
+    metered_transport_udp_realtime_.setTransport(driver_transport_udp_realtime_.get());
+    RCLCPP_INFO(LOGGER, "Using the io_uring transport for the realtime channel");
+#else
+    RCLCPP_ERROR(LOGGER, "kortex_driver was built without io_uring support!");
+    return CallbackReturn::ERROR;
+#endif
+  }
+  else if (udp_transport != "kortex")
+  {
+    RCLCPP_ERROR(
+      LOGGER, "Unknown udp_transport '%s'. Expected 'kortex', 'driver' or 'io_uring'.",
+      udp_transport.c_str());
+    return CallbackReturn::ERROR;
+  }
+
+  // optional pcapng capture of the frames of each channel
+  const std::string capture_tcp_file = getOptionalParameter(info_, "capture_tcp_file", "");
+  const std::string capture_udp_file = getOptionalParameter(info_, "capture_udp_file", "");
+  const std::size_t capture_queue_size = static_cast<std::size_t>(
+    std::max(1, std::stoi(getOptionalParameter(info_, "capture_queue_size", "4096"))));
+  const std::uint32_t capture_snap_length = static_cast<std::uint32_t>(
+    std::max(1, std::stoi(getOptionalParameter(info_, "capture_snap_length", "2048"))));
+  if (!capture_tcp_file.empty())
+  {
+    capture_transport_tcp_ = std::make_unique<CaptureTransport>(
+      &transport_tcp_, capture_tcp_file, "kortex_tcp", capture_queue_size, capture_snap_length);
+    if (!capture_transport_tcp_->start())
+    {
+      return CallbackReturn::ERROR;
+    }
+    metered_transport_tcp_.setTransport(capture_transport_tcp_.get());
+  }
+  if (!capture_udp_file.empty())
+  {
+    k_api::ITransportClient * udp_transport_client =
+      driver_transport_udp_realtime_ ? driver_transport_udp_realtime_.get()
+                                     : &transport_udp_realtime_;
+    capture_transport_udp_realtime_ = std::make_unique<CaptureTransport>(
+      udp_transport_client, capture_udp_file, "kortex_udp", capture_queue_size,
+      capture_snap_length);
+    if (!capture_transport_udp_realtime_->start())
+    {
+      return CallbackReturn::ERROR;
+    }
+    metered_transport_udp_realtime_.setTransport(capture_transport_udp_realtime_.get());
+  }
+
   RCLCPP_INFO_STREAM(LOGGER, "Connecting to robot at " << robot_ip);
 
   // connections
   transport_tcp_.connect(robot_ip, port);
-  transport_udp_realtime_.connect(robot_ip, port_realtime);
+  if (!metered_transport_udp_realtime_.connect(robot_ip, port_realtime))
+  {
+    RCLCPP_ERROR(LOGGER, "Could not open the realtime channel!");
+    return CallbackReturn::ERROR;
+  }
 
   // Set session data connection information
   auto create_session_info = k_api::Session::CreateSessionInfo();
@@ -195,19 +387,20 @@ CallbackReturn KortexMultiInterfaceHardware::on_init(const hardware_interface::H
 
   // Session manager service wrapper
   RCLCPP_INFO(LOGGER, "Creating session for communication");
-  session_manager_.CreateSession(create_session_info);
+  rpc_executor_.start();
+  rpc_executor_.call([&]() { session_manager_.CreateSession(create_session_info); });
   session_manager_real_time_.CreateSession(create_session_info);
   RCLCPP_INFO(LOGGER, "Session created");
 
   // reset faults on activation, go back to low level servoing after
   {
     servoing_mode_hw_.set_servoing_mode(Kinova::Api::Base::SINGLE_LEVEL_SERVOING);
-    base_.SetServoingMode(servoing_mode_hw_);
+    rpc_executor_.call([this]() { base_.SetServoingMode(servoing_mode_hw_); });
     arm_mode_ = Kinova::Api::Base::SINGLE_LEVEL_SERVOING;
 
     try
     {
-      base_.ClearFaults();
+      rpc_executor_.call([this]() { base_.ClearFaults(); });
     }
     catch (k_api::KDetailedException & ex)
     {
@@ -221,7 +414,7 @@ CallbackReturn KortexMultiInterfaceHardware::on_init(const hardware_interface::H
     // low level servoing on startup
     servoing_mode_hw_.set_servoing_mode(Kinova::Api::Base::LOW_LEVEL_SERVOING);
     arm_mode_ = Kinova::Api::Base::LOW_LEVEL_SERVOING;
-    base_.SetServoingMode(servoing_mode_hw_);
+    rpc_executor_.call([this]() { base_.SetServoingMode(servoing_mode_hw_); });
   }
 
   // initialize kortex api twist commandd
@@ -234,10 +427,74 @@ CallbackReturn KortexMultiInterfaceHardware::on_init(const hardware_interface::H
     k_api_twist_ = k_api_twist_command_.mutable_twist();
   }
 
+  // the actuator count is always needed, the devices only by actuator_cyclic and the gripper
+  // presence only by use_internal_bus_gripper_comm
+  const bool query_devices = isTrue(getOptionalParameter(info_, "actuator_cyclic", "false"));
+  const bool query_gripper =
+    isTrue(getOptionalParameter(info_, "use_internal_bus_gripper_comm", "false"));
+  const int configuration_rpcs = 1 + (query_devices ? 1 : 0) + (query_gripper ? 1 : 0);
+  // checking the cache takes two rpcs, the serial number and the firmware version, so it only
+  // saves some when it replaces all three queries
+  const bool use_config_cache =
+    configuration_rpcs > 2 && isTrue(getOptionalParameter(info_, "use_config_cache", "true"));
+  const RobotConfigCache config_cache(
+    getOptionalParameter(info_, "config_cache_dir", RobotConfigCache::defaultDirectory()));
+  bool config_cached = false;
+  // the arm settles in low level servoing before it is queried, and before on_activate
   std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  try
+  {
+    if (use_config_cache)
+    {
+      // the entry is only used if it was written for this robot and this firmware
+      k_api::DeviceConfig::DeviceConfigClient device_config(&router_tcp_);
+      rpc_executor_.call(
+        [&]()
+        {
+          robot_configuration_.serial_number = device_config.GetSerialNumber().serial_number();
+          robot_configuration_.firmware_version =
+            device_config.GetFirmwareVersion().firmware_version();
+        });
+      config_cached = config_cache.load(
+        robot_configuration_.serial_number, robot_configuration_.firmware_version,
+        robot_configuration_);
+    }
+    if (!config_cached)
+    {
+      if (use_config_cache)
+      {
+        // an entry holds the whole configuration, whatever the parameters of the next start
+        rpc_executor_.call([&]() { queryRobotConfiguration(robot_configuration_, true, true); });
+        if (config_cache.store(robot_configuration_))
+        {
+          RCLCPP_INFO(
+            LOGGER, "Robot configuration saved to '%s'",
+            config_cache.path(robot_configuration_.serial_number).c_str());
+        }
+      }
+      else
+      {
+        rpc_executor_.call(
+          [&]() { queryRobotConfiguration(robot_configuration_, query_devices, query_gripper); });
+      }
+    }
+  }
+  catch (k_api::KDetailedException & ex)
+  {
+    RCLCPP_ERROR_STREAM(LOGGER, "Could not read the robot configuration: " << ex.what());
+    return CallbackReturn::ERROR;
+  }
 
-  actuator_count_ = base_.GetActuatorCount().count();
-  RCLCPP_INFO(LOGGER, "Actuator count reported by robot is '%lu'", actuator_count_);
+  actuator_count_ = robot_configuration_.actuator_count;
+  RCLCPP_INFO(
+    LOGGER, "Actuator count %s is '%lu'",
+    config_cached ? "from the configuration cache" : "reported by robot", actuator_count_);
+  if (config_cached)
+  {
+    RCLCPP_INFO(
+      LOGGER, "Configuration cache saved %d of %d rpcs", configuration_rpcs - 2,
+      configuration_rpcs);
+  }
 
   arm_positions_.resize(actuator_count_, std::numeric_limits<double>::quiet_NaN());
   arm_velocities_.resize(actuator_count_, std::numeric_limits<double>::quiet_NaN());
@@ -247,6 +504,60 @@ CallbackReturn KortexMultiInterfaceHardware::on_init(const hardware_interface::H
   arm_commands_efforts_.resize(actuator_count_, std::numeric_limits<double>::quiet_NaN());
   arm_joints_control_level_.resize(
     actuator_count_, integration_lvl_t::UNDEFINED);  // start in undefined
+  feedback_snapshot_.resize(actuator_count_);
+  joint_state_estimator_.configure(actuator_count_, joint_state_filter_discount);
+  latency_predictor_.configure(
+    actuator_count_, latency_compensation, latency_compensation_max_horizon,
+    latency_compensation_smoothing);
+  if (latency_predictor_.enabled())
+  {
+    RCLCPP_INFO(
+      LOGGER, "Joint states are predicted over the cyclic delay, up to %.1f ms",
+      latency_compensation_max_horizon * 1000.0);
+  }
+
+  collision_detection_ = isTrue(getOptionalParameter(info_, "collision_detection", "false"));
+  collision_reflex_ = isTrue(getOptionalParameter(info_, "collision_reflex", "false"));
+  collision_detector_.configure(
+    actuator_count_, std::stod(getOptionalParameter(info_, "collision_observer_gain", "50")),
+    parseDoubles(getOptionalParameter(info_, "collision_thresholds", "10")),
+    std::stoi(getOptionalParameter(info_, "collision_confirmation_cycles", "2")));
+  reflex_hold_positions_.assign(actuator_count_, 0.0);
+  dynamics_feedforward_ = isTrue(getOptionalParameter(info_, "dynamics_feedforward", "false"));
+  dynamics_feedforward_terms_.configure(actuator_count_);
+  if ((collision_detection_ || dynamics_feedforward_) && !loadDynamicsModel())
+  {
+    return CallbackReturn::ERROR;
+  }
+  if (collision_detection_)
+  {
+    RCLCPP_INFO(
+      LOGGER, "Collision detection enabled, reflex stop %s", collision_reflex_ ? "on" : "off");
+  }
+
+  const std::string command_shared_memory_name =
+    getOptionalParameter(info_, "command_shared_memory", "");
+  shared_command_timeout_ns_ = static_cast<std::int64_t>(
+    std::stod(getOptionalParameter(info_, "command_shared_memory_timeout_ms", "50")) * 1e6);
+  shared_command_max_velocity_ =
+    std::stod(getOptionalParameter(info_, "command_shared_memory_max_velocity", "1.0"));
+  shared_command_positions_.assign(actuator_count_, 0.0);
+  shared_command_velocities_.assign(actuator_count_, 0.0);
+  if (!command_shared_memory_name.empty())
+  {
+    std::vector<std::string> joint_names;
+    if (
+      !armJointNames(joint_names) ||
+      !RobotDescription::loadPositionLimits(
+        info_, joint_names, shared_command_lower_limits_, shared_command_upper_limits_) ||
+      !command_shared_memory_.open(command_shared_memory_name, actuator_count_))
+    {
+      return CallbackReturn::ERROR;
+    }
+    RCLCPP_INFO(
+      LOGGER, "Joint commands are also taken from shared memory %s",
+      command_shared_memory_name.c_str());
+  }
   gripper_command_position_ = std::numeric_limits<double>::quiet_NaN();
   gripper_position_ = std::numeric_limits<double>::quiet_NaN();
 
@@ -278,12 +589,70 @@ CallbackReturn KortexMultiInterfaceHardware::on_init(const hardware_interface::H
     }
   }
 
-  if (
-    (info_.hardware_parameters["use_internal_bus_gripper_comm"] == "true") ||
-    (info_.hardware_parameters["use_internal_bus_gripper_comm"] == "True"))
+  if (isTrue(info_.hardware_parameters["use_internal_bus_gripper_comm"]))
   {
     use_internal_bus_gripper_comm_ = true;
     RCLCPP_INFO(LOGGER, "Using internal bus communication for gripper!");
+    if (!robot_configuration_.gripper_installed)
+    {
+      RCLCPP_WARN(LOGGER, "The robot reports no gripper installed!");
+    }
+  }
+
+  if (isTrue(getOptionalParameter(info_, "actuator_cyclic", "false")))
+  {
+    ActuatorCyclicRouting routing;
+    const std::string routing_name =
+      getOptionalParameter(info_, "actuator_cyclic_routing", "shared");
+    if (!parseActuatorCyclicRouting(routing_name, routing))
+    {
+      RCLCPP_ERROR(
+        LOGGER, "Unknown actuator_cyclic_routing '%s'. Expected 'shared' or 'dedicated'.",
+        routing_name.c_str());
+      return CallbackReturn::ERROR;
+    }
+    actuator_cyclic_base_period_ =
+      std::max(1, std::stoi(getOptionalParameter(info_, "actuator_cyclic_base_period", "10")));
+
+    // the actuators in the order of the joints they drive
+    std::vector<RobotConfiguration::Device> actuators;
+    for (const auto & device : robot_configuration_.devices)
+    {
+      if (
+        device.type == k_api::Common::BIG_ACTUATOR ||
+        device.type == k_api::Common::MEDIUM_ACTUATOR ||
+        device.type == k_api::Common::SMALL_ACTUATOR)
+      {
+        actuators.push_back(device);
+      }
+    }
+    std::sort(
+      actuators.begin(), actuators.end(),
+      [](const RobotConfiguration::Device & a, const RobotConfiguration::Device & b)
+      { return a.order < b.order; });
+    if (actuators.size() != actuator_count_)
+    {
+      RCLCPP_ERROR(
+        LOGGER, "Found %zu actuator devices for %zu actuators!", actuators.size(),
+        actuator_count_);
+      return CallbackReturn::ERROR;
+    }
+    std::vector<std::uint32_t> device_ids;
+    for (const auto & actuator : actuators)
+    {
+      device_ids.push_back(actuator.identifier);
+    }
+    if (!actuator_cyclic_channel_.open(
+          device_ids, routing, &router_udp_realtime_, robot_ip,
+          static_cast<std::uint32_t>(port_realtime), create_session_info))
+    {
+      return CallbackReturn::ERROR;
+    }
+    if (use_internal_bus_gripper_comm_)
+    {
+      RCLCPP_WARN(
+        LOGGER, "Gripper commands are not sent while the joints are commanded per actuator!");
+    }
   }
 
   RCLCPP_INFO(LOGGER, "Hardware Interface successfully configured");
@@ -320,12 +689,90 @@ KortexMultiInterfaceHardware::export_state_interfaces()
       arm_joint_names[i], hardware_interface::HW_IF_VELOCITY, &arm_velocities_[i]));
     state_interfaces.emplace_back(hardware_interface::StateInterface(
       arm_joint_names[i], hardware_interface::HW_IF_EFFORT, &arm_efforts_[i]));
+    state_interfaces.emplace_back(hardware_interface::StateInterface(
+      arm_joint_names[i], "position_filtered", &joint_state_estimator_.positions()[i]));
+    state_interfaces.emplace_back(hardware_interface::StateInterface(
+      arm_joint_names[i], "velocity_filtered", &joint_state_estimator_.velocities()[i]));
+    state_interfaces.emplace_back(hardware_interface::StateInterface(
+      arm_joint_names[i], "acceleration", &joint_state_estimator_.accelerations()[i]));
+    state_interfaces.emplace_back(hardware_interface::StateInterface(
+      arm_joint_names[i], "external_effort", &collision_detector_.externalTorques()[i]));
+    state_interfaces.emplace_back(hardware_interface::StateInterface(
+      arm_joint_names[i], "gravity_effort", &dynamics_feedforward_terms_.gravityEfforts()[i]));
+    state_interfaces.emplace_back(hardware_interface::StateInterface(
+      arm_joint_names[i], "coriolis_effort", &dynamics_feedforward_terms_.coriolisEfforts()[i]));
+    state_interfaces.emplace_back(hardware_interface::StateInterface(
+      arm_joint_names[i], "inertia", &dynamics_feedforward_terms_.inertias()[i]));
   }
 
   // state interface which reports if robot is faulted
   state_interfaces.emplace_back(
     hardware_interface::StateInterface("reset_fault", "internal_fault", &in_fault_));
 
+  // cyclic channel error counters
+  for (std::size_t i = 1; i < cyclic_statistics_.errors.size(); i++)
+  {
+    state_interfaces.emplace_back(hardware_interface::StateInterface(
+      "cyclic_stats", toString(static_cast<CyclicError>(i)), &cyclic_statistics_.errors[i]));
+  }
+  state_interfaces.emplace_back(
+    hardware_interface::StateInterface("cyclic_stats", "retries", &cyclic_statistics_.retries));
+  state_interfaces.emplace_back(hardware_interface::StateInterface(
+    "cyclic_stats", "failed_cycles", &cyclic_statistics_.failed_cycles));
+  state_interfaces.emplace_back(hardware_interface::StateInterface(
+    "cyclic_stats", "consecutive_failures", &cyclic_statistics_.consecutive_failures));
+  state_interfaces.emplace_back(hardware_interface::StateInterface(
+    "cyclic_stats", "last_error_sub_code", &cyclic_statistics_.last_error_sub_code));
+
+  // timing of the exchanges with each actuator, only with actuator_cyclic
+  if (actuator_cyclic_channel_.isOpen())
+  {
+    for (std::size_t i = 0; i < arm_joint_names.size(); i++)
+    {
+      state_interfaces.emplace_back(hardware_interface::StateInterface(
+        arm_joint_names[i], "actuator_round_trip", &actuator_cyclic_channel_.roundTrips()[i]));
+      state_interfaces.emplace_back(hardware_interface::StateInterface(
+        arm_joint_names[i], "actuator_jitter", &actuator_cyclic_channel_.jitters()[i]));
+    }
+  }
+
+  // contact reported by the collision detector, latched until the next fault reset
+  state_interfaces.emplace_back(hardware_interface::StateInterface(
+    "collision_detection", "contact", &collision_detector_.contact()));
+
+  // horizon and accuracy of the latency compensation
+  LatencyPredictionStatistics & latency_statistics = latency_predictor_.statistics();
+  state_interfaces.emplace_back(hardware_interface::StateInterface(
+    "latency_compensation", "horizon", &latency_statistics.horizon));
+  state_interfaces.emplace_back(hardware_interface::StateInterface(
+    "latency_compensation", "error_rms", &latency_statistics.error_rms));
+  state_interfaces.emplace_back(hardware_interface::StateInterface(
+    "latency_compensation", "error_max", &latency_statistics.error_max));
+  state_interfaces.emplace_back(hardware_interface::StateInterface(
+    "latency_compensation", "checked_predictions", &latency_statistics.checked_predictions));
+
+  // network throughput per channel
+  for (const auto & channel :
+       {std::make_pair(std::string("tcp"), &tcp_traffic_rates_),
+        std::make_pair(std::string("udp"), &udp_traffic_rates_)})
+  {
+    state_interfaces.emplace_back(hardware_interface::StateInterface(
+      "network_stats", channel.first + "_tx_bytes_per_second",
+      &channel.second->tx_bytes_per_second));
+    state_interfaces.emplace_back(hardware_interface::StateInterface(
+      "network_stats", channel.first + "_rx_bytes_per_second",
+      &channel.second->rx_bytes_per_second));
+    state_interfaces.emplace_back(hardware_interface::StateInterface(
+      "network_stats", channel.first + "_tx_packets_per_second",
+      &channel.second->tx_packets_per_second));
+    state_interfaces.emplace_back(hardware_interface::StateInterface(
+      "network_stats", channel.first + "_rx_packets_per_second",
+      &channel.second->rx_packets_per_second));
+    state_interfaces.emplace_back(hardware_interface::StateInterface(
+      "network_stats", channel.first + "_tx_packets_per_cycle",
+      &channel.second->tx_packets_per_cycle));
+  }
+
   return state_interfaces;
 }
 
@@ -585,13 +1032,15 @@ return_type KortexMultiInterfaceHardware::prepare_command_mode_switch(
 return_type KortexMultiInterfaceHardware::perform_command_mode_switch(
   const vector<std::string> & /*start_interfaces*/, const vector<std::string> & /*stop_interfaces*/)
 {
+  KORTEX_RT_SECTION("perform_command_mode_switch");
   hardware_interface::return_type ret_val = hardware_interface::return_type::OK;
 
   if (stop_joint_based_controller_)
   {
     joint_based_controller_running_ = false;
     arm_commands_positions_ = arm_positions_;
-    arm_commands_velocities_ = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    std::fill(arm_commands_velocities_.begin(), arm_commands_velocities_.end(), 0.0);
+    shared_command_active_ = false;
   }
   if (stop_twist_controller_)
   {
@@ -610,21 +1059,17 @@ return_type KortexMultiInterfaceHardware::perform_command_mode_switch(
 
   if (start_joint_based_controller_)
   {
-    servoing_mode_hw_.set_servoing_mode(k_api::Base::ServoingMode::LOW_LEVEL_SERVOING);
-    base_.SetServoingMode(servoing_mode_hw_);
-    arm_mode_ = k_api::Base::ServoingMode::LOW_LEVEL_SERVOING;
+    // the new mode is only used by write() once the rpc completed
+    requestServoingMode(k_api::Base::ServoingMode::LOW_LEVEL_SERVOING);
     twist_controller_running_ = false;
     arm_commands_positions_ = arm_positions_;
-    arm_commands_velocities_ = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    std::fill(arm_commands_velocities_.begin(), arm_commands_velocities_.end(), 0.0);
+    shared_command_active_ = false;
     joint_based_controller_running_ = true;
-    // refresh feedback
-    feedback_ = base_cyclic_.RefreshFeedback();
   }
   if (start_twist_controller_)
   {
-    servoing_mode_hw_.set_servoing_mode(k_api::Base::ServoingMode::SINGLE_LEVEL_SERVOING);
-    base_.SetServoingMode(servoing_mode_hw_);
-    arm_mode_ = k_api::Base::ServoingMode::SINGLE_LEVEL_SERVOING;
+    requestServoingMode(k_api::Base::ServoingMode::SINGLE_LEVEL_SERVOING);
     joint_based_controller_running_ = false;
     twist_commands_ = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
     twist_controller_running_ = true;
@@ -657,13 +1102,28 @@ CallbackReturn KortexMultiInterfaceHardware::on_activate(
   const rclcpp_lifecycle::State & /* previous_state */)
 {
   RCLCPP_INFO(LOGGER, "Activating KortexMultiInterfaceHardware...");
+  if (rt_lock_memory_ && RtMemory::lockMemory())
+  {
+    RtMemory::prefaultHeap(rt_prefault_heap_size_);
+    RCLCPP_INFO(LOGGER, "Memory locked, %zu kB of heap prefaulted", rt_prefault_heap_size_ / 1024);
+  }
+  rt_stack_prefaulted_ = false;
+
   // first read
   auto base_feedback = base_cyclic_.RefreshFeedback();
 
-  // Add each actuator to the base_command_ and set the command to its current position
+  // Lay out base_command_ once with each actuator commanded to its current position,
+  // the cyclic path only patches the fields of these actuator commands in place
+  base_command_.Clear();
+  base_command_.mutable_actuators()->Reserve(static_cast<int>(actuator_count_));
+  actuator_commands_.clear();
+  actuator_commands_.reserve(actuator_count_);
+  frame_id_ = 0;
   for (std::size_t i = 0; i < actuator_count_; i++)
   {
-    base_command_.add_actuators()->set_position(base_feedback.actuators(i).position());
+    k_api::BaseCyclic::ActuatorCommand * actuator_command = base_command_.add_actuators();
+    actuator_command->set_position(base_feedback.actuators(static_cast<int>(i)).position());
+    actuator_commands_.push_back(actuator_command);
   }
 
   // Initialize gripper
@@ -684,6 +1144,43 @@ CallbackReturn KortexMultiInterfaceHardware::on_activate(
 
   // Send a first frame
   base_feedback = base_cyclic_.Refresh(base_command_);
+
+  use_command_encoder_ = false;
+  use_feedback_decoder_ = false;
+  if (cyclic_preencoded_command_)
+  {
+    // the encoding replaces the one of the Kortex API only if it parses into the same message
+    if (command_encoder_.layout(actuator_count_))
+    {
+      for (std::size_t i = 0; i < actuator_count_; i++)
+      {
+        command_encoder_.setActuator(
+          i, actuator_commands_[i]->position(), actuator_commands_[i]->command_id());
+      }
+      command_encoder_.setGripper(
+        gripper_motor_command_->position(), gripper_motor_command_->velocity(),
+        gripper_motor_command_->force());
+      command_encoder_.setFrameId(base_command_.frame_id());
+      use_command_encoder_ = command_encoder_.encodes(base_command_);
+    }
+    if (use_command_encoder_)
+    {
+      RCLCPP_INFO(LOGGER, "Cyclic commands are encoded once and patched in place");
+      // same for the feedback, the fields of the snapshot are read straight from the frame
+      use_feedback_decoder_ =
+        feedback_decoder_.configure(actuator_count_) &&
+        feedback_decoder_.decodes(base_feedback, use_internal_bus_gripper_comm_);
+      if (!use_feedback_decoder_)
+      {
+        RCLCPP_WARN(LOGGER, "Could not decode the cyclic feedback frame, it is parsed every cycle");
+      }
+    }
+    else
+    {
+      RCLCPP_WARN(
+        LOGGER, "Could not lay out the cyclic command frame, it is serialized every cycle");
+    }
+  }
   // Set some default values
   for (std::size_t i = 0; i < actuator_count_; i++)
   {
@@ -716,6 +1213,20 @@ CallbackReturn KortexMultiInterfaceHardware::on_activate(
     arm_joints_control_level_[i] = integration_lvl_t::UNDEFINED;
   }
 
+  feedback_ = base_feedback;
+  feedback_parsed_ = true;
+  feedback_snapshot_.decode(feedback_, use_internal_bus_gripper_comm_);
+  prepareCommands();
+  joint_state_estimator_.reset();
+  latency_predictor_.reset();
+  collision_detector_.reset();
+  collision_detector_.clearContact();
+  collision_reflex_active_ = false;
+  shared_command_active_ = false;
+  servoing_mode_pending_ = false;
+  servoing_mode_failed_ = false;
+  actuator_cyclic_base_countdown_ = 0;
+
   RCLCPP_INFO(LOGGER, "KortexMultiInterfaceHardware successfully activated!");
   return CallbackReturn::SUCCESS;
 }
@@ -724,21 +1235,31 @@ CallbackReturn KortexMultiInterfaceHardware::on_deactivate(
   const rclcpp_lifecycle::State & /* previous_state */)
 {
   RCLCPP_INFO(LOGGER, "Deactivating KortexMultiInterfaceHardware...");
+  RCLCPP_INFO(
+    LOGGER, "Cyclic channel: %.0f failed cycles, %.0f retries", cyclic_statistics_.failed_cycles,
+    cyclic_statistics_.retries);
+  if (udp_realtime_transport_ && udp_realtime_transport_->sendFailures() > 0)
+  {
+    RCLCPP_WARN(
+      LOGGER, "%lu cyclic frames could not be sent",
+      static_cast<unsigned long>(udp_realtime_transport_->sendFailures()));  // NOLINT(runtime/int)
+  }
 
   auto servoing_mode = k_api::Base::ServoingModeInformation();
   // Set back the servoing mode to Single Level Servoing
   servoing_mode.set_servoing_mode(k_api::Base::ServoingMode::SINGLE_LEVEL_SERVOING);
-  base_.SetServoingMode(servoing_mode);
+  rpc_executor_.call([&]() { base_.SetServoingMode(servoing_mode); });
 
+  actuator_cyclic_channel_.close();
   // Close API session
-  session_manager_.CloseSession();
+  rpc_executor_.call([this]() { session_manager_.CloseSession(); });
   session_manager_real_time_.CloseSession();
 
   // Deactivate the router and cleanly disconnect from the transport object
   router_tcp_.SetActivationStatus(false);
   transport_tcp_.disconnect();
   router_udp_realtime_.SetActivationStatus(false);
-  transport_udp_realtime_.disconnect();
+  metered_transport_udp_realtime_.disconnect();
 
   // memory handling
   delete k_api_twist_;
@@ -750,47 +1271,83 @@ CallbackReturn KortexMultiInterfaceHardware::on_deactivate(
 }
 
 return_type KortexMultiInterfaceHardware::read(
-  const rclcpp::Time & /*time*/, const rclcpp::Duration & /*period*/)
+  const rclcpp::Time & /*time*/, const rclcpp::Duration & period)
 {
+  KORTEX_RT_SECTION("read");
+  if (!rt_stack_prefaulted_)
+  {
+    // read() runs on the control thread, on_activate() does not
+    rt_stack_prefaulted_ = true;
+    RtMemory::prefaultStack(rt_prefault_stack_size_);
+  }
+
   if (first_pass_)
   {
     first_pass_ = false;
-    feedback_ = base_cyclic_.RefreshFeedback();
+    refreshCyclic(false);
+  }
+
+  tcp_traffic_rates_.update(
+    metered_transport_tcp_.counters(), period.seconds(), traffic_stats_window_);
+  udp_traffic_rates_.update(
+    metered_transport_udp_realtime_.counters(), period.seconds(), traffic_stats_window_);
+
+  if (idle_cycle_skipped_)
+  {
+    // no new frame was requested while idle, the states of the last one are held
+    idle_cycle_skipped_ = false;
+    writeSharedState();
+    return return_type::OK;
   }
 
   // read if robot is faulted
-  in_fault_ = (feedback_.base().active_state() == Kinova::Api::Common::ArmState::ARMSTATE_IN_FAULT);
+  in_fault_ = (feedback_snapshot_.active_state == k_api::Common::ArmState::ARMSTATE_IN_FAULT);
+  in_fault_ += servoing_mode_failed_;
 
   // read gripper state
   readGripperPosition();
 
-  for (std::size_t i = 0; i < actuator_count_; i++)
+  // joint states were already extracted from the frame when it was received
+  std::copy(
+    feedback_snapshot_.efforts.begin(), feedback_snapshot_.efforts.end(), arm_efforts_.begin());
+  std::copy(
+    feedback_snapshot_.velocities.begin(), feedback_snapshot_.velocities.end(),
+    arm_velocities_.begin());
+  std::copy(
+    feedback_snapshot_.positions.begin(), feedback_snapshot_.positions.end(),
+    arm_positions_.begin());
+  // filtered from the measurements, before these are replaced by their prediction
+  joint_state_estimator_.update(arm_positions_, arm_velocities_, period.seconds());
+  if (collision_detection_)
   {
-    // read torque
-    arm_efforts_[i] = feedback_.actuators(i).torque();  // N*m
-    // read velocity
-    arm_velocities_[i] = KortexMathUtil::toRad(feedback_.actuators(i).velocity());  // rad/sec
-    // read position
-    num_turns_tmp_ = 0;
-    arm_positions_[i] = KortexMathUtil::wrapRadiansFromMinusPiToPi(
-      KortexMathUtil::toRad(feedback_.actuators(i).position()),
-      num_turns_tmp_);  // rad
-
-    in_fault_ += (feedback_.actuators(i).fault_bank_a() + feedback_.actuators(i).fault_bank_b());
-
-    // TODO(livanov93): separate warnings into another variable to expose it via fault controller
-    //       feedback_.actuators(i).warning_bank_a() + feedback_.actuators(i).warning_bank_b());
+    collision_detector_.update(
+      dynamics_model_, arm_positions_, joint_state_estimator_.velocities(), arm_efforts_,
+      period.seconds());
+    if (collision_reflex_ && collision_detector_.inContact() && !collision_reflex_active_)
+    {
+      collision_reflex_active_ = true;
+      std::copy(arm_positions_.begin(), arm_positions_.end(), reflex_hold_positions_.begin());
+      KORTEX_RT_ALLOW();
+      RCLCPP_WARN(LOGGER, "Collision detected, holding the arm until the fault is reset");
+    }
   }
+  if (dynamics_feedforward_)
+  {
+    dynamics_feedforward_terms_.update(
+      dynamics_model_, arm_positions_, joint_state_estimator_.velocities());
+  }
+  latency_predictor_.predict(arm_positions_, arm_velocities_);
 
-  // add all base's faults and warnings into series
-  in_fault_ += (feedback_.base().fault_bank_a() + feedback_.base().fault_bank_b());
+  // add all base's and actuators' faults into series
+  in_fault_ += feedback_snapshot_.faults;
 
   // TODO(livanov93): separate warnings into another variable to expose it via fault controller
-  //     + feedback_.base().warning_bank_a() + feedback_.base().warning_bank_b());
+  //     + feedback().base().warning_bank_a() + feedback().base().warning_bank_b());
 
   // add mode that can't be easily reached
-  in_fault_ += (feedback_.base().active_state() == k_api::Common::ARMSTATE_SERVOING_READY);
+  in_fault_ += (feedback_snapshot_.active_state == k_api::Common::ARMSTATE_SERVOING_READY);
 
+  writeSharedState();
   return return_type::OK;
 }
 
@@ -800,55 +1357,71 @@ void KortexMultiInterfaceHardware::readGripperPosition()
   // TODO(anyone) read in as parameter from kortex_controllers.yaml
   if (use_internal_bus_gripper_comm_)
   {
-    gripper_position_ =
-      feedback_.interconnect().gripper_feedback().motor()[0].position() / 100.0 * 0.81;  // rad
+    gripper_position_ = feedback_snapshot_.gripper_position / 100.0 * 0.81;  // rad
   }
 }
 
 return_type KortexMultiInterfaceHardware::write(
-  const rclcpp::Time & /*time*/, const rclcpp::Duration & /*period*/)
+  const rclcpp::Time & time, const rclcpp::Duration & period)
 {
+  KORTEX_RT_SECTION("write");
   if (block_write)
   {
-    feedback_ = base_cyclic_.RefreshFeedback();
+    refreshCyclic(false);
+    last_cyclic_refresh_ns_ = time.nanoseconds();
     return return_type::OK;
   }
 
-  if (!std::isnan(reset_fault_cmd_) && fault_controller_running_)
+  // a servoing mode requested by a controller switch is being set on the executor, the arm
+  // gets no command until it is, the feedback is kept fresh meanwhile
+  if (servoing_mode_pending_)
   {
-    try
+    const bool confirmed = confirmServoingMode();
+    if (!confirmed || servoing_mode_failed_)
     {
-      // change servoing mode first
-      servoing_mode_hw_.set_servoing_mode(k_api::Base::ServoingMode::SINGLE_LEVEL_SERVOING);
-      base_.SetServoingMode(servoing_mode_hw_);
-      // apply emergency stop - twice to make it sure as calling it once appeared to be unreliable
-      // (detected by testing)
-      base_.ApplyEmergencyStop(0, {false, 0, 100});
-      base_.ApplyEmergencyStop(0, {false, 0, 100});
-      // clear faults
-      base_.ClearFaults();
-      // back to original servoing mode
-      if (
-        arm_mode_ == k_api::Base::ServoingMode::SINGLE_LEVEL_SERVOING ||
-        arm_mode_ == k_api::Base::ServoingMode::LOW_LEVEL_SERVOING)
-      {
-        servoing_mode_hw_.set_servoing_mode(arm_mode_);
-        base_.SetServoingMode(servoing_mode_hw_);
-      }
-      reset_fault_async_success_ = 1.0;
+      refreshCyclic(false);
+      last_cyclic_refresh_ns_ = time.nanoseconds();
+      return confirmed ? return_type::ERROR : return_type::OK;
     }
-    catch (k_api::KDetailedException & ex)
-    {
-      RCLCPP_ERROR_STREAM(LOGGER, "Kortex exception: " << ex.what());
+  }
 
-      RCLCPP_ERROR_STREAM(
-        LOGGER, "Error sub-code: " << k_api::SubErrorCodes_Name(
-                  k_api::SubErrorCodes((ex.getErrorInfo().getError().error_sub_code()))));
-      reset_fault_async_success_ = 0.0;
+  // Idle mode - no controller moving the arm or the gripper, only keep the sessions alive. The
+  // fault controller is always loaded, a reset it requests is handled without waiting.
+  if (
+    !motionControllerRunning() && std::isnan(reset_fault_cmd_) && idle_refresh_period_ns_ > 0 &&
+    (time.nanoseconds() - last_cyclic_refresh_ns_) < idle_refresh_period_ns_)
+  {
+    idle_cycle_skipped_ = true;
+    return return_type::OK;
+  }
+  last_cyclic_refresh_ns_ = time.nanoseconds();
+
+  // the fault reset sequence takes several rpc round trips, it runs on the executor and its
+  // outcome is reported on a later cycle
+  const int reset_fault_result = reset_fault_result_.exchange(-1);
+  if (reset_fault_result >= 0)
+  {
+    reset_fault_async_success_ = reset_fault_result;
+    if (reset_fault_result == 1 && servoing_mode_failed_)
+    {
+      // the reset set the mode that could not be set before
+      arm_mode_ = requested_arm_mode_;
+      servoing_mode_failed_ = false;
     }
-    catch (...)
+  }
+  if (!std::isnan(reset_fault_cmd_) && fault_controller_running_)
+  {
+    // a fault reset acknowledges a detected collision as well
+    collision_detector_.clearContact();
+    collision_reflex_active_ = false;
+    if (!reset_fault_pending_.exchange(true))
     {
-      reset_fault_async_success_ = 0.0;
+      const auto arm_mode = servoing_mode_failed_ ? requested_arm_mode_ : arm_mode_;
+      if (!rpc_executor_.post([this, arm_mode]() { resetFaults(arm_mode); }))
+      {
+        reset_fault_pending_ = false;
+        reset_fault_async_success_ = 0.0;
+      }
     }
     reset_fault_cmd_ = NO_CMD;
   }
@@ -860,24 +1433,30 @@ return_type KortexMultiInterfaceHardware::write(
       // Twist controller active
       if (twist_controller_running_)
       {
+        if (collision_reflex_active_)
+        {
+          std::fill(twist_commands_.begin(), twist_commands_.end(), 0.0);
+        }
         // twist control
         sendTwistCommand();
       }
       else
       {
-        // Keep alive mode - no controller active
-        RCLCPP_DEBUG(LOGGER, "No controller active in SINGLE_LEVEL_SERVOING mode!");
+        // Keep alive mode - no controller active. Logging locks the output mutex of rclcpp.
+        KORTEX_RT_ALLOW();
+        RCLCPP_DEBUG_THROTTLE(
+          LOGGER, steady_clock_, 1000, "No controller active in SINGLE_LEVEL_SERVOING mode!");
       }
 
       // gripper control
       sendGripperCommand(
         arm_mode_, gripper_command_position_, gripper_speed_command_, gripper_force_command_);
       // read after write in twist mode
-      feedback_ = base_cyclic_.RefreshFeedback();
+      refreshCyclic(false);
     }
     else if (
       (arm_mode_ == k_api::Base::ServoingMode::LOW_LEVEL_SERVOING) &&
-      (feedback_.base().active_state() == k_api::Common::ARMSTATE_SERVOING_LOW_LEVEL))
+      (feedback_snapshot_.active_state == k_api::Common::ARMSTATE_SERVOING_LOW_LEVEL))
     {
       // Per joint controller active
 
@@ -887,22 +1466,42 @@ return_type KortexMultiInterfaceHardware::write(
 
       if (joint_based_controller_running_)
       {
+        if (command_shared_memory_.isOpen())
+        {
+          applySharedCommand(period.seconds());
+        }
+        if (collision_reflex_active_)
+        {
+          std::copy(
+            reflex_hold_positions_.begin(), reflex_hold_positions_.end(),
+            arm_commands_positions_.begin());
+        }
         // send commands to the joints
-        sendJointCommands();
+        if (actuator_cyclic_channel_.isOpen())
+        {
+          sendActuatorCommands();
+        }
+        else
+        {
+          sendJointCommands();
+        }
       }
       else
       {
         // Keep alive mode - no controller active
-        feedback_ = base_cyclic_.RefreshFeedback();
-        RCLCPP_DEBUG(LOGGER, "No controller active in LOW_LEVEL_SERVOING mode !");
+        refreshCyclic(false);
+        KORTEX_RT_ALLOW();
+        RCLCPP_DEBUG_THROTTLE(
+          LOGGER, steady_clock_, 1000, "No controller active in LOW_LEVEL_SERVOING mode !");
       }
     }
     else
     {
       // Keep alive mode - no controller active
-      feedback_ = base_cyclic_.RefreshFeedback();
-      RCLCPP_DEBUG(
-        LOGGER,
+      refreshCyclic(false);
+      KORTEX_RT_ALLOW();
+      RCLCPP_DEBUG_THROTTLE(
+        LOGGER, steady_clock_, 1000,
         "Fault was not recognized on the robot but combination of Control Mode and Active State "
         "are not supported!");
     }
@@ -911,12 +1510,29 @@ return_type KortexMultiInterfaceHardware::write(
   {
     // this is needed when the robot was faulted
     // so we can internally conclude it is not faulted anymore
-    feedback_ = base_cyclic_.RefreshFeedback();
+    refreshCyclic(false);
+  }
+
+  if (
+    cyclic_retry_policy_.max_consecutive_failures > 0 &&
+    cyclic_statistics_.consecutive_failures >= cyclic_retry_policy_.max_consecutive_failures)
+  {
+    KORTEX_RT_ALLOW();
+    RCLCPP_ERROR(
+      LOGGER, "Cyclic channel failed for %.0f consecutive cycles!",
+      cyclic_statistics_.consecutive_failures);
+    return return_type::ERROR;
   }
 
   return return_type::OK;
 }
 
+bool KortexMultiInterfaceHardware::motionControllerRunning() const
+{
+  return joint_based_controller_running_ || twist_controller_running_ ||
+         gripper_controller_running_;
+}
+
 void KortexMultiInterfaceHardware::prepareCommands()
 {  // update the command for each joint
   for (size_t i = 0; i < actuator_count_; i++)
@@ -926,13 +1542,131 @@ void KortexMultiInterfaceHardware::prepareCommands()
       KortexMathUtil::wrapDegreesFromZeroTo360(KortexMathUtil::toDeg(arm_commands_positions_[i])));
     cmd_vel_tmp_ = static_cast<float>(KortexMathUtil::toDeg(arm_commands_velocities_[i]));
 
-    base_command_.mutable_actuators(static_cast<int>(i))->set_position(cmd_degrees_tmp_);
+    if (use_command_encoder_)
+    {
+      command_encoder_.setActuator(i, cmd_degrees_tmp_, frame_id_);
+      continue;
+    }
+    actuator_commands_[i]->set_position(cmd_degrees_tmp_);
     // Velocity command interface not implemented properly in the kortex api
-    // base_command_.mutable_actuators(i)->set_velocity(cmd_vel_tmp_);
-    base_command_.mutable_actuators(static_cast<int>(i))->set_command_id(base_command_.frame_id());
+    // actuator_commands_[i]->set_velocity(cmd_vel_tmp_);
+    actuator_commands_[i]->set_command_id(frame_id_);
   }
 }
 
+bool KortexMultiInterfaceHardware::validSharedCommand() const
+{
+  for (std::size_t i = 0; i < actuator_count_; i++)
+  {
+    const double position = shared_command_.positions[i];
+    if (
+      !std::isfinite(position) || !std::isfinite(shared_command_.velocities[i]) ||
+      position < shared_command_lower_limits_[i] || position > shared_command_upper_limits_[i])
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+void KortexMultiInterfaceHardware::applySharedCommand(double period)
+{
+  // only the newest frame matters, frames written between two cycles are skipped
+  std::uint32_t sequence = 0;
+  const std::int64_t now_ns = steadyNanoseconds();
+  if (
+    command_shared_memory_.readCommand(shared_command_, sequence) &&
+    sequence != shared_command_sequence_)
+  {
+    shared_command_sequence_ = sequence;
+    // stamped on CLOCK_MONOTONIC, a stale frame is one left over by a writer that went away
+    const std::int64_t age_ns = now_ns - static_cast<std::int64_t>(shared_command_.stamp_ns);
+    const bool fresh = shared_command_timeout_ns_ <= 0 || age_ns <= shared_command_timeout_ns_;
+    if (fresh && !validSharedCommand())
+    {
+      KORTEX_RT_ALLOW();
+      RCLCPP_WARN_THROTTLE(
+        LOGGER, steady_clock_, 1000,
+        "Ignoring shared memory commands with non-finite values or positions out of the joint "
+        "limits");
+    }
+    else if (fresh)
+    {
+      std::copy(
+        shared_command_.positions, shared_command_.positions + actuator_count_,
+        shared_command_positions_.begin());
+      std::copy(
+        shared_command_.velocities, shared_command_.velocities + actuator_count_,
+        shared_command_velocities_.begin());
+      shared_command_received_ns_ = now_ns;
+      if (!shared_command_active_)
+      {
+        KORTEX_RT_ALLOW();
+        RCLCPP_INFO(LOGGER, "Shared memory commands take over from the joint controller");
+      }
+      shared_command_active_ = true;
+    }
+  }
+  if (!shared_command_active_)
+  {
+    return;
+  }
+
+  // towards the target from where the arm is, no faster than the velocity bound. The measured
+  // positions are wrapped, so are the steps of joints that turn further than half a turn.
+  const double max_step = shared_command_max_velocity_ * period;
+  for (std::size_t i = 0; i < actuator_count_; i++)
+  {
+    double step = shared_command_positions_[i] - arm_positions_[i];
+    if (shared_command_lower_limits_[i] < -M_PI || shared_command_upper_limits_[i] > M_PI)
+    {
+      step = KortexMathUtil::wrapRadiansFromMinusPiToPi(step);
+    }
+    if (shared_command_max_velocity_ > 0.0)
+    {
+      step = std::clamp(step, -max_step, max_step);
+    }
+    arm_commands_positions_[i] = arm_positions_[i] + step;
+  }
+  if (
+    shared_command_timeout_ns_ > 0 &&
+    now_ns - shared_command_received_ns_ > shared_command_timeout_ns_)
+  {
+    // the writer stopped, hold the last positions without feed forward
+    std::fill(arm_commands_velocities_.begin(), arm_commands_velocities_.end(), 0.0);
+  }
+  else
+  {
+    for (std::size_t i = 0; i < actuator_count_; i++)
+    {
+      const double velocity = shared_command_velocities_[i];
+      arm_commands_velocities_[i] =
+        shared_command_max_velocity_ > 0.0
+          ? std::clamp(velocity, -shared_command_max_velocity_, shared_command_max_velocity_)
+          : velocity;
+    }
+  }
+}
+
+void KortexMultiInterfaceHardware::writeSharedState()
+{
+  if (!command_shared_memory_.isOpen())
+  {
+    return;
+  }
+  // the states the controllers see, predicted over the cyclic delay when that is enabled
+  shared_state_.stamp_ns = static_cast<std::uint64_t>(steadyNanoseconds());
+  for (std::size_t i = 0; i < actuator_count_; i++)
+  {
+    shared_state_.positions[i] = arm_positions_[i];
+    shared_state_.velocities[i] = arm_velocities_[i];
+    shared_state_.efforts[i] = arm_efforts_[i];
+  }
+  shared_state_.gripper_position = gripper_position_;
+  shared_state_.gripper_velocity = gripper_velocity_;
+  command_shared_memory_.writeState(shared_state_);
+}
+
 void KortexMultiInterfaceHardware::sendJointCommands()
 {
   // identifier++
@@ -941,41 +1675,217 @@ void KortexMultiInterfaceHardware::sendJointCommands()
   prepareCommands();
 
   // send the command to the robot
+  refreshCyclic(true);
+}
+
+void KortexMultiInterfaceHardware::sendActuatorCommands()
+{
+  incrementId();
+
+  // arm state, base faults and gripper from time to time, the joints come from the actuators
+  if (actuator_cyclic_base_countdown_ <= 0)
+  {
+    refreshCyclic(false);
+    actuator_cyclic_base_countdown_ = actuator_cyclic_base_period_;
+  }
+  actuator_cyclic_base_countdown_--;
+
+  if (actuator_cyclic_channel_.exchange(
+        arm_commands_positions_, frame_id_, cyclic_retry_policy_.timeout_ms, feedback_snapshot_))
+  {
+    cyclic_statistics_.consecutive_failures = 0.0;
+    return;
+  }
+  cyclic_statistics_.failed_cycles += 1.0;
+  cyclic_statistics_.consecutive_failures += 1.0;
+  KORTEX_RT_ALLOW();
+  RCLCPP_WARN_THROTTLE(
+    LOGGER, steady_clock_, 1000, "Actuator cyclic exchange failed, %.0f failed cycles so far",
+    cyclic_statistics_.failed_cycles);
+}
+
+CyclicError KortexMultiInterfaceHardware::exchangeCyclic(bool send_command)
+{
+  // the Kortex API only reports failures of the synchronous calls through exceptions,
+  // they are turned into error codes here so that the rest of the cycle does not unwind
+  const k_api::RouterClientSendOptions options{false, 0, cyclic_retry_policy_.timeout_ms};
+  const std::int64_t request_ns = steadyNanoseconds();
   try
   {
-    feedback_ = base_cyclic_.Refresh(base_command_);
+    if (use_command_encoder_)
+    {
+      const CyclicError error = exchangeEncoded(send_command, options);
+      if (error != CyclicError::NONE)
+      {
+        return error;
+      }
+    }
+    else
+    {
+      {
+        // the Kortex API allocates while it serializes, sends and parses
+        KORTEX_RT_ALLOW();
+        feedback_ = send_command ? base_cyclic_.Refresh(base_command_, 0, options)
+                                 : base_cyclic_.RefreshFeedback(0, options);
+      }
+      feedback_snapshot_.decode(feedback_, use_internal_bus_gripper_comm_);
+    }
   }
   catch (k_api::KDetailedException & ex)
   {
-    feedback_ = base_cyclic_.RefreshFeedback();
-    RCLCPP_ERROR_STREAM(LOGGER, "Kortex exception: " << ex.what());
+    cyclic_statistics_.last_error_sub_code = ex.getErrorInfo().getError().error_sub_code();
+    return CyclicError::KORTEX;
+  }
+  catch (std::future_error & /*ex_future*/)
+  {
+    return CyclicError::FUTURE;
+  }
+  catch (std::runtime_error & /*ex_runtime*/)
+  {
+    return CyclicError::RUNTIME;
+  }
+  catch (std::exception & /*ex_std*/)
+  {
+    return CyclicError::OTHER;
+  }
+  std::int64_t response_ns = steadyNanoseconds();
+  if (udp_realtime_transport_)
+  {
+    // the frame reached the socket before the router handed it over
+    const std::int64_t receive_ns = udp_realtime_transport_->lastReceiveTimestampNs();
+    if (receive_ns >= request_ns && receive_ns <= response_ns)
+    {
+      response_ns = receive_ns;
+    }
+  }
+  latency_predictor_.recordExchange(request_ns, response_ns, send_command);
+  return CyclicError::NONE;
+}
 
-    RCLCPP_ERROR_STREAM(
-      LOGGER, "Error sub-code: " << k_api::SubErrorCodes_Name(
-                k_api::SubErrorCodes((ex.getErrorInfo().getError().error_sub_code()))));
+CyclicError KortexMultiInterfaceHardware::exchangeEncoded(
+  bool send_command, const k_api::RouterClientSendOptions & options)
+{
+  // what BaseCyclicClient::Refresh() and RefreshFeedback() do, minus serializing the command
+  static const std::string empty_payload;
+  {
+    // the router allocates the framing, the promise and the received frame. The previous
+    // frame is released here as well, the decoding below runs without allocating.
+    KORTEX_RT_ALLOW();
+    cyclic_reply_ = router_udp_realtime_.send(
+      send_command ? command_encoder_.payload() : empty_payload, BASE_CYCLIC_SERVICE_VERSION,
+      send_command ? k_api::BaseCyclic::eUidRefresh : k_api::BaseCyclic::eUidRefreshFeedback, 0,
+      options);
+    if (
+      cyclic_reply_.wait_for(std::chrono::milliseconds(options.timeout_ms)) !=
+      std::future_status::ready)
+    {
+      cyclic_statistics_.last_error_sub_code = k_api::TIMEOUT;
+      return CyclicError::KORTEX;
+    }
+    cyclic_frame_ = cyclic_reply_.get();
+    const k_api::HeaderInfo header(cyclic_frame_);
+    if (header.m_errorCode != k_api::ERROR_NONE)
+    {
+      cyclic_statistics_.last_error_sub_code = header.m_errorSubCode;
+      return CyclicError::KORTEX;
+    }
   }
-  catch (std::runtime_error & ex_runtime)
+  if (use_feedback_decoder_)
   {
-    feedback_ = base_cyclic_.RefreshFeedback();
-    RCLCPP_ERROR_STREAM(LOGGER, "Runtime error: " << ex_runtime.what());
+    // only the fields of the snapshot are read, the rest of the frame is kept for feedback()
+    if (!feedback_decoder_.decode(
+          cyclic_frame_.payload(), feedback_snapshot_, use_internal_bus_gripper_comm_))
+    {
+      return CyclicError::OTHER;
+    }
+    feedback_frame_.Swap(&cyclic_frame_);
+    feedback_parsed_ = false;
+    return CyclicError::NONE;
   }
-  catch (std::future_error & ex_future)
   {
-    feedback_ = base_cyclic_.RefreshFeedback();
-    RCLCPP_ERROR_STREAM(LOGGER, "Future error: " << ex_future.what());
+    // fallback when the decoder could not be checked, the message owns its repeated fields
+    KORTEX_RT_ALLOW();
+    if (!feedback_.ParseFromString(cyclic_frame_.payload()))
+    {
+      return CyclicError::OTHER;
+    }
   }
-  catch (std::exception & ex_std)
+  feedback_parsed_ = true;
+  feedback_snapshot_.decode(feedback_, use_internal_bus_gripper_comm_);
+  return CyclicError::NONE;
+}
+
+const k_api::BaseCyclic::Feedback & KortexMultiInterfaceHardware::feedback()
+{
+  if (!feedback_parsed_)
   {
-    feedback_ = base_cyclic_.RefreshFeedback();
-    RCLCPP_ERROR_STREAM(LOGGER, "Standard exception: " << ex_std.what());
+    // the decoder accepted the frame, it parses
+    KORTEX_RT_ALLOW();
+    feedback_.ParseFromString(feedback_frame_.payload());
+    feedback_parsed_ = true;
   }
+  return feedback_;
+}
+
+bool KortexMultiInterfaceHardware::refreshCyclic(bool send_command)
+{
+  CyclicError error = CyclicError::NONE;
+  for (std::uint32_t attempt = 0; attempt <= cyclic_retry_policy_.max_retries; attempt++)
+  {
+    if (attempt > 0)
+    {
+      cyclic_statistics_.retries += 1.0;
+    }
+    error = exchangeCyclic(send_command);
+    if (error == CyclicError::NONE)
+    {
+      cyclic_statistics_.consecutive_failures = 0.0;
+      return true;
+    }
+    cyclic_statistics_.record(error);
+  }
+
+  // every attempt failed, feedback_snapshot_ and feedback() still hold the last valid frame
+  cyclic_statistics_.failed_cycles += 1.0;
+  cyclic_statistics_.consecutive_failures += 1.0;
+  {
+    // failures are counted in cyclic_stats, the logs around them are not real-time
+    KORTEX_RT_ALLOW();
+    RCLCPP_WARN_THROTTLE(
+      LOGGER, steady_clock_, 1000, "Cyclic exchange failed (%s), %.0f failed cycles so far",
+      toString(error), cyclic_statistics_.failed_cycles);
+    if (udp_realtime_transport_ && udp_realtime_transport_->sendFailures() > 0)
+    {
+      RCLCPP_WARN_THROTTLE(
+        LOGGER, steady_clock_, 1000, "%lu cyclic frames could not be sent, last error: %s",
+        static_cast<unsigned long>(udp_realtime_transport_->sendFailures()),  // NOLINT
+        std::strerror(udp_realtime_transport_->lastSendError()));
+    }
+  }
+
+  if (send_command && cyclic_retry_policy_.on_failure == CyclicFailureAction::REFRESH_FEEDBACK)
+  {
+    error = exchangeCyclic(false);
+    if (error != CyclicError::NONE)
+    {
+      cyclic_statistics_.record(error);
+    }
+  }
+  return false;
 }
 
 void KortexMultiInterfaceHardware::incrementId()
 {
   // Incrementing identifier ensures actuators can reject out of time frames
-  base_command_.set_frame_id(base_command_.frame_id() + 1);
-  if (base_command_.frame_id() > 65535) base_command_.set_frame_id(0);
+  frame_id_ = (frame_id_ + 1) & 0xffff;
+  if (use_command_encoder_)
+  {
+    command_encoder_.setFrameId(frame_id_);
+  }
+  else
+  {
+    base_command_.set_frame_id(frame_id_);
+  }
 }
 
 void KortexMultiInterfaceHardware::sendGripperCommand(
@@ -987,18 +1897,26 @@ void KortexMultiInterfaceHardware::sendGripperCommand(
     {
       if (arm_mode == k_api::Base::ServoingMode::SINGLE_LEVEL_SERVOING)
       {
-        k_api::Base::GripperCommand gripper_command;
-        gripper_command.set_mode(k_api::Base::GRIPPER_POSITION);
-        auto finger = gripper_command.mutable_gripper()->add_finger();
-        finger->set_finger_identifier(1);
-        finger->set_value(
-          static_cast<float>(position / 0.81));  // This values needs to be between 0 and 1
-        base_.SendGripperCommand(gripper_command);
+        // This values needs to be between 0 and 1
+        gripper_mailbox_.store(static_cast<float>(position / 0.81), std::memory_order_relaxed);
+        if (
+          !gripper_pending_.exchange(true) &&
+          !rpc_executor_.post([this]() { sendPendingGripperCommand(); }))
+        {
+          gripper_pending_ = false;
+        }
       }
       else if (arm_mode == k_api::Base::ServoingMode::LOW_LEVEL_SERVOING)
       {
         // % open/closed, this values needs to be between 0 and 100
-        gripper_motor_command_->set_position(static_cast<float>(position / 0.81 * 100.0));
+        const float gripper_position = static_cast<float>(position / 0.81 * 100.0);
+        if (use_command_encoder_)
+        {
+          command_encoder_.setGripper(
+            gripper_position, static_cast<float>(velocity), static_cast<float>(force));
+          return;
+        }
+        gripper_motor_command_->set_position(gripper_position);
         // % gripper speed between 0 and 100 percent
         gripper_motor_command_->set_velocity(static_cast<float>(velocity));
         // % max force threshold, between 0 and 100
@@ -1017,17 +1935,200 @@ void KortexMultiInterfaceHardware::sendGripperCommand(
   }
 }
 
+void KortexMultiInterfaceHardware::requestServoingMode(k_api::Base::ServoingMode mode)
+{
+  requested_arm_mode_ = mode;
+  servoing_mode_pending_ = true;
+  const std::uint32_t request = ++servoing_mode_request_;
+  if (!rpc_executor_.post([this, mode, request]() { setServoingMode(mode, request); }))
+  {
+    servoing_mode_result_ = static_cast<std::uint64_t>(request) << 1;
+  }
+}
+
+bool KortexMultiInterfaceHardware::confirmServoingMode()
+{
+  // results of requests overtaken by a later switch are ignored
+  const std::uint64_t result = servoing_mode_result_.load();
+  if ((result >> 1) != servoing_mode_request_)
+  {
+    return false;
+  }
+  servoing_mode_pending_ = false;
+  servoing_mode_failed_ = (result & 1) == 0;
+  if (servoing_mode_failed_)
+  {
+    // the arm is not commanded while in fault, a fault reset sets the requested mode again
+    KORTEX_RT_ALLOW();
+    RCLCPP_ERROR(LOGGER, "Could not set the servoing mode, reporting a fault until it is reset");
+    return true;
+  }
+  arm_mode_ = requested_arm_mode_;
+  return true;
+}
+
+void KortexMultiInterfaceHardware::setServoingMode(
+  k_api::Base::ServoingMode mode, std::uint32_t request)
+{
+  std::uint64_t success = 0;
+  try
+  {
+    k_api::Base::ServoingModeInformation servoing_mode;
+    servoing_mode.set_servoing_mode(mode);
+    base_.SetServoingMode(servoing_mode);
+    success = 1;
+  }
+  catch (k_api::KDetailedException & ex)
+  {
+    RCLCPP_ERROR_STREAM(LOGGER, "Kortex exception: " << ex.what());
+  }
+  catch (std::exception & ex)
+  {
+    RCLCPP_ERROR_STREAM(LOGGER, "Could not set the servoing mode: " << ex.what());
+  }
+  servoing_mode_result_ = (static_cast<std::uint64_t>(request) << 1) | success;
+}
+
 void KortexMultiInterfaceHardware::sendTwistCommand()
 {
-  k_api_twist_->set_linear_x(static_cast<float>(twist_commands_[0]));
-  k_api_twist_->set_linear_y(static_cast<float>(twist_commands_[1]));
-  k_api_twist_->set_linear_z(static_cast<float>(twist_commands_[2]));
-  k_api_twist_->set_angular_x(static_cast<float>(twist_commands_[3]));
-  k_api_twist_->set_angular_y(static_cast<float>(twist_commands_[4]));
-  k_api_twist_->set_angular_z(static_cast<float>(twist_commands_[5]));
+  for (std::size_t i = 0; i < twist_mailbox_.size(); i++)
+  {
+    twist_mailbox_[i].store(static_cast<float>(twist_commands_[i]), std::memory_order_relaxed);
+  }
+  // one send in flight at most, it picks up whatever is in the mailbox when it runs
+  if (!twist_pending_.exchange(true) && !rpc_executor_.post([this]() { sendPendingTwist(); }))
+  {
+    twist_pending_ = false;
+  }
+}
+
+void KortexMultiInterfaceHardware::sendPendingTwist()
+{
+  twist_pending_ = false;
+  k_api_twist_->set_linear_x(twist_mailbox_[0].load(std::memory_order_relaxed));
+  k_api_twist_->set_linear_y(twist_mailbox_[1].load(std::memory_order_relaxed));
+  k_api_twist_->set_linear_z(twist_mailbox_[2].load(std::memory_order_relaxed));
+  k_api_twist_->set_angular_x(twist_mailbox_[3].load(std::memory_order_relaxed));
+  k_api_twist_->set_angular_y(twist_mailbox_[4].load(std::memory_order_relaxed));
+  k_api_twist_->set_angular_z(twist_mailbox_[5].load(std::memory_order_relaxed));
   base_.SendTwistCommand(k_api_twist_command_);
 }
 
+void KortexMultiInterfaceHardware::sendPendingGripperCommand()
+{
+  gripper_pending_ = false;
+  k_api::Base::GripperCommand gripper_command;
+  gripper_command.set_mode(k_api::Base::GRIPPER_POSITION);
+  auto finger = gripper_command.mutable_gripper()->add_finger();
+  finger->set_finger_identifier(1);
+  finger->set_value(gripper_mailbox_.load(std::memory_order_relaxed));
+  try
+  {
+    base_.SendGripperCommand(gripper_command);
+  }
+  catch (k_api::KDetailedException & ex)
+  {
+    RCLCPP_ERROR(LOGGER, "Exception caught while sending internal gripper command!");
+    RCLCPP_ERROR_STREAM(LOGGER, "Kortex exception: " << ex.what());
+  }
+}
+
+void KortexMultiInterfaceHardware::queryRobotConfiguration(
+  RobotConfiguration & configuration, bool query_devices, bool query_gripper)
+{
+  configuration.actuator_count = base_.GetActuatorCount().count();
+
+  configuration.devices.clear();
+  if (query_devices)
+  {
+    k_api::DeviceManager::DeviceManagerClient device_manager(&router_tcp_);
+    const auto device_handles = device_manager.ReadAllDevices();
+    for (int i = 0; i < device_handles.device_handle_size(); i++)
+    {
+      const auto & handle = device_handles.device_handle(i);
+      configuration.devices.push_back(
+        {static_cast<std::uint32_t>(handle.device_type()), handle.device_identifier(),
+         handle.order()});
+    }
+  }
+
+  configuration.gripper_installed = false;
+  if (query_gripper)
+  {
+    const auto end_effector = base_.GetProductConfiguration().end_effector_type();
+    configuration.gripper_installed =
+      end_effector != k_api::ProductConfiguration::END_EFFECTOR_TYPE_UNSPECIFIED &&
+      end_effector != k_api::ProductConfiguration::END_EFFECTOR_TYPE_NOT_INSTALLED;
+  }
+}
+
+bool KortexMultiInterfaceHardware::armJointNames(std::vector<std::string> & joint_names) const
+{
+  joint_names.clear();
+  for (const auto & joint : info_.joints)
+  {
+    if (joint.name != gripper_joint_name_)
+    {
+      joint_names.push_back(joint.name);
+    }
+  }
+  if (joint_names.size() != actuator_count_)
+  {
+    RCLCPP_ERROR(
+      LOGGER, "%zu arm joints in the ros2_control tag for %zu actuators", joint_names.size(),
+      actuator_count_);
+    return false;
+  }
+  return true;
+}
+
+bool KortexMultiInterfaceHardware::loadDynamicsModel()
+{
+  std::vector<std::string> joint_names;
+  return armJointNames(joint_names) &&
+         RobotDescription::loadModel(info_, joint_names, dynamics_model_);
+}
+
+void KortexMultiInterfaceHardware::resetFaults(k_api::Base::ServoingMode arm_mode)
+{
+  auto servoing_mode = k_api::Base::ServoingModeInformation();
+  try
+  {
+    // change servoing mode first
+    servoing_mode.set_servoing_mode(k_api::Base::ServoingMode::SINGLE_LEVEL_SERVOING);
+    base_.SetServoingMode(servoing_mode);
+    // apply emergency stop - twice to make it sure as calling it once appeared to be unreliable
+    // (detected by testing)
+    base_.ApplyEmergencyStop(0, {false, 0, 100});
+    base_.ApplyEmergencyStop(0, {false, 0, 100});
+    // clear faults
+    base_.ClearFaults();
+    // back to original servoing mode
+    if (
+      arm_mode == k_api::Base::ServoingMode::SINGLE_LEVEL_SERVOING ||
+      arm_mode == k_api::Base::ServoingMode::LOW_LEVEL_SERVOING)
+    {
+      servoing_mode.set_servoing_mode(arm_mode);
+      base_.SetServoingMode(servoing_mode);
+    }
+    reset_fault_result_ = 1;
+  }
+  catch (k_api::KDetailedException & ex)
+  {
+    RCLCPP_ERROR_STREAM(LOGGER, "Kortex exception: " << ex.what());
+
+    RCLCPP_ERROR_STREAM(
+      LOGGER, "Error sub-code: " << k_api::SubErrorCodes_Name(
+                k_api::SubErrorCodes((ex.getErrorInfo().getError().error_sub_code()))));
+    reset_fault_result_ = 0;
+  }
+  catch (...)
+  {
+    reset_fault_result_ = 0;
+  }
+  reset_fault_pending_ = false;
+}
+
 }  // namespace kortex_driver
 
 #include "pluginlib/class_list_macros.hpp"
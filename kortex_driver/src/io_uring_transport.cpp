@@ -0,0 +1,430 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include "kortex_driver/io_uring_transport.hpp"
+
+#include "rclcpp/rclcpp.hpp"
+
+namespace
+{
+const rclcpp::Logger LOGGER = rclcpp::get_logger("IoUringTransport");
+
+// user_data of a receive: generation and index of the slot
+std::uint64_t encode(std::uint32_t generation, std::size_t slot)
+{
+  return (static_cast<std::uint64_t>(generation) << 32) | static_cast<std::uint64_t>(slot);
+}
+}  // namespace
+
+namespace kortex_driver
+{
+std::shared_ptr<IoUringReactor> IoUringReactor::shared(const IoUringOptions & options)
+{
+  static std::mutex shared_mutex;
+  static std::weak_ptr<IoUringReactor> shared_reactor;
+
+  std::lock_guard<std::mutex> lock(shared_mutex);
+  std::shared_ptr<IoUringReactor> reactor = shared_reactor.lock();
+  if (!reactor)
+  {
+    reactor.reset(new IoUringReactor(options));
+    if (!reactor->initialize())
+    {
+      return nullptr;
+    }
+    shared_reactor = reactor;
+  }
+  else if (!(reactor->options() == options))
+  {
+    const IoUringOptions & used = reactor->options();
+    RCLCPP_WARN(
+      LOGGER,
+      "The io_uring of this process was already created with io_uring_entries %u, "
+      "io_uring_sqpoll %s and io_uring_max_sockets %zu, the options of this arm are ignored",
+      used.entries, used.sqpoll ? "true" : "false", used.max_sockets);
+  }
+  return reactor;
+}
+
+IoUringReactor::IoUringReactor(const IoUringOptions & options) : options_(options) {}
+
+bool IoUringReactor::initialize()
+{
+  io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+  if (options_.sqpoll)
+  {
+    params.flags |= IORING_SETUP_SQPOLL;
+    params.sq_thread_idle = 1000;
+  }
+  int ret = io_uring_queue_init_params(options_.entries, &ring_, &params);
+  if (ret < 0)
+  {
+    RCLCPP_ERROR(LOGGER, "Could not create io_uring: %s", std::strerror(-ret));
+    return false;
+  }
+  ring_initialized_ = true;
+  // the reactor thread waits with a timeout outside mutex_. Without EXT_ARG liburing queues a
+  // timeout on the submission queue for that, which attach() fills under mutex_ concurrently.
+  if ((params.features & IORING_FEAT_EXT_ARG) == 0)
+  {
+    RCLCPP_ERROR(LOGGER, "The io_uring transport needs a kernel with IORING_FEAT_EXT_ARG (5.11)");
+    return false;
+  }
+
+  // one receive buffer per socket, all registered with the ring
+  const std::size_t buffer_count = options_.max_sockets;
+  buffers_.resize(buffer_count * MAX_FRAME_SIZE);
+  iovecs_.resize(buffer_count);
+  for (std::size_t i = 0; i < buffer_count; i++)
+  {
+    iovecs_[i].iov_base = buffer(i);
+    iovecs_[i].iov_len = MAX_FRAME_SIZE;
+  }
+  ret = io_uring_register_buffers(&ring_, iovecs_.data(), static_cast<unsigned>(iovecs_.size()));
+  if (ret < 0)
+  {
+    RCLCPP_ERROR(LOGGER, "Could not register io_uring buffers: %s", std::strerror(-ret));
+    return false;
+  }
+  slots_.resize(options_.max_sockets);
+
+  running_ = true;
+  thread_ = std::thread(&IoUringReactor::run, this);
+  return true;
+}
+
+IoUringReactor::~IoUringReactor()
+{
+  running_ = false;
+  if (thread_.joinable())
+  {
+    thread_.join();
+  }
+  if (ring_initialized_)
+  {
+    io_uring_queue_exit(&ring_);
+  }
+}
+
+int IoUringReactor::attach(int fd, ReceiveCallback callback)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (std::size_t i = 0; i < slots_.size(); i++)
+  {
+    if (slots_[i].state != SlotState::FREE)
+    {
+      continue;
+    }
+    Slot & slot = slots_[i];
+    slot.fd = fd;
+    slot.state = SlotState::ACTIVE;
+    slot.generation++;
+    slot.callback = std::move(callback);
+    if (!armReceive(i))
+    {
+      slot.state = SlotState::FREE;
+      return -1;
+    }
+    io_uring_submit(&ring_);
+    return static_cast<int>(i);
+  }
+  RCLCPP_ERROR(LOGGER, "All %zu io_uring sockets are in use!", slots_.size());
+  return -1;
+}
+
+void IoUringReactor::detach(int slot_index)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  Slot & slot = slots_[static_cast<std::size_t>(slot_index)];
+  slot.state = SlotState::CLOSING;
+  // wakes up the pending receive, its completion frees the slot
+  ::shutdown(slot.fd, SHUT_RDWR);
+  if (!slot_freed_.wait_for(
+        lock, std::chrono::seconds(1), [&slot] { return slot.state == SlotState::FREE; }))
+  {
+    RCLCPP_WARN(LOGGER, "Pending io_uring receive did not complete, releasing the slot anyway");
+    slot.state = SlotState::FREE;
+  }
+  slot.callback = nullptr;
+}
+
+bool IoUringReactor::armReceive(std::size_t s)
+{
+  io_uring_sqe * sqe = io_uring_get_sqe(&ring_);
+  if (sqe == nullptr)
+  {
+    RCLCPP_ERROR(LOGGER, "io_uring submission queue is full!");
+    return false;
+  }
+  io_uring_prep_read_fixed(sqe, slots_[s].fd, buffer(s), MAX_FRAME_SIZE, 0, static_cast<int>(s));
+  sqe->user_data = encode(slots_[s].generation, s);
+  return true;
+}
+
+void IoUringReactor::run()
+{
+  while (running_)
+  {
+    io_uring_cqe * cqe = nullptr;
+    // only reads the completion queue, the ring has EXT_ARG
+    __kernel_timespec timeout{0, 100000000};
+    if (io_uring_wait_cqe_timeout(&ring_, &cqe, &timeout) != 0)
+    {
+      continue;
+    }
+    // reap every completion available before submitting the new receives in one go
+    do
+    {
+      const std::uint64_t user_data = cqe->user_data;
+      const int result = cqe->res;
+      io_uring_cqe_seen(&ring_, cqe);
+      handleCompletion(user_data, result);
+    } while (io_uring_peek_cqe(&ring_, &cqe) == 0);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    io_uring_submit(&ring_);
+  }
+}
+
+void IoUringReactor::handleCompletion(std::uint64_t user_data, int result)
+{
+  const std::uint32_t generation = static_cast<std::uint32_t>(user_data >> 32);
+  const std::size_t s = static_cast<std::size_t>(user_data & 0xffffffff);
+  if (s >= slots_.size())
+  {
+    return;
+  }
+  Slot & slot = slots_[s];
+
+  ReceiveCallback callback;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (slot.generation != generation)
+    {
+      return;
+    }
+    if (slot.state == SlotState::CLOSING)
+    {
+      slot.state = SlotState::FREE;
+      slot_freed_.notify_all();
+      return;
+    }
+    callback = slot.callback;
+  }
+
+  // the receive buffer is only re-armed once the router is done with the frame
+  if (result > 0 && callback)
+  {
+    callback(buffer(s), static_cast<uint32_t>(result));
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (slot.state == SlotState::ACTIVE)
+  {
+    armReceive(s);
+  }
+  else if (slot.state == SlotState::CLOSING)
+  {
+    slot.state = SlotState::FREE;
+    slot_freed_.notify_all();
+  }
+}
+
+IoUringUdpTransport::IoUringUdpTransport(std::shared_ptr<IoUringReactor> reactor)
+: reactor_(std::move(reactor)), tx_buffer_(IoUringReactor::MAX_FRAME_SIZE)
+{
+}
+
+IoUringUdpTransport::~IoUringUdpTransport() { disconnect(); }
+
+bool IoUringUdpTransport::initializeSendRing()
+{
+  // the poller thread of the reactor also serves this ring, a single one for the process
+  io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+  params.flags = IORING_SETUP_SQPOLL | IORING_SETUP_ATTACH_WQ;
+  params.sq_thread_idle = 1000;
+  params.wq_fd = static_cast<__u32>(reactor_->ringFd());
+  int ret = io_uring_queue_init_params(2 * TX_DEPTH, &send_ring_, &params);
+  if (ret < 0)
+  {
+    RCLCPP_ERROR(LOGGER, "Could not create the io_uring send ring: %s", std::strerror(-ret));
+    return false;
+  }
+  send_ring_initialized_ = true;
+
+  send_buffers_.resize(TX_DEPTH * MAX_FRAME_SIZE);
+  send_iovecs_.resize(TX_DEPTH);
+  for (std::uint32_t i = 0; i < TX_DEPTH; i++)
+  {
+    send_iovecs_[i].iov_base = sendBuffer(i);
+    send_iovecs_[i].iov_len = MAX_FRAME_SIZE;
+  }
+  ret = io_uring_register_buffers(&send_ring_, send_iovecs_.data(), TX_DEPTH);
+  if (ret == 0)
+  {
+    // registered files let the poller thread use the socket without a lookup per request
+    ret = io_uring_register_files(&send_ring_, &socket_, 1);
+  }
+  if (ret < 0)
+  {
+    RCLCPP_ERROR(LOGGER, "Could not register the io_uring send buffers: %s", std::strerror(-ret));
+    return false;
+  }
+  next_tx_ = 0;
+  tx_in_flight_ = 0;
+  return true;
+}
+
+void IoUringUdpTransport::reapSendCompletions()
+{
+  // the completion queue is mapped, peeking at it does not enter the kernel
+  io_uring_cqe * cqe = nullptr;
+  while (io_uring_peek_cqe(&send_ring_, &cqe) == 0)
+  {
+    if (cqe->res < 0)
+    {
+      send_failures_.fetch_add(1, std::memory_order_relaxed);
+    }
+    tx_in_flight_ &= ~(1u << static_cast<std::uint32_t>(cqe->user_data));
+    io_uring_cqe_seen(&send_ring_, cqe);
+  }
+}
+
+bool IoUringUdpTransport::connect(std::string host, uint32_t port)
+{
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(static_cast<uint16_t>(port));
+  if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1)
+  {
+    RCLCPP_ERROR(LOGGER, "Invalid robot address '%s'", host.c_str());
+    return false;
+  }
+
+  socket_ = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  if (socket_ < 0)
+  {
+    RCLCPP_ERROR(LOGGER, "Could not create socket: %s", std::strerror(errno));
+    return false;
+  }
+  if (::connect(socket_, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+  {
+    RCLCPP_ERROR(
+      LOGGER, "Could not connect to %s:%u: %s", host.c_str(), port, std::strerror(errno));
+    ::close(socket_);
+    socket_ = -1;
+    return false;
+  }
+
+  slot_ = reactor_->attach(
+    socket_, [this](const char * rx_buffer, uint32_t rx_size)
+    {
+      if (callback_)
+      {
+        callback_(rx_buffer, rx_size);
+      }
+    });
+  if (slot_ < 0 || (reactor_->options().sqpoll && !initializeSendRing()))
+  {
+    disconnect();
+    return false;
+  }
+  return true;
+}
+
+void IoUringUdpTransport::disconnect()
+{
+  if (send_ring_initialized_)
+  {
+    io_uring_queue_exit(&send_ring_);
+    send_ring_initialized_ = false;
+  }
+  if (send_failures_ > 0)
+  {
+    RCLCPP_WARN(
+      LOGGER, "%lu frames could not be sent",
+      static_cast<unsigned long>(send_failures_.exchange(0)));  // NOLINT(runtime/int)
+  }
+  if (slot_ >= 0)
+  {
+    reactor_->detach(slot_);
+    slot_ = -1;
+  }
+  if (socket_ >= 0)
+  {
+    ::close(socket_);
+    socket_ = -1;
+  }
+}
+
+void IoUringUdpTransport::send(const char * tx_buffer, uint32_t tx_size)
+{
+  io_uring_sqe * sqe = nullptr;
+  if (send_ring_initialized_ && tx_size <= MAX_FRAME_SIZE)
+  {
+    reapSendCompletions();
+    if (!(tx_in_flight_ & (1u << next_tx_)))
+    {
+      sqe = io_uring_get_sqe(&send_ring_);
+    }
+  }
+  if (sqe == nullptr)
+  {
+    // no send ring, or every send buffer is still in flight
+    if (socket_ < 0 || ::send(socket_, tx_buffer, tx_size, 0) < 0)
+    {
+      send_failures_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return;
+  }
+
+  const std::uint32_t tx = next_tx_;
+  std::memcpy(sendBuffer(tx), tx_buffer, tx_size);
+  // the socket is registered file 0
+  io_uring_prep_write_fixed(sqe, 0, sendBuffer(tx), tx_size, 0, static_cast<int>(tx));
+  sqe->flags |= IOSQE_FIXED_FILE;
+  sqe->user_data = tx;
+  tx_in_flight_ |= (1u << tx);
+  next_tx_ = (tx + 1) % TX_DEPTH;
+  // with SQPOLL this only publishes the new tail of the submission queue, the kernel is only
+  // entered to wake up the poller thread after it went idle for sq_thread_idle
+  if (io_uring_submit(&send_ring_) < 0)
+  {
+    send_failures_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void IoUringUdpTransport::onMessage(std::function<void(const char *, uint32_t)> callback)
+{
+  callback_ = std::move(callback);
+}
+
+char * IoUringUdpTransport::getTxBuffer() { return tx_buffer_.data(); }
+
+size_t IoUringUdpTransport::getMaxTxBufferSize() { return tx_buffer_.size(); }
+
+}  // namespace kortex_driver
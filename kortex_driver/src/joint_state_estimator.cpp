@@ -0,0 +1,72 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "kortex_driver/joint_state_estimator.hpp"
+#include "kortex_driver/kortex_math_util.hpp"
+
+namespace kortex_driver
+{
+void JointStateEstimator::configure(std::size_t joint_count, double discount)
+{
+  const double theta = std::min(std::max(discount, 0.0), 0.999);
+  const double one_minus_theta = 1.0 - theta;
+  alpha_ = 1.0 - theta * theta * theta;
+  beta_ = 1.5 * one_minus_theta * one_minus_theta * (1.0 + theta);
+  gamma_ = 0.5 * one_minus_theta * one_minus_theta * one_minus_theta;
+
+  positions_.assign(joint_count, std::numeric_limits<double>::quiet_NaN());
+  velocities_.assign(joint_count, std::numeric_limits<double>::quiet_NaN());
+  accelerations_.assign(joint_count, std::numeric_limits<double>::quiet_NaN());
+  initialized_ = false;
+}
+
+void JointStateEstimator::reset() { initialized_ = false; }
+
+void JointStateEstimator::update(
+  const std::vector<double> & positions, const std::vector<double> & velocities, double dt)
+{
+  if (!initialized_)
+  {
+    std::copy(positions.begin(), positions.end(), positions_.begin());
+    std::copy(velocities.begin(), velocities.end(), velocities_.begin());
+    std::fill(accelerations_.begin(), accelerations_.end(), 0.0);
+    initialized_ = true;
+    return;
+  }
+  if (dt <= 0.0)
+  {
+    return;
+  }
+
+  for (std::size_t i = 0; i < positions_.size(); i++)
+  {
+    // constant acceleration prediction, then correction by the position residual
+    const double predicted_position =
+      positions_[i] + velocities_[i] * dt + 0.5 * accelerations_[i] * dt * dt;
+    const double predicted_velocity = velocities_[i] + accelerations_[i] * dt;
+    // the measurement is wrapped, the residual must not jump by a turn at +-pi
+    const double residual = std::remainder(positions[i] - predicted_position, 2 * M_PI);
+
+    positions_[i] =
+      KortexMathUtil::wrapRadiansFromMinusPiToPi(predicted_position + alpha_ * residual);
+    velocities_[i] = predicted_velocity + beta_ * residual / dt;
+    accelerations_[i] += 2.0 * gamma_ * residual / (dt * dt);
+  }
+}
+
+}  // namespace kortex_driver
@@ -0,0 +1,165 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+
+#include "kortex_driver/kortex_math_util.hpp"
+#include "kortex_driver/latency_predictor.hpp"
+
+namespace
+{
+// predictions older than this many frames are dropped unchecked
+constexpr std::size_t PENDING_PREDICTIONS = 16;
+}  // namespace
+
+namespace kortex_driver
+{
+void LatencyPredictionStatistics::reset()
+{
+  horizon = 0.0;
+  error_rms = 0.0;
+  error_max = 0.0;
+  checked_predictions = 0.0;
+}
+
+void LatencyPredictor::configure(
+  std::size_t joint_count, bool enabled, double max_horizon, double smoothing)
+{
+  enabled_ = enabled;
+  max_horizon_ = std::max(0.0, max_horizon);
+  smoothing_ = std::min(std::max(smoothing, 1e-3), 1.0);
+  previous_velocities_.assign(joint_count, 0.0);
+  accelerations_.assign(joint_count, 0.0);
+  pending_.resize(PENDING_PREDICTIONS);
+  for (auto & prediction : pending_)
+  {
+    prediction.positions.assign(joint_count, 0.0);
+  }
+  reset();
+}
+
+void LatencyPredictor::reset()
+{
+  statistics_.reset();
+  error_mean_square_ = 0.0;
+  sample_ns_ = -1;
+  previous_response_ns_ = -1;
+  predicted_sample_ns_ = -1;
+  std::fill(accelerations_.begin(), accelerations_.end(), 0.0);
+  pending_head_ = 0;
+  pending_count_ = 0;
+}
+
+void LatencyPredictor::recordExchange(
+  std::int64_t request_ns, std::int64_t response_ns, bool sent_command)
+{
+  const std::int64_t round_trip_ns = response_ns - request_ns;
+  if (sent_command && previous_response_ns_ >= 0)
+  {
+    // the command was computed from the previous frame, sampled half a round trip before it
+    // was received, and applies half a round trip after this request
+    const double horizon =
+      std::min(max_horizon_, (request_ns - previous_response_ns_ + round_trip_ns) / 1e9);
+    statistics_.horizon = statistics_.horizon > 0.0
+                            ? statistics_.horizon + smoothing_ * (horizon - statistics_.horizon)
+                            : horizon;
+  }
+  previous_response_ns_ = response_ns;
+  sample_ns_ = response_ns - round_trip_ns / 2;
+}
+
+void LatencyPredictor::predict(std::vector<double> & positions, std::vector<double> & velocities)
+{
+  if (!enabled_ || sample_ns_ < 0)
+  {
+    return;
+  }
+
+  const bool new_frame = sample_ns_ != predicted_sample_ns_;
+  if (new_frame)
+  {
+    checkPredictions(positions);
+    if (predicted_sample_ns_ >= 0)
+    {
+      const double dt = (sample_ns_ - predicted_sample_ns_) / 1e9;
+      for (std::size_t i = 0; i < accelerations_.size(); i++)
+      {
+        const double acceleration = (velocities[i] - previous_velocities_[i]) / dt;
+        accelerations_[i] += smoothing_ * (acceleration - accelerations_[i]);
+      }
+    }
+    std::copy(velocities.begin(), velocities.end(), previous_velocities_.begin());
+    predicted_sample_ns_ = sample_ns_;
+  }
+
+  const double horizon = statistics_.horizon;
+  for (std::size_t i = 0; i < accelerations_.size(); i++)
+  {
+    positions[i] = KortexMathUtil::wrapRadiansFromMinusPiToPi(
+      positions[i] + velocities[i] * horizon + 0.5 * accelerations_[i] * horizon * horizon);
+    velocities[i] += accelerations_[i] * horizon;
+  }
+
+  // nothing to check before the first horizon is measured
+  if (new_frame && horizon > 0.0)
+  {
+    if (pending_count_ == pending_.size())
+    {
+      pending_head_ = (pending_head_ + 1) % pending_.size();
+      pending_count_--;
+    }
+    Prediction & prediction = pending_[(pending_head_ + pending_count_) % pending_.size()];
+    pending_count_++;
+    prediction.target_ns = sample_ns_ + static_cast<std::int64_t>(horizon * 1e9);
+    std::copy(positions.begin(), positions.end(), prediction.positions.begin());
+  }
+}
+
+void LatencyPredictor::checkPredictions(const std::vector<double> & positions)
+{
+  // the prediction whose target is the closest to the sampling time of this frame
+  const Prediction * closest = nullptr;
+  while (pending_count_ > 0 && pending_[pending_head_].target_ns <= sample_ns_)
+  {
+    closest = &pending_[pending_head_];
+    pending_head_ = (pending_head_ + 1) % pending_.size();
+    pending_count_--;
+  }
+  if (closest == nullptr)
+  {
+    return;
+  }
+  if (
+    pending_count_ > 0 &&
+    pending_[pending_head_].target_ns - sample_ns_ < sample_ns_ - closest->target_ns)
+  {
+    closest = &pending_[pending_head_];
+    pending_head_ = (pending_head_ + 1) % pending_.size();
+    pending_count_--;
+  }
+
+  double error = 0.0;
+  for (std::size_t i = 0; i < positions.size(); i++)
+  {
+    const double difference = std::remainder(closest->positions[i] - positions[i], 2 * M_PI);
+    error = std::max(error, std::abs(difference));
+  }
+  error_mean_square_ += smoothing_ * (error * error - error_mean_square_);
+  statistics_.error_rms = std::sqrt(error_mean_square_);
+  statistics_.error_max = std::max(statistics_.error_max, error);
+  statistics_.checked_predictions += 1.0;
+}
+
+}  // namespace kortex_driver
@@ -0,0 +1,111 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <utility>
+
+#include "kortex_driver/metered_transport.hpp"
+
+namespace kortex_driver
+{
+MeteredTransport::MeteredTransport(k_api::ITransportClient * transport) : transport_(transport) {}
+
+bool MeteredTransport::connect(std::string host, uint32_t port)
+{
+  return transport_->connect(std::move(host), port);
+}
+
+void MeteredTransport::disconnect() { transport_->disconnect(); }
+
+void MeteredTransport::send(const char * tx_buffer, uint32_t tx_size)
+{
+  tx_bytes_.fetch_add(tx_size, std::memory_order_relaxed);
+  tx_packets_.fetch_add(1, std::memory_order_relaxed);
+  transport_->send(tx_buffer, tx_size);
+}
+
+void MeteredTransport::onMessage(std::function<void(const char *, uint32_t)> callback)
+{
+  callback_ = std::move(callback);
+  registerCallback();
+}
+
+void MeteredTransport::setTransport(k_api::ITransportClient * transport)
+{
+  transport_ = transport;
+  if (callback_)
+  {
+    registerCallback();
+  }
+}
+
+void MeteredTransport::registerCallback()
+{
+  transport_->onMessage(
+    [this](const char * rx_buffer, uint32_t rx_size)
+    {
+      rx_bytes_.fetch_add(rx_size, std::memory_order_relaxed);
+      rx_packets_.fetch_add(1, std::memory_order_relaxed);
+      callback_(rx_buffer, rx_size);
+    });
+}
+
+char * MeteredTransport::getTxBuffer() { return transport_->getTxBuffer(); }
+
+size_t MeteredTransport::getMaxTxBufferSize() { return transport_->getMaxTxBufferSize(); }
+
+TrafficCounters MeteredTransport::counters() const
+{
+  TrafficCounters counters;
+  counters.tx_bytes = tx_bytes_.load(std::memory_order_relaxed);
+  counters.tx_packets = tx_packets_.load(std::memory_order_relaxed);
+  counters.rx_bytes = rx_bytes_.load(std::memory_order_relaxed);
+  counters.rx_packets = rx_packets_.load(std::memory_order_relaxed);
+  return counters;
+}
+
+void TrafficRates::update(
+  const TrafficCounters & counters, double period_seconds, double window_seconds)
+{
+  if (!started_)
+  {
+    window_start_ = counters;
+    started_ = true;
+    return;
+  }
+
+  window_elapsed_ += period_seconds;
+  window_cycles_++;
+  if (window_elapsed_ < window_seconds)
+  {
+    return;
+  }
+
+  tx_bytes_per_second =
+    static_cast<double>(counters.tx_bytes - window_start_.tx_bytes) / window_elapsed_;
+  rx_bytes_per_second =
+    static_cast<double>(counters.rx_bytes - window_start_.rx_bytes) / window_elapsed_;
+  tx_packets_per_second =
+    static_cast<double>(counters.tx_packets - window_start_.tx_packets) / window_elapsed_;
+  rx_packets_per_second =
+    static_cast<double>(counters.rx_packets - window_start_.rx_packets) / window_elapsed_;
+  tx_packets_per_cycle = static_cast<double>(counters.tx_packets - window_start_.tx_packets) /
+                         static_cast<double>(window_cycles_);
+
+  window_start_ = counters;
+  window_elapsed_ = 0.0;
+  window_cycles_ = 0;
+}
+
+}  // namespace kortex_driver
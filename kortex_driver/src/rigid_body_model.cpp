@@ -0,0 +1,360 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "kortex_driver/rigid_body_model.hpp"
+
+#include "rclcpp/rclcpp.hpp"
+#include "urdf/model.h"
+
+namespace
+{
+const rclcpp::Logger LOGGER = rclcpp::get_logger("RigidBodyModel");
+
+Eigen::Isometry3d toIsometry(const urdf::Pose & pose)
+{
+  Eigen::Isometry3d transform = Eigen::Isometry3d::Identity();
+  transform.translation() = Eigen::Vector3d(pose.position.x, pose.position.y, pose.position.z);
+  transform.linear() =
+    Eigen::Quaterniond(pose.rotation.w, pose.rotation.x, pose.rotation.y, pose.rotation.z)
+      .toRotationMatrix();
+  return transform;
+}
+
+// Mass, first and second moments of the links merged into a body, about the body origin
+struct MassAccumulator
+{
+  double mass = 0.0;
+  Eigen::Vector3d moment = Eigen::Vector3d::Zero();
+  Eigen::Matrix3d inertia = Eigen::Matrix3d::Zero();
+
+  void add(const urdf::Link & link, const Eigen::Isometry3d & link_in_body)
+  {
+    if (!link.inertial || link.inertial->mass <= 0.0)
+    {
+      return;
+    }
+    const urdf::Inertial & inertial = *link.inertial;
+    const Eigen::Isometry3d frame = link_in_body * toIsometry(inertial.origin);
+    Eigen::Matrix3d local;
+    local << inertial.ixx, inertial.ixy, inertial.ixz, inertial.ixy, inertial.iyy, inertial.iyz,
+      inertial.ixz, inertial.iyz, inertial.izz;
+    const Eigen::Vector3d center = frame.translation();
+    mass += inertial.mass;
+    moment += inertial.mass * center;
+    // parallel axis theorem, from the link's center of mass to the body origin
+    inertia += frame.linear() * local * frame.linear().transpose() +
+               inertial.mass * (center.squaredNorm() * Eigen::Matrix3d::Identity() -
+                                center * center.transpose());
+  }
+
+  void store(kortex_driver::RigidBodyModel::Body & body) const
+  {
+    body.mass = mass;
+    body.center_of_mass = mass > 0.0 ? Eigen::Vector3d(moment / mass) : Eigen::Vector3d::Zero();
+    const Eigen::Vector3d & c = body.center_of_mass;
+    body.inertia =
+      inertia - mass * (c.squaredNorm() * Eigen::Matrix3d::Identity() - c * c.transpose());
+  }
+};
+
+// Walks everything rigidly attached to link, stopping at next_joint whose origin it reports.
+// Joints that are not part of the chain are taken at their zero position.
+void collectBody(
+  const urdf::Model & model, const urdf::Link & link, const Eigen::Isometry3d & link_in_body,
+  const std::vector<std::string> & joint_names, const std::string & next_joint,
+  MassAccumulator & accumulator, bool & found_next, Eigen::Isometry3d & next_origin)
+{
+  accumulator.add(link, link_in_body);
+  for (const auto & joint : link.child_joints)
+  {
+    const Eigen::Isometry3d joint_in_body =
+      link_in_body * toIsometry(joint->parent_to_joint_origin_transform);
+    if (joint->name == next_joint)
+    {
+      found_next = true;
+      next_origin = joint_in_body;
+      continue;
+    }
+    if (std::find(joint_names.begin(), joint_names.end(), joint->name) != joint_names.end())
+    {
+      continue;
+    }
+    const urdf::LinkConstSharedPtr child = model.getLink(joint->child_link_name);
+    if (child)
+    {
+      collectBody(
+        model, *child, joint_in_body, joint_names, next_joint, accumulator, found_next,
+        next_origin);
+    }
+  }
+}
+}  // namespace
+
+namespace kortex_driver
+{
+bool RigidBodyModel::loadUrdf(
+  const std::string & urdf, const std::vector<std::string> & joint_names,
+  const Eigen::Vector3d & gravity)
+{
+  if (joint_names.empty() || joint_names.size() > static_cast<std::size_t>(MAX_JOINTS))
+  {
+    RCLCPP_ERROR(
+      LOGGER, "The model supports 1 to %d joints, not %zu", MAX_JOINTS, joint_names.size());
+    return false;
+  }
+  urdf::Model model;
+  if (!model.initString(urdf))
+  {
+    RCLCPP_ERROR(LOGGER, "Could not parse the robot description");
+    return false;
+  }
+
+  std::vector<Body> bodies(joint_names.size());
+  for (std::size_t i = 0; i < joint_names.size(); i++)
+  {
+    const urdf::JointConstSharedPtr joint = model.getJoint(joint_names[i]);
+    if (!joint)
+    {
+      RCLCPP_ERROR(LOGGER, "Joint '%s' is not in the robot description", joint_names[i].c_str());
+      return false;
+    }
+    if (joint->type != urdf::Joint::REVOLUTE && joint->type != urdf::Joint::CONTINUOUS)
+    {
+      RCLCPP_ERROR(LOGGER, "Joint '%s' is not revolute", joint_names[i].c_str());
+      return false;
+    }
+    bodies[i].axis = Eigen::Vector3d(joint->axis.x, joint->axis.y, joint->axis.z).normalized();
+  }
+
+  // pose of the first joint in its parent link, where gravity is expressed
+  const urdf::JointConstSharedPtr first_joint = model.getJoint(joint_names.front());
+  const Eigen::Isometry3d first_origin = toIsometry(first_joint->parent_to_joint_origin_transform);
+  bodies[0].rotation = first_origin.linear();
+  bodies[0].translation = first_origin.translation();
+
+  for (std::size_t i = 0; i < joint_names.size(); i++)
+  {
+    const urdf::JointConstSharedPtr joint = model.getJoint(joint_names[i]);
+    const urdf::LinkConstSharedPtr child = model.getLink(joint->child_link_name);
+    const std::string next_joint = i + 1 < joint_names.size() ? joint_names[i + 1] : "";
+    MassAccumulator accumulator;
+    bool found_next = false;
+    Eigen::Isometry3d next_origin = Eigen::Isometry3d::Identity();
+    collectBody(
+      model, *child, Eigen::Isometry3d::Identity(), joint_names, next_joint, accumulator,
+      found_next, next_origin);
+    if (!next_joint.empty() && !found_next)
+    {
+      RCLCPP_ERROR(
+        LOGGER, "Joint '%s' does not follow '%s' in a serial chain", next_joint.c_str(),
+        joint_names[i].c_str());
+      return false;
+    }
+    accumulator.store(bodies[i]);
+    if (found_next)
+    {
+      bodies[i + 1].rotation = next_origin.linear();
+      bodies[i + 1].translation = next_origin.translation();
+    }
+  }
+
+  setBodies(bodies, gravity);
+  return true;
+}
+
+void RigidBodyModel::setBodies(const std::vector<Body> & bodies, const Eigen::Vector3d & gravity)
+{
+  joint_count_ = static_cast<int>(std::min(bodies.size(), static_cast<std::size_t>(MAX_JOINTS)));
+  std::copy(bodies.begin(), bodies.begin() + joint_count_, bodies_.begin());
+  gravity_ = gravity;
+  zero_ = JointVector::Zero(joint_count_);
+
+  z_axes_ = true;
+  for (int i = 0; i < joint_count_; i++)
+  {
+    const Body & body = bodies_[i];
+    z_axes_ &= body.axis.isApprox(Eigen::Vector3d::UnitZ());
+    const Eigen::Vector3d & c = body.center_of_mass;
+    first_moments_[i] = body.mass * c;
+    // parallel axis theorem, from the center of mass to the joint origin
+    origin_inertias_[i] =
+      body.inertia +
+      body.mass * (c.squaredNorm() * Eigen::Matrix3d::Identity() - c * c.transpose());
+  }
+}
+
+void RigidBodyModel::updateRotations(const JointVector & q)
+{
+  for (int i = 0; i < joint_count_; i++)
+  {
+    const Eigen::Matrix3d & fixed = bodies_[i].rotation;
+    if (z_axes_)
+    {
+      // fixed * Rz(q), only the first two columns change
+      const double c = std::cos(q[i]);
+      const double s = std::sin(q[i]);
+      rotations_[i].col(0) = c * fixed.col(0) + s * fixed.col(1);
+      rotations_[i].col(1) = c * fixed.col(1) - s * fixed.col(0);
+      rotations_[i].col(2) = fixed.col(2);
+    }
+    else
+    {
+      rotations_[i] = fixed * Eigen::AngleAxisd(q[i], bodies_[i].axis).toRotationMatrix();
+    }
+  }
+}
+
+void RigidBodyModel::updateComposites()
+{
+  for (int i = joint_count_ - 1; i >= 0; i--)
+  {
+    composite_masses_[i] = bodies_[i].mass;
+    composite_moments_[i] = first_moments_[i];
+    composite_inertias_[i] = origin_inertias_[i];
+    if (i + 1 < joint_count_)
+    {
+      // move the child composite from its joint origin to this one
+      const Eigen::Matrix3d & rotation = rotations_[i + 1];
+      const Eigen::Vector3d & t = bodies_[i + 1].translation;
+      const double mass = composite_masses_[i + 1];
+      const Eigen::Vector3d moment = rotation * composite_moments_[i + 1];
+      composite_masses_[i] += mass;
+      composite_moments_[i] += moment + mass * t;
+      composite_inertias_[i] +=
+        rotation * composite_inertias_[i + 1] * rotation.transpose() +
+        (mass * t.squaredNorm() + 2.0 * t.dot(moment)) * Eigen::Matrix3d::Identity() -
+        mass * t * t.transpose() - moment * t.transpose() - t * moment.transpose();
+    }
+  }
+}
+
+void RigidBodyModel::inverseDynamics(
+  const JointVector & q, const JointVector & qd, const JointVector & qdd, bool with_gravity,
+  JointVector & tau)
+{
+  tau.resize(joint_count_);
+
+  // outward pass, velocities and accelerations of each body in its own frame. The base
+  // accelerates upwards instead of gravity pulling every body down.
+  Eigen::Vector3d angular_velocity = Eigen::Vector3d::Zero();
+  Eigen::Vector3d angular_acceleration = Eigen::Vector3d::Zero();
+  Eigen::Vector3d linear_acceleration = with_gravity ? Eigen::Vector3d(-gravity_)
+                                                     : Eigen::Vector3d(Eigen::Vector3d::Zero());
+  updateRotations(q);
+  for (int i = 0; i < joint_count_; i++)
+  {
+    const Body & body = bodies_[i];
+    const Eigen::Matrix3d to_body = rotations_[i].transpose();
+
+    linear_acceleration =
+      to_body * (linear_acceleration + angular_acceleration.cross(body.translation) +
+                 angular_velocity.cross(angular_velocity.cross(body.translation)));
+    const Eigen::Vector3d parent_angular_velocity = to_body * angular_velocity;
+    angular_velocity = parent_angular_velocity + body.axis * qd[i];
+    angular_acceleration = to_body * angular_acceleration + body.axis * qdd[i] +
+                           parent_angular_velocity.cross(body.axis * qd[i]);
+
+    angular_velocities_[i] = angular_velocity;
+    angular_accelerations_[i] = angular_acceleration;
+    linear_accelerations_[i] = linear_acceleration;
+  }
+
+  // inward pass, force and torque each body receives from its joint
+  Eigen::Vector3d child_force = Eigen::Vector3d::Zero();
+  Eigen::Vector3d child_torque = Eigen::Vector3d::Zero();
+  for (int i = joint_count_ - 1; i >= 0; i--)
+  {
+    const Body & body = bodies_[i];
+    const Eigen::Vector3d & w = angular_velocities_[i];
+    const Eigen::Vector3d & dw = angular_accelerations_[i];
+    const Eigen::Vector3d & c = body.center_of_mass;
+    const Eigen::Vector3d center_acceleration =
+      linear_accelerations_[i] + dw.cross(c) + w.cross(w.cross(c));
+    const Eigen::Vector3d inertial_force = body.mass * center_acceleration;
+    const Eigen::Vector3d inertial_torque = body.inertia * dw + w.cross(body.inertia * w);
+
+    forces_[i] = inertial_force;
+    torques_[i] = inertial_torque + c.cross(inertial_force);
+    if (i + 1 < joint_count_)
+    {
+      const Eigen::Vector3d force_from_child = rotations_[i + 1] * child_force;
+      forces_[i] += force_from_child;
+      torques_[i] += rotations_[i + 1] * child_torque +
+                     bodies_[i + 1].translation.cross(force_from_child);
+    }
+    child_force = forces_[i];
+    child_torque = torques_[i];
+    tau[i] = torques_[i].dot(body.axis);
+  }
+}
+
+void RigidBodyModel::gravityTorques(const JointVector & q, JointVector & tau)
+{
+  tau.resize(joint_count_);
+  updateRotations(q);
+  updateComposites();
+  // at rest a joint holds the weight of everything after it, acting at its center of mass
+  Eigen::Vector3d lift = -gravity_;
+  for (int i = 0; i < joint_count_; i++)
+  {
+    lift = rotations_[i].transpose() * lift;
+    tau[i] = bodies_[i].axis.dot(composite_moments_[i].cross(lift));
+  }
+}
+
+void RigidBodyModel::coriolisTorques(
+  const JointVector & q, const JointVector & qd, JointVector & tau)
+{
+  inverseDynamics(q, qd, zero_, false, tau);
+}
+
+void RigidBodyModel::massMatrix(const JointVector & q, JointMatrix & mass_matrix)
+{
+  mass_matrix.resize(joint_count_, joint_count_);
+  updateRotations(q);
+  updateComposites();
+  for (int j = 0; j < joint_count_; j++)
+  {
+    // momentum of the composite of j moving at unit speed, carried down to the base
+    const Eigen::Vector3d & axis = bodies_[j].axis;
+    Eigen::Vector3d torque = composite_inertias_[j] * axis;
+    Eigen::Vector3d force = axis.cross(composite_moments_[j]);
+    mass_matrix(j, j) = axis.dot(torque);
+    for (int i = j - 1; i >= 0; i--)
+    {
+      force = rotations_[i + 1] * force;
+      torque = rotations_[i + 1] * torque + bodies_[i + 1].translation.cross(force);
+      mass_matrix(i, j) = bodies_[i].axis.dot(torque);
+      mass_matrix(j, i) = mass_matrix(i, j);
+    }
+  }
+}
+
+void RigidBodyModel::massMatrixDiagonal(const JointVector & q, JointVector & diagonal)
+{
+  diagonal.resize(joint_count_);
+  updateRotations(q);
+  updateComposites();
+  for (int i = 0; i < joint_count_; i++)
+  {
+    diagonal[i] = bodies_[i].axis.dot(composite_inertias_[i] * bodies_[i].axis);
+  }
+}
+
+}  // namespace kortex_driver
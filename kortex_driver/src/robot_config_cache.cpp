@@ -0,0 +1,174 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <sys/stat.h>
+
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "kortex_driver/robot_config_cache.hpp"
+
+#include "rclcpp/rclcpp.hpp"
+
+namespace
+{
+const rclcpp::Logger LOGGER = rclcpp::get_logger("RobotConfigCache");
+
+// bumped whenever the layout of the file changes, older files are ignored
+constexpr char FORMAT_HEADER[] = "kortex_driver_robot_config 2";
+
+// Creates directory and its parents, succeeds when they already exist
+bool makeDirectories(const std::string & directory)
+{
+  for (std::size_t position = 1; position <= directory.size(); position++)
+  {
+    if (position == directory.size() || directory[position] == '/')
+    {
+      const std::string parent = directory.substr(0, position);
+      if (mkdir(parent.c_str(), 0755) != 0 && errno != EEXIST)
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+}  // namespace
+
+namespace kortex_driver
+{
+RobotConfigCache::RobotConfigCache(std::string directory) : directory_(std::move(directory)) {}
+
+bool RobotConfigCache::load(
+  const std::string & serial_number, std::uint32_t firmware_version,
+  RobotConfiguration & configuration) const
+{
+  std::ifstream file(path(serial_number));
+  std::string line;
+  if (!file || !std::getline(file, line) || line != FORMAT_HEADER)
+  {
+    return false;
+  }
+
+  RobotConfiguration loaded;
+  bool has_actuator_count = false;
+  while (std::getline(file, line))
+  {
+    std::istringstream fields(line);
+    std::string key;
+    fields >> key;
+    if (key == "serial_number")
+    {
+      fields >> loaded.serial_number;
+    }
+    else if (key == "firmware_version")
+    {
+      fields >> loaded.firmware_version;
+    }
+    else if (key == "actuator_count")
+    {
+      has_actuator_count = static_cast<bool>(fields >> loaded.actuator_count);
+    }
+    else if (key == "device")
+    {
+      RobotConfiguration::Device device;
+      if (fields >> device.type >> device.identifier >> device.order)
+      {
+        loaded.devices.push_back(device);
+      }
+    }
+    else if (key == "gripper_installed")
+    {
+      fields >> loaded.gripper_installed;
+    }
+  }
+
+  if (
+    !has_actuator_count || loaded.serial_number != serial_number ||
+    loaded.firmware_version != firmware_version)
+  {
+    return false;
+  }
+  configuration = std::move(loaded);
+  return true;
+}
+
+bool RobotConfigCache::store(const RobotConfiguration & configuration) const
+{
+  if (!makeDirectories(directory_))
+  {
+    RCLCPP_WARN(LOGGER, "Could not create '%s': %s", directory_.c_str(), std::strerror(errno));
+    return false;
+  }
+
+  // written next to the final file and renamed, a concurrent reader never sees half of it
+  const std::string file_name = path(configuration.serial_number);
+  const std::string temporary_name = file_name + ".tmp";
+  {
+    std::ofstream file(temporary_name, std::ios::trunc);
+    file << FORMAT_HEADER << '\n';
+    file << "serial_number " << configuration.serial_number << '\n';
+    file << "firmware_version " << configuration.firmware_version << '\n';
+    file << "actuator_count " << configuration.actuator_count << '\n';
+    for (const auto & device : configuration.devices)
+    {
+      file << "device " << device.type << ' ' << device.identifier << ' ' << device.order << '\n';
+    }
+    file << "gripper_installed " << configuration.gripper_installed << '\n';
+    if (!file.flush())
+    {
+      RCLCPP_WARN(LOGGER, "Could not write '%s'", temporary_name.c_str());
+      return false;
+    }
+  }
+  if (std::rename(temporary_name.c_str(), file_name.c_str()) != 0)
+  {
+    RCLCPP_WARN(
+      LOGGER, "Could not rename '%s': %s", temporary_name.c_str(), std::strerror(errno));
+    std::remove(temporary_name.c_str());
+    return false;
+  }
+  return true;
+}
+
+std::string RobotConfigCache::path(const std::string & serial_number) const
+{
+  // the serial number comes from the robot, keep only characters that are safe in a file name
+  std::string name;
+  for (const char c : serial_number)
+  {
+    name += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+  }
+  return directory_ + "/" + (name.empty() ? "unknown" : name) + ".config";
+}
+
+std::string RobotConfigCache::defaultDirectory()
+{
+  const char * ros_home = std::getenv("ROS_HOME");
+  if (ros_home != nullptr && ros_home[0] != '\0')
+  {
+    return std::string(ros_home) + "/kortex_driver";
+  }
+  const char * home = std::getenv("HOME");
+  return std::string(home != nullptr ? home : ".") + "/.ros/kortex_driver";
+}
+
+}  // namespace kortex_driver
@@ -0,0 +1,149 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "kortex_driver/hardware_parameters.hpp"
+#include "kortex_driver/robot_description.hpp"
+
+#include "rclcpp/rclcpp.hpp"
+#include "std_msgs/msg/string.hpp"
+#include "urdf/model.h"
+
+namespace
+{
+const rclcpp::Logger LOGGER = rclcpp::get_logger("RobotDescription");
+}  // namespace
+
+namespace kortex_driver
+{
+namespace RobotDescription
+{
+bool readFile(const std::string & path, std::string & urdf)
+{
+  std::ifstream file(path);
+  if (!file)
+  {
+    RCLCPP_ERROR(LOGGER, "Could not open robot description '%s'", path.c_str());
+    return false;
+  }
+  std::stringstream content;
+  content << file.rdbuf();
+  urdf = content.str();
+  return !urdf.empty();
+}
+
+bool waitForTopic(
+  const std::string & topic, std::chrono::milliseconds timeout, std::string & urdf)
+{
+  // a node of its own, the executor of the controller manager is not spinning yet
+  rclcpp::NodeOptions options;
+  options.start_parameter_services(false).start_parameter_event_publisher(false);
+  auto node = std::make_shared<rclcpp::Node>("kortex_robot_description_listener", options);
+  urdf.clear();
+  auto subscription = node->create_subscription<std_msgs::msg::String>(
+    topic, rclcpp::QoS(1).transient_local(),
+    [&urdf](const std_msgs::msg::String::SharedPtr message) { urdf = message->data; });
+
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(node);
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (urdf.empty() && std::chrono::steady_clock::now() < deadline)
+  {
+    executor.spin_some(std::chrono::milliseconds(50));
+  }
+  if (urdf.empty())
+  {
+    RCLCPP_ERROR(
+      LOGGER, "No robot description received on '%s' within %lld ms", topic.c_str(),
+      static_cast<long long>(timeout.count()));  // NOLINT(runtime/int)
+    return false;
+  }
+  return true;
+}
+
+bool load(const hardware_interface::HardwareInfo & info, std::string & urdf)
+{
+  const std::string description_file = getOptionalParameter(info, "robot_description_file", "");
+  if (!description_file.empty())
+  {
+    return readFile(description_file, urdf);
+  }
+  const int timeout =
+    std::stoi(getOptionalParameter(info, "robot_description_timeout_ms", "5000"));
+  return waitForTopic("/robot_description", std::chrono::milliseconds(timeout), urdf);
+}
+
+bool loadModel(
+  const hardware_interface::HardwareInfo & info, const std::vector<std::string> & joint_names,
+  RigidBodyModel & model)
+{
+  std::string urdf;
+  if (!load(info, urdf))
+  {
+    return false;
+  }
+
+  const std::vector<double> gravity =
+    parseDoubles(getOptionalParameter(info, "dynamics_gravity", "0 0 -9.81"));
+  if (gravity.size() != 3)
+  {
+    RCLCPP_ERROR(LOGGER, "dynamics_gravity needs 3 components!");
+    return false;
+  }
+  return model.loadUrdf(urdf, joint_names, Eigen::Vector3d(gravity[0], gravity[1], gravity[2]));
+}
+
+bool loadPositionLimits(
+  const hardware_interface::HardwareInfo & info, const std::vector<std::string> & joint_names,
+  std::vector<double> & lower, std::vector<double> & upper)
+{
+  std::string urdf;
+  if (!load(info, urdf))
+  {
+    return false;
+  }
+  urdf::Model model;
+  if (!model.initString(urdf))
+  {
+    RCLCPP_ERROR(LOGGER, "Could not parse the robot description");
+    return false;
+  }
+  lower.assign(joint_names.size(), -std::numeric_limits<double>::infinity());
+  upper.assign(joint_names.size(), std::numeric_limits<double>::infinity());
+  for (std::size_t i = 0; i < joint_names.size(); i++)
+  {
+    const urdf::JointConstSharedPtr joint = model.getJoint(joint_names[i]);
+    if (!joint)
+    {
+      RCLCPP_ERROR(LOGGER, "Joint '%s' is not in the robot description", joint_names[i].c_str());
+      return false;
+    }
+    if (joint->type != urdf::Joint::CONTINUOUS && joint->limits)
+    {
+      lower[i] = joint->limits->lower;
+      upper[i] = joint->limits->upper;
+    }
+  }
+  return true;
+}
+
+}  // namespace RobotDescription
+
+}  // namespace kortex_driver
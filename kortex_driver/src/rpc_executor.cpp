@@ -0,0 +1,189 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <exception>
+#include <utility>
+
+#include "kortex_driver/rpc_executor.hpp"
+
+#include "rclcpp/rclcpp.hpp"
+
+namespace
+{
+const rclcpp::Logger LOGGER = rclcpp::get_logger("RpcExecutor");
+// upper bound of the wake up delay if a notification is missed
+constexpr auto IDLE_WAIT = std::chrono::milliseconds(10);
+}  // namespace
+
+namespace kortex_driver
+{
+RpcExecutor::RpcExecutor(std::size_t capacity)
+{
+  std::size_t size = 1;
+  while (size < capacity)
+  {
+    size <<= 1;
+  }
+  mask_ = size - 1;
+  cells_.reset(new Cell[size]);
+  for (std::size_t i = 0; i < size; i++)
+  {
+    cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (wake_fd_ < 0)
+  {
+    RCLCPP_WARN(LOGGER, "No eventfd, the executor polls the queue every %ld ms", IDLE_WAIT.count());
+  }
+}
+
+RpcExecutor::~RpcExecutor()
+{
+  stop();
+  if (wake_fd_ >= 0)
+  {
+    ::close(wake_fd_);
+  }
+}
+
+void RpcExecutor::start()
+{
+  if (!running_.exchange(true))
+  {
+    thread_ = std::thread(&RpcExecutor::run, this);
+  }
+}
+
+void RpcExecutor::stop()
+{
+  if (running_.exchange(false))
+  {
+    wake();
+    thread_.join();
+  }
+}
+
+bool RpcExecutor::post(Task task)
+{
+  std::size_t position = enqueue_position_.load(std::memory_order_relaxed);
+  Cell * cell = nullptr;
+  for (;;)
+  {
+    cell = &cells_[position & mask_];
+    const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    const std::intptr_t difference =
+      static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+    if (difference == 0)
+    {
+      if (enqueue_position_.compare_exchange_weak(
+            position, position + 1, std::memory_order_relaxed))
+      {
+        break;
+      }
+    }
+    else if (difference < 0)
+    {
+      rejected_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    else
+    {
+      position = enqueue_position_.load(std::memory_order_relaxed);
+    }
+  }
+
+  cell->task = std::move(task);
+  cell->sequence.store(position + 1, std::memory_order_release);
+  // pairs with the fence in run(), either the executor sees the task or this sees it sleeping
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (sleeping_.load(std::memory_order_relaxed))
+  {
+    wake();
+  }
+  return true;
+}
+
+void RpcExecutor::wake()
+{
+  // a single non-blocking write, the counter of the eventfd cannot realistically overflow
+  const std::uint64_t one = 1;
+  if (wake_fd_ >= 0 && ::write(wake_fd_, &one, sizeof(one)) < 0)
+  {
+    // EAGAIN, the executor has a wake up pending already
+  }
+}
+
+bool RpcExecutor::pop(Task & task)
+{
+  Cell & cell = cells_[dequeue_position_ & mask_];
+  if (cell.sequence.load(std::memory_order_acquire) != dequeue_position_ + 1)
+  {
+    return false;
+  }
+  task = std::move(cell.task);
+  cell.task = nullptr;
+  cell.sequence.store(dequeue_position_ + mask_ + 1, std::memory_order_release);
+  dequeue_position_++;
+  return true;
+}
+
+void RpcExecutor::run()
+{
+  Task task;
+  while (running_)
+  {
+    if (!pop(task))
+    {
+      sleeping_.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (!pop(task))
+      {
+        if (running_)
+        {
+          pollfd wake_poll{wake_fd_, POLLIN, 0};
+          ::poll(&wake_poll, wake_fd_ >= 0 ? 1 : 0, static_cast<int>(IDLE_WAIT.count()));
+          std::uint64_t count = 0;
+          if (wake_fd_ >= 0 && ::read(wake_fd_, &count, sizeof(count)) < 0)
+          {
+            // EAGAIN, woken up by the timeout
+          }
+        }
+        sleeping_.store(false, std::memory_order_relaxed);
+        continue;
+      }
+      sleeping_.store(false, std::memory_order_relaxed);
+    }
+
+    try
+    {
+      task();
+    }
+    catch (std::exception & ex)
+    {
+      RCLCPP_ERROR(LOGGER, "RPC failed: %s", ex.what());
+    }
+    catch (...)
+    {
+      RCLCPP_ERROR(LOGGER, "RPC failed with an unknown exception!");
+    }
+    task = nullptr;
+  }
+}
+
+}  // namespace kortex_driver
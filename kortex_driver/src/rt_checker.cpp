@@ -0,0 +1,269 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Real-time safety checker, meant to be preloaded into a ros2_control process:
+//   KORTEX_RT_CHECKER=abort LD_PRELOAD=libkortex_rt_checker.so ros2 launch ...
+// Allocations, locks, sleeps and file opening done inside a KORTEX_RT_SECTION of the driver
+// are reported on stderr with a backtrace, KORTEX_RT_CHECKER=abort also aborts the process.
+// Nothing in here may allocate, reports are written with write(2).
+
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+extern "C" {
+void * __libc_malloc(size_t size);
+void * __libc_calloc(size_t count, size_t size);
+void * __libc_realloc(void * pointer, size_t size);
+void * __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void * pointer);
+}
+
+namespace
+{
+struct ThreadState
+{
+  const char * section;
+  int depth;
+  int allow;
+  bool reporting;
+};
+
+// initial-exec keeps the access from calling __tls_get_addr, which may allocate
+thread_local ThreadState state __attribute__((tls_model("initial-exec"))) = {
+  nullptr, 0, 0, false};
+
+bool abort_on_violation = false;
+std::atomic<unsigned long> violations{0};  // NOLINT(runtime/int)
+
+bool checking() { return state.depth > 0 && state.allow == 0 && !state.reporting; }
+
+void report(const char * function)
+{
+  state.reporting = true;
+  violations.fetch_add(1, std::memory_order_relaxed);
+  char message[256];
+  const int length = std::snprintf(
+    message, sizeof(message), "[kortex_rt_checker] %s called in %s\n", function, state.section);
+  if (length > 0)
+  {
+    ssize_t ignored = write(STDERR_FILENO, message, static_cast<size_t>(length));
+    (void)ignored;
+  }
+  void * frames[32];
+  const int frame_count = backtrace(frames, 32);
+  // skip report() and the hook
+  backtrace_symbols_fd(frames + 2, frame_count - 2, STDERR_FILENO);
+  if (abort_on_violation)
+  {
+    std::abort();
+  }
+  state.reporting = false;
+}
+
+void check(const char * function)
+{
+  if (checking())
+  {
+    report(function);
+  }
+}
+
+// Next definition of a hooked function, looked up on first use
+template <typename Function>
+Function next(Function & cached, const char * name)
+{
+  if (cached == nullptr)
+  {
+    cached = reinterpret_cast<Function>(dlsym(RTLD_NEXT, name));
+  }
+  return cached;
+}
+
+int (*next_pthread_mutex_lock)(pthread_mutex_t *) = nullptr;
+int (*next_pthread_cond_wait)(pthread_cond_t *, pthread_mutex_t *) = nullptr;
+int (*next_nanosleep)(const timespec *, timespec *) = nullptr;
+int (*next_clock_nanosleep)(clockid_t, int, const timespec *, timespec *) = nullptr;
+int (*next_usleep)(useconds_t) = nullptr;
+int (*next_open)(const char *, int, ...) = nullptr;
+int (*next_openat)(int, const char *, int, ...) = nullptr;
+FILE * (*next_fopen)(const char *, const char *) = nullptr;
+
+__attribute__((constructor)) void initialize()
+{
+  const char * mode = std::getenv("KORTEX_RT_CHECKER");
+  abort_on_violation = mode != nullptr && std::strcmp(mode, "abort") == 0;
+  // backtrace() loads libgcc_s and allocates the first time it is called
+  void * frame;
+  backtrace(&frame, 1);
+}
+
+__attribute__((destructor)) void finish()
+{
+  char message[128];
+  const int length = std::snprintf(
+    message, sizeof(message), "[kortex_rt_checker] %lu violations\n",
+    violations.load(std::memory_order_relaxed));
+  if (length > 0)
+  {
+    ssize_t ignored = write(STDERR_FILENO, message, static_cast<size_t>(length));
+    (void)ignored;
+  }
+}
+}  // namespace
+
+extern "C" {
+void kortex_rt_checker_enter(const char * section)
+{
+  if (state.depth++ == 0)
+  {
+    state.section = section;
+  }
+}
+
+void kortex_rt_checker_leave()
+{
+  if (state.depth > 0)
+  {
+    state.depth--;
+  }
+}
+
+void kortex_rt_checker_allow(int allow) { state.allow += allow ? 1 : -1; }
+
+void * malloc(size_t size)
+{
+  check("malloc");
+  return __libc_malloc(size);
+}
+
+void * calloc(size_t count, size_t size)
+{
+  check("calloc");
+  return __libc_calloc(count, size);
+}
+
+void * realloc(void * pointer, size_t size)
+{
+  check("realloc");
+  return __libc_realloc(pointer, size);
+}
+
+void free(void * pointer)
+{
+  if (pointer != nullptr)
+  {
+    check("free");
+  }
+  __libc_free(pointer);
+}
+
+void * memalign(size_t alignment, size_t size)
+{
+  check("memalign");
+  return __libc_memalign(alignment, size);
+}
+
+void * aligned_alloc(size_t alignment, size_t size)
+{
+  check("aligned_alloc");
+  return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void ** pointer, size_t alignment, size_t size)
+{
+  check("posix_memalign");
+  void * result = __libc_memalign(alignment, size);
+  if (result == nullptr)
+  {
+    return ENOMEM;
+  }
+  *pointer = result;
+  return 0;
+}
+
+int pthread_mutex_lock(pthread_mutex_t * mutex)
+{
+  check("pthread_mutex_lock");
+  return next(next_pthread_mutex_lock, "pthread_mutex_lock")(mutex);
+}
+
+int pthread_cond_wait(pthread_cond_t * condition, pthread_mutex_t * mutex)
+{
+  check("pthread_cond_wait");
+  return next(next_pthread_cond_wait, "pthread_cond_wait")(condition, mutex);
+}
+
+int nanosleep(const timespec * request, timespec * remaining)
+{
+  check("nanosleep");
+  return next(next_nanosleep, "nanosleep")(request, remaining);
+}
+
+int clock_nanosleep(clockid_t clock, int flags, const timespec * request, timespec * remaining)
+{
+  check("clock_nanosleep");
+  return next(next_clock_nanosleep, "clock_nanosleep")(clock, flags, request, remaining);
+}
+
+int usleep(useconds_t duration)
+{
+  check("usleep");
+  return next(next_usleep, "usleep")(duration);
+}
+
+int open(const char * path, int flags, ...)
+{
+  check("open");
+  mode_t mode = 0;
+  if (flags & (O_CREAT | O_TMPFILE))
+  {
+    va_list arguments;
+    va_start(arguments, flags);
+    mode = static_cast<mode_t>(va_arg(arguments, int));
+    va_end(arguments);
+  }
+  return next(next_open, "open")(path, flags, mode);
+}
+
+int openat(int directory, const char * path, int flags, ...)
+{
+  check("openat");
+  mode_t mode = 0;
+  if (flags & (O_CREAT | O_TMPFILE))
+  {
+    va_list arguments;
+    va_start(arguments, flags);
+    mode = static_cast<mode_t>(va_arg(arguments, int));
+    va_end(arguments);
+  }
+  return next(next_openat, "openat")(directory, path, flags, mode);
+}
+
+FILE * fopen(const char * path, const char * mode)
+{
+  check("fopen");
+  return next(next_fopen, "fopen")(path, mode);
+}
+}
@@ -0,0 +1,91 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <alloca.h>
+#include <malloc.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <memory>
+
+#include "kortex_driver/rt_memory.hpp"
+
+#include "rclcpp/rclcpp.hpp"
+
+namespace
+{
+const rclcpp::Logger LOGGER = rclcpp::get_logger("RtMemory");
+
+std::size_t pageSize()
+{
+  const long page_size = sysconf(_SC_PAGESIZE);  // NOLINT(runtime/int)
+  return page_size > 0 ? static_cast<std::size_t>(page_size) : 4096;
+}
+
+// Kept out of line so the compiler can't drop the array of the caller
+__attribute__((noinline)) void touchStack(volatile char * data, std::size_t size)
+{
+  const std::size_t page_size = pageSize();
+  for (std::size_t i = 0; i < size; i += page_size)
+  {
+    data[i] = 0;
+  }
+}
+}  // namespace
+
+namespace kortex_driver
+{
+namespace RtMemory
+{
+bool lockMemory()
+{
+  if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+  {
+    RCLCPP_WARN(LOGGER, "Could not lock memory: %s", std::strerror(errno));
+    return false;
+  }
+  // no trimming of the top of the heap and no separate mappings for large blocks, both would
+  // hand pages back to the kernel and fault them in again on the next allocation
+  mallopt(M_TRIM_THRESHOLD, -1);
+  mallopt(M_MMAP_MAX, 0);
+  return true;
+}
+
+void prefaultHeap(std::size_t size)
+{
+  if (size == 0)
+  {
+    return;
+  }
+  std::unique_ptr<char[]> block(new char[size]);
+  const std::size_t page_size = pageSize();
+  volatile char * data = block.get();
+  for (std::size_t i = 0; i < size; i += page_size)
+  {
+    data[i] = 0;
+  }
+}
+
+void prefaultStack(std::size_t size)
+{
+  // variable length arrays are not standard, alloca keeps the size a runtime parameter
+  volatile char * data = static_cast<volatile char *>(alloca(size));
+  touchStack(data, size);
+}
+
+}  // namespace RtMemory
+
+}  // namespace kortex_driver
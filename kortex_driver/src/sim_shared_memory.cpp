@@ -0,0 +1,168 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#include "kortex_driver/sim_shared_memory.hpp"
+
+#include "rclcpp/rclcpp.hpp"
+
+namespace
+{
+const rclcpp::Logger LOGGER = rclcpp::get_logger("SimSharedMemory");
+// attempts of a reader before it gives up on a frame the writer keeps replacing
+constexpr int READ_ATTEMPTS = 4;
+}  // namespace
+
+namespace kortex_driver
+{
+SimSharedMemory::~SimSharedMemory() { close(); }
+
+bool SimSharedMemory::open(const std::string & name, std::size_t joint_count)
+{
+  close();
+  if (joint_count > SIM_MAX_JOINTS)
+  {
+    RCLCPP_ERROR(
+      LOGGER, "%zu joints do not fit in shared memory, at most %zu", joint_count, SIM_MAX_JOINTS);
+    return false;
+  }
+
+  // the creator initializes the segment, everyone else checks it
+  bool created = true;
+  int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0 && errno == EEXIST)
+  {
+    created = false;
+    fd = shm_open(name.c_str(), O_RDWR, 0600);
+  }
+  if (fd < 0)
+  {
+    RCLCPP_ERROR(LOGGER, "Could not open shared memory %s: %s", name.c_str(), std::strerror(errno));
+    return false;
+  }
+
+  struct stat status;
+  if (created && ftruncate(fd, sizeof(SimSharedMemoryLayout)) != 0)
+  {
+    RCLCPP_ERROR(LOGGER, "Could not size shared memory %s: %s", name.c_str(), std::strerror(errno));
+    ::close(fd);
+    shm_unlink(name.c_str());
+    return false;
+  }
+  if (
+    !created &&
+    (fstat(fd, &status) != 0 ||
+     static_cast<std::size_t>(status.st_size) < sizeof(SimSharedMemoryLayout)))
+  {
+    RCLCPP_ERROR(LOGGER, "Shared memory %s is too small, it is not set up yet", name.c_str());
+    ::close(fd);
+    return false;
+  }
+
+  void * address =
+    mmap(nullptr, sizeof(SimSharedMemoryLayout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  // the mapping stays valid without the descriptor
+  ::close(fd);
+  if (address == MAP_FAILED)
+  {
+    RCLCPP_ERROR(LOGGER, "Could not map shared memory %s: %s", name.c_str(), std::strerror(errno));
+    return false;
+  }
+  SimSharedMemoryLayout * layout = static_cast<SimSharedMemoryLayout *>(address);
+
+  if (created)
+  {
+    // ftruncate zero filled the segment, which is a valid initial state for the slots
+    new (&layout->command.sequence) std::atomic<std::uint32_t>(0);
+    new (&layout->state.sequence) std::atomic<std::uint32_t>(0);
+    layout->version = SIM_SHARED_MEMORY_VERSION;
+    layout->joint_count = static_cast<std::uint32_t>(joint_count);
+    // published last, a peer seeing the magic sees the rest of the header too
+    std::atomic_thread_fence(std::memory_order_release);
+    layout->magic = SIM_SHARED_MEMORY_MAGIC;
+  }
+  else
+  {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (
+      layout->magic != SIM_SHARED_MEMORY_MAGIC || layout->version != SIM_SHARED_MEMORY_VERSION ||
+      layout->joint_count != joint_count)
+    {
+      RCLCPP_ERROR(
+        LOGGER, "Shared memory %s has version %u and %u joints, expected version %u and %zu joints",
+        name.c_str(), layout->version, layout->joint_count, SIM_SHARED_MEMORY_VERSION, joint_count);
+      munmap(address, sizeof(SimSharedMemoryLayout));
+      return false;
+    }
+  }
+
+  layout_ = layout;
+  RCLCPP_INFO(
+    LOGGER, "%s shared memory %s for %zu joints", created ? "Created" : "Attached to", name.c_str(),
+    joint_count);
+  return true;
+}
+
+void SimSharedMemory::close()
+{
+  // the segment itself is left in place, the simulator may still have it mapped
+  if (layout_ != nullptr)
+  {
+    munmap(layout_, sizeof(SimSharedMemoryLayout));
+    layout_ = nullptr;
+  }
+}
+
+void SimSharedMemory::write(SimFrameSlot & slot, const SimFrame & frame)
+{
+  const std::uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+  slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(&slot.frame, &frame, sizeof(SimFrame));
+  slot.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool SimSharedMemory::read(const SimFrameSlot & slot, SimFrame & frame, std::uint32_t & sequence)
+{
+  for (int attempt = 0; attempt < READ_ATTEMPTS; attempt++)
+  {
+    const std::uint32_t before = slot.sequence.load(std::memory_order_acquire);
+    if (before == 0)
+    {
+      return false;
+    }
+    if (before & 1u)
+    {
+      continue;
+    }
+    std::memcpy(&frame, &slot.frame, sizeof(SimFrame));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) == before)
+    {
+      sequence = before;
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace kortex_driver
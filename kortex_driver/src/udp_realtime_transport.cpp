@@ -0,0 +1,241 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <arpa/inet.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include "kortex_driver/udp_realtime_transport.hpp"
+
+#include "rclcpp/rclcpp.hpp"
+
+namespace
+{
+const rclcpp::Logger LOGGER = rclcpp::get_logger("UdpRealtimeTransport");
+
+std::int64_t toNanoseconds(const timespec & ts)
+{
+  return static_cast<std::int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+}  // namespace
+
+namespace kortex_driver
+{
+UdpRealtimeTransport::UdpRealtimeTransport(const UdpTransportOptions & options)
+: options_(options), tx_buffer_(MAX_FRAME_SIZE)
+{
+  options_.receive_batch = std::max<std::size_t>(options_.receive_batch, 1);
+
+  // every receive buffer is allocated once, recvmmsg() fills them in place
+  rx_buffers_.resize(options_.receive_batch * MAX_FRAME_SIZE);
+  rx_control_.resize(options_.receive_batch * CONTROL_SIZE);
+  rx_iovecs_.resize(options_.receive_batch);
+  rx_headers_.resize(options_.receive_batch);
+  for (std::size_t i = 0; i < options_.receive_batch; i++)
+  {
+    rx_iovecs_[i].iov_base = &rx_buffers_[i * MAX_FRAME_SIZE];
+    rx_iovecs_[i].iov_len = MAX_FRAME_SIZE;
+    std::memset(&rx_headers_[i], 0, sizeof(mmsghdr));
+    rx_headers_[i].msg_hdr.msg_iov = &rx_iovecs_[i];
+    rx_headers_[i].msg_hdr.msg_iovlen = 1;
+  }
+}
+
+UdpRealtimeTransport::~UdpRealtimeTransport() { disconnect(); }
+
+bool UdpRealtimeTransport::connect(std::string host, uint32_t port)
+{
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(static_cast<uint16_t>(port));
+  if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1)
+  {
+    RCLCPP_ERROR(LOGGER, "Invalid robot address '%s'", host.c_str());
+    return false;
+  }
+
+  socket_ = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  if (socket_ < 0)
+  {
+    RCLCPP_ERROR(LOGGER, "Could not create socket: %s", std::strerror(errno));
+    return false;
+  }
+  configureSocket();
+
+  // a connected socket only receives datagrams of the robot and sends without an address
+  if (::connect(socket_, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+  {
+    RCLCPP_ERROR(
+      LOGGER, "Could not connect to %s:%u: %s", host.c_str(), port, std::strerror(errno));
+    ::close(socket_);
+    socket_ = -1;
+    return false;
+  }
+
+  running_ = true;
+  receive_thread_ = std::thread(&UdpRealtimeTransport::receiveLoop, this);
+  return true;
+}
+
+void UdpRealtimeTransport::disconnect()
+{
+  running_ = false;
+  if (receive_thread_.joinable())
+  {
+    receive_thread_.join();
+  }
+  if (socket_ >= 0)
+  {
+    ::close(socket_);
+    socket_ = -1;
+  }
+}
+
+void UdpRealtimeTransport::send(const char * tx_buffer, uint32_t tx_size)
+{
+  if (::send(socket_, tx_buffer, tx_size, 0) < 0)
+  {
+    last_send_error_.store(errno, std::memory_order_relaxed);
+    send_failures_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void UdpRealtimeTransport::onMessage(std::function<void(const char *, uint32_t)> callback)
+{
+  callback_ = std::move(callback);
+}
+
+char * UdpRealtimeTransport::getTxBuffer() { return tx_buffer_.data(); }
+
+size_t UdpRealtimeTransport::getMaxTxBufferSize() { return tx_buffer_.size(); }
+
+void UdpRealtimeTransport::configureSocket()
+{
+  // failing options are reported but do not prevent the connection
+  if (options_.busy_poll_us > 0)
+  {
+    if (
+      setsockopt(
+        socket_, SOL_SOCKET, SO_BUSY_POLL, &options_.busy_poll_us,
+        sizeof(options_.busy_poll_us)) != 0)
+    {
+      RCLCPP_WARN(LOGGER, "Could not set SO_BUSY_POLL: %s", std::strerror(errno));
+    }
+  }
+  if (options_.socket_priority >= 0)
+  {
+    if (
+      setsockopt(
+        socket_, SOL_SOCKET, SO_PRIORITY, &options_.socket_priority,
+        sizeof(options_.socket_priority)) != 0)
+    {
+      RCLCPP_WARN(LOGGER, "Could not set SO_PRIORITY: %s", std::strerror(errno));
+    }
+  }
+  if (options_.dscp >= 0)
+  {
+    // DSCP occupies the upper six bits of the TOS byte
+    int tos = (options_.dscp & 0x3f) << 2;
+    if (setsockopt(socket_, IPPROTO_IP, IP_TOS, &tos, sizeof(tos)) != 0)
+    {
+      RCLCPP_WARN(LOGGER, "Could not set IP_TOS: %s", std::strerror(errno));
+    }
+  }
+  if (options_.timestamping)
+  {
+    int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+    if (setsockopt(socket_, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) != 0)
+    {
+      RCLCPP_WARN(LOGGER, "Could not set SO_TIMESTAMPING: %s", std::strerror(errno));
+      options_.timestamping = false;
+    }
+  }
+}
+
+void UdpRealtimeTransport::receiveLoop()
+{
+  pollfd poll_fd{socket_, POLLIN, 0};
+  while (running_)
+  {
+    if (!options_.spin_wait)
+    {
+      int ready = ::poll(&poll_fd, 1, POLL_TIMEOUT_MS);
+      if (ready <= 0)
+      {
+        continue;
+      }
+    }
+
+    for (std::size_t i = 0; i < options_.receive_batch; i++)
+    {
+      rx_headers_[i].msg_hdr.msg_control =
+        options_.timestamping ? &rx_control_[i * CONTROL_SIZE] : nullptr;
+      rx_headers_[i].msg_hdr.msg_controllen = options_.timestamping ? CONTROL_SIZE : 0;
+    }
+
+    int received = ::recvmmsg(
+      socket_, rx_headers_.data(), static_cast<unsigned int>(options_.receive_batch),
+      MSG_DONTWAIT, nullptr);
+    if (received <= 0)
+    {
+      continue;
+    }
+
+    for (int i = 0; i < received; i++)
+    {
+      last_rx_timestamp_ns_.store(
+        receiveTimestamp(rx_headers_[i].msg_hdr), std::memory_order_relaxed);
+      if (callback_)
+      {
+        callback_(static_cast<const char *>(rx_iovecs_[i].iov_base), rx_headers_[i].msg_len);
+      }
+    }
+  }
+}
+
+std::int64_t UdpRealtimeTransport::receiveTimestamp(const msghdr & header) const
+{
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  if (options_.timestamping)
+  {
+    for (cmsghdr * cmsg = CMSG_FIRSTHDR(&header); cmsg != nullptr;
+         cmsg = CMSG_NXTHDR(const_cast<msghdr *>(&header), cmsg))
+    {
+      if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING)
+      {
+        scm_timestamping timestamps;
+        std::memcpy(&timestamps, CMSG_DATA(cmsg), sizeof(timestamps));
+        // software timestamps are on CLOCK_REALTIME, moved to CLOCK_MONOTONIC by the time the
+        // frame spent in the socket
+        timespec realtime_now;
+        clock_gettime(CLOCK_REALTIME, &realtime_now);
+        return toNanoseconds(now) - (toNanoseconds(realtime_now) - toNanoseconds(timestamps.ts[0]));
+      }
+    }
+  }
+  return toNanoseconds(now);
+}
+
+}  // namespace kortex_driver
@@ -0,0 +1,236 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "kortex_driver/collision_detector.hpp"
+#include "kortex_driver/rigid_body_model.hpp"
+
+namespace kortex_driver
+{
+namespace
+{
+using JointVector = RigidBodyModel::JointVector;
+
+constexpr int JOINTS = 3;
+constexpr double GAIN = 50.0;
+constexpr double DT = 0.001;
+
+// Shoulder, elbow and wrist of a small arm, the shoulder turning about the vertical
+RigidBodyModel makeModel()
+{
+  std::vector<RigidBodyModel::Body> bodies(JOINTS);
+  bodies[0].translation = Eigen::Vector3d(0.0, 0.0, 0.1);
+  bodies[0].mass = 1.5;
+  bodies[0].center_of_mass = Eigen::Vector3d(0.0, 0.0, 0.05);
+  bodies[0].inertia = Eigen::Vector3d(0.004, 0.004, 0.002).asDiagonal();
+  for (int i = 1; i < JOINTS; i++)
+  {
+    bodies[i].rotation = Eigen::AngleAxisd(M_PI / 2, Eigen::Vector3d::UnitX()).toRotationMatrix();
+    bodies[i].translation = Eigen::Vector3d(i == 1 ? 0.0 : 0.3, 0.0, i == 1 ? 0.05 : 0.0);
+    bodies[i].mass = 1.0;
+    bodies[i].center_of_mass = Eigen::Vector3d(0.15, 0.0, 0.0);
+    bodies[i].inertia = Eigen::Vector3d(0.001, 0.008, 0.008).asDiagonal();
+  }
+  RigidBodyModel model;
+  model.setBodies(bodies, Eigen::Vector3d(0.0, 0.0, -9.81));
+  return model;
+}
+
+std::vector<double> toVector(const JointVector & joints)
+{
+  return std::vector<double>(joints.data(), joints.data() + joints.size());
+}
+
+// Measured efforts of the arm held at q against the external torques, or the static torques
+// that gravity does not leave to the arm
+std::vector<double> heldEfforts(
+  RigidBodyModel & model, const JointVector & q, const JointVector & external_torques)
+{
+  JointVector gravity(JOINTS);
+  model.gravityTorques(q, gravity);
+  return toVector(gravity - external_torques);
+}
+}  // namespace
+
+TEST(CollisionDetector, ResidualConvergesAtTheGainBandwidth)
+{
+  RigidBodyModel model = makeModel();
+  CollisionDetector detector;
+  detector.configure(JOINTS, GAIN, {100.0}, 2);
+
+  JointVector q(JOINTS);
+  q << 0.3, -0.8, 1.2;
+  JointVector external_torques(JOINTS);
+  external_torques << 2.0, -1.5, 0.5;
+  const std::vector<double> positions = toVector(q);
+  const std::vector<double> velocities(JOINTS, 0.0);
+  const std::vector<double> efforts = heldEfforts(model, q, external_torques);
+
+  // the first update only starts the observer
+  detector.update(model, positions, velocities, efforts, DT);
+  for (int i = 0; i < JOINTS; i++)
+  {
+    EXPECT_EQ(detector.externalTorques()[i], 0.0);
+  }
+
+  // first order response, at 1 - 1/e of the step after one time constant
+  const int time_constant_cycles = static_cast<int>(std::round(1.0 / (GAIN * DT)));
+  for (int cycle = 1; cycle <= time_constant_cycles; cycle++)
+  {
+    detector.update(model, positions, velocities, efforts, DT);
+  }
+  for (int i = 0; i < JOINTS; i++)
+  {
+    EXPECT_NEAR(
+      detector.externalTorques()[i], (1.0 - std::exp(-1.0)) * external_torques[i],
+      0.02 * std::abs(external_torques[i]))
+      << "joint " << i;
+  }
+
+  for (int cycle = 0; cycle < 20 * time_constant_cycles; cycle++)
+  {
+    detector.update(model, positions, velocities, efforts, DT);
+  }
+  for (int i = 0; i < JOINTS; i++)
+  {
+    EXPECT_NEAR(detector.externalTorques()[i], external_torques[i], 1e-6) << "joint " << i;
+  }
+  EXPECT_FALSE(detector.inContact());
+}
+
+TEST(CollisionDetector, ResidualFollowsTheExternalTorquesInMotion)
+{
+  RigidBodyModel model = makeModel();
+  CollisionDetector detector;
+  detector.configure(JOINTS, GAIN, {100.0}, 2);
+
+  JointVector external_torques(JOINTS);
+  external_torques << -1.0, 2.0, 0.8;
+  JointVector q(JOINTS);
+  JointVector qd(JOINTS);
+  JointVector qdd(JOINTS);
+  JointVector tau(JOINTS);
+  for (int cycle = 0; cycle < 1000; cycle++)
+  {
+    const double t = cycle * DT;
+    for (int i = 0; i < JOINTS; i++)
+    {
+      const double frequency = 2.0 + i;
+      q[i] = std::sin(frequency * t) + 0.2 * i;
+      qd[i] = frequency * std::cos(frequency * t);
+      qdd[i] = -frequency * frequency * std::sin(frequency * t);
+    }
+    model.inverseDynamics(q, qd, qdd, true, tau);
+    detector.update(model, toVector(q), toVector(qd), toVector(tau - external_torques), DT);
+    // once the start has settled, any error in the Coriolis terms shows in the residual
+    if (cycle < 10 / (GAIN * DT))
+    {
+      continue;
+    }
+    for (int i = 0; i < JOINTS; i++)
+    {
+      ASSERT_NEAR(detector.externalTorques()[i], external_torques[i], 0.02)
+        << "joint " << i << ", cycle " << cycle;
+    }
+  }
+}
+
+TEST(CollisionDetector, ContactLatchesAfterTheConfirmationCycles)
+{
+  RigidBodyModel model = makeModel();
+  const int confirmation_cycles = 3;
+  const double threshold = 1.0;
+  CollisionDetector detector;
+  detector.configure(JOINTS, GAIN, {threshold}, confirmation_cycles);
+
+  JointVector q(JOINTS);
+  q << 0.3, -0.8, 1.2;
+  const std::vector<double> positions = toVector(q);
+  const std::vector<double> velocities(JOINTS, 0.0);
+  JointVector external_torques = JointVector::Zero(JOINTS);
+  external_torques[1] = 2.0;
+  const std::vector<double> contact_efforts = heldEfforts(model, q, external_torques);
+  const std::vector<double> free_efforts = heldEfforts(model, q, JointVector::Zero(JOINTS));
+
+  detector.update(model, positions, velocities, contact_efforts, DT);
+  int cycles_above_threshold = 0;
+  for (int cycle = 0; cycle < 200; cycle++)
+  {
+    detector.update(model, positions, velocities, contact_efforts, DT);
+    if (std::abs(detector.externalTorques()[1]) > threshold)
+    {
+      cycles_above_threshold++;
+    }
+    EXPECT_EQ(detector.inContact(), cycles_above_threshold >= confirmation_cycles)
+      << "cycle " << cycle;
+  }
+  ASSERT_TRUE(detector.inContact());
+  EXPECT_EQ(detector.contact(), 1.0);
+
+  // stays reported once the arm is released
+  for (int cycle = 0; cycle < 200; cycle++)
+  {
+    detector.update(model, positions, velocities, free_efforts, DT);
+  }
+  EXPECT_LT(std::abs(detector.externalTorques()[1]), threshold);
+  EXPECT_TRUE(detector.inContact());
+
+  detector.clearContact();
+  EXPECT_FALSE(detector.inContact());
+  EXPECT_EQ(detector.contact(), 0.0);
+  for (int cycle = 0; cycle < 10; cycle++)
+  {
+    detector.update(model, positions, velocities, free_efforts, DT);
+    EXPECT_FALSE(detector.inContact());
+  }
+}
+
+TEST(CollisionDetector, ClearedContactNeedsNewConfirmation)
+{
+  RigidBodyModel model = makeModel();
+  const int confirmation_cycles = 3;
+  CollisionDetector detector;
+  detector.configure(JOINTS, GAIN, {1.0}, confirmation_cycles);
+
+  JointVector q(JOINTS);
+  q << 0.3, -0.8, 1.2;
+  const std::vector<double> positions = toVector(q);
+  const std::vector<double> velocities(JOINTS, 0.0);
+  JointVector external_torques = JointVector::Zero(JOINTS);
+  external_torques[0] = 5.0;
+  const std::vector<double> efforts = heldEfforts(model, q, external_torques);
+
+  detector.update(model, positions, velocities, efforts, DT);
+  for (int cycle = 0; cycle < 100; cycle++)
+  {
+    detector.update(model, positions, velocities, efforts, DT);
+  }
+  ASSERT_TRUE(detector.inContact());
+
+  // still pushed, reported again only after as many cycles above the threshold
+  detector.clearContact();
+  for (int cycle = 1; cycle < confirmation_cycles; cycle++)
+  {
+    detector.update(model, positions, velocities, efforts, DT);
+    EXPECT_FALSE(detector.inContact()) << "cycle " << cycle;
+  }
+  detector.update(model, positions, velocities, efforts, DT);
+  EXPECT_TRUE(detector.inContact());
+}
+
+}  // namespace kortex_driver
@@ -0,0 +1,305 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "kortex_driver/cyclic_frame_codec.hpp"
+#include "kortex_driver/feedback_snapshot.hpp"
+
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/unknown_field_set.h"
+
+namespace kortex_driver
+{
+namespace
+{
+using google::protobuf::FieldDescriptor;
+using google::protobuf::Message;
+
+// BaseCyclic::Command as on_activate() lays it out
+k_api::BaseCyclic::Command makeCommand(std::size_t actuator_count)
+{
+  k_api::BaseCyclic::Command command;
+  for (std::size_t i = 0; i < actuator_count; i++)
+  {
+    command.add_actuators();
+  }
+  command.mutable_interconnect()->mutable_command_id()->set_identifier(0);
+  command.mutable_interconnect()->mutable_gripper_command()->add_motor_cmd();
+  return command;
+}
+
+k_api::BaseCyclic::Feedback makeFeedback(std::size_t actuator_count)
+{
+  k_api::BaseCyclic::Feedback feedback;
+  feedback.set_frame_id(17);
+  feedback.mutable_base()->set_active_state(k_api::Common::ARMSTATE_SERVOING_LOW_LEVEL);
+  feedback.mutable_base()->set_fault_bank_a(1);
+  feedback.mutable_base()->set_fault_bank_b(2);
+  feedback.mutable_base()->set_tool_pose_x(0.3f);
+  for (std::size_t i = 0; i < actuator_count; i++)
+  {
+    k_api::BaseCyclic::ActuatorFeedback * actuator = feedback.add_actuators();
+    // degrees in [0, 360), some of them wrap to negative radians
+    actuator->set_position(50.5f * static_cast<float>(i) + 10.25f);
+    actuator->set_velocity(-3.0f * static_cast<float>(i));
+    actuator->set_torque(1.5f + static_cast<float>(i));
+    actuator->set_fault_bank_a(static_cast<std::uint32_t>(i % 2));
+    actuator->set_fault_bank_b(static_cast<std::uint32_t>(i % 3));
+    actuator->set_current_motor(0.25f);
+  }
+  k_api::GripperCyclic::Feedback * gripper =
+    feedback.mutable_interconnect()->mutable_gripper_feedback();
+  gripper->add_motor()->set_position(42.5f);
+  gripper->add_motor()->set_position(99.0f);
+  return feedback;
+}
+
+void appendVarint(std::string & out, std::uint64_t value)
+{
+  while (value >= 0x80)
+  {
+    out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+std::string lengthDelimited(int number, const std::string & content)
+{
+  std::string out;
+  appendVarint(out, (static_cast<std::uint64_t>(number) << 3) | 2);
+  appendVarint(out, content.size());
+  return out + content;
+}
+
+int fieldNumber(const Message & message, const char * name)
+{
+  return message.GetDescriptor()->FindFieldByName(name)->number();
+}
+
+// The fields of message serialized one by one, the highest field number first
+std::string reversedFields(const Message & message)
+{
+  std::vector<const FieldDescriptor *> fields;
+  message.GetReflection()->ListFields(message, &fields);
+  std::string out;
+  for (auto field = fields.rbegin(); field != fields.rend(); ++field)
+  {
+    std::unique_ptr<Message> single(message.New());
+    single->CopyFrom(message);
+    for (const FieldDescriptor * other : fields)
+    {
+      if (other != *field)
+      {
+        single->GetReflection()->ClearField(single.get(), other);
+      }
+    }
+    out += single->SerializeAsString();
+  }
+  return out;
+}
+
+// Fields a newer firmware could add, of every wire type
+void addUnknownFields(Message & message)
+{
+  google::protobuf::UnknownFieldSet * unknown =
+    message.GetReflection()->MutableUnknownFields(&message);
+  unknown->AddVarint(1000, 300);
+  unknown->AddFixed32(1001, 0xdeadbeef);
+  unknown->AddFixed64(1002, 0x0123456789abcdefULL);
+  unknown->AddLengthDelimited(1003, std::string("\x08\x01\x15\x00\x00\x80\x3f", 7));
+}
+
+// The decoder against FeedbackSnapshot::decode() of the parsed payload
+void expectSameSnapshot(const std::string & payload, std::size_t actuator_count, bool with_gripper)
+{
+  k_api::BaseCyclic::Feedback parsed;
+  ASSERT_TRUE(parsed.ParseFromString(payload));
+  FeedbackSnapshot expected;
+  expected.resize(actuator_count);
+  expected.decode(parsed, with_gripper);
+
+  CyclicFeedbackDecoder decoder;
+  ASSERT_TRUE(decoder.configure(actuator_count));
+  FeedbackSnapshot decoded;
+  decoded.resize(actuator_count);
+  ASSERT_TRUE(decoder.decode(payload, decoded, with_gripper));
+
+  EXPECT_EQ(decoded.positions, expected.positions);
+  EXPECT_EQ(decoded.velocities, expected.velocities);
+  EXPECT_EQ(decoded.efforts, expected.efforts);
+  EXPECT_EQ(decoded.faults, expected.faults);
+  EXPECT_EQ(decoded.base_faults, expected.base_faults);
+  EXPECT_EQ(decoded.active_state, expected.active_state);
+  if (with_gripper)
+  {
+    EXPECT_EQ(decoded.gripper_position, expected.gripper_position);
+  }
+}
+
+class CyclicFrameCodecTest : public ::testing::TestWithParam<std::size_t>
+{
+};
+}  // namespace
+
+TEST_P(CyclicFrameCodecTest, EncoderMatchesTheKortexSerialization)
+{
+  const std::size_t count = GetParam();
+  k_api::BaseCyclic::Command command = makeCommand(count);
+  CyclicCommandEncoder encoder;
+  ASSERT_TRUE(encoder.layout(count));
+  const char * payload = encoder.payload().data();
+
+  // zeros, which proto3 leaves out, as well as the largest values of every field
+  const std::vector<std::uint32_t> frame_ids = {0, 1, 300, 0xffff, 0xffffffff};
+  for (const std::uint32_t frame_id : frame_ids)
+  {
+    command.set_frame_id(frame_id);
+    encoder.setFrameId(frame_id);
+    for (std::size_t i = 0; i < count; i++)
+    {
+      const float position = frame_id == 0 ? 0.0f : 359.75f - 17.5f * static_cast<float>(i);
+      command.mutable_actuators(static_cast<int>(i))->set_position(position);
+      command.mutable_actuators(static_cast<int>(i))->set_command_id(frame_id);
+      encoder.setActuator(i, position, frame_id);
+    }
+    const float gripper = frame_id == 0 ? 0.0f : 12.5f;
+    k_api::GripperCyclic::MotorCommand * motor =
+      command.mutable_interconnect()->mutable_gripper_command()->mutable_motor_cmd(0);
+    motor->set_position(gripper);
+    motor->set_velocity(2.0f * gripper);
+    motor->set_force(100.0f);
+    encoder.setGripper(gripper, 2.0f * gripper, 100.0f);
+
+    k_api::BaseCyclic::Command parsed;
+    ASSERT_TRUE(parsed.ParseFromString(encoder.payload())) << "frame id " << frame_id;
+    EXPECT_EQ(parsed.SerializeAsString(), command.SerializeAsString()) << "frame id " << frame_id;
+    EXPECT_TRUE(encoder.encodes(command)) << "frame id " << frame_id;
+  }
+  // patched in place, the buffer handed to the router never moves
+  EXPECT_EQ(encoder.payload().data(), payload);
+}
+
+TEST_P(CyclicFrameCodecTest, EncoderDetectsAnotherCommand)
+{
+  const std::size_t count = GetParam();
+  CyclicCommandEncoder encoder;
+  ASSERT_TRUE(encoder.layout(count));
+  encoder.setActuator(0, 10.0f, 1);
+  k_api::BaseCyclic::Command command = makeCommand(count);
+  command.mutable_actuators(0)->set_position(10.0f);
+  command.mutable_actuators(0)->set_command_id(2);
+  EXPECT_FALSE(encoder.encodes(command));
+}
+
+TEST_P(CyclicFrameCodecTest, DecoderMatchesTheParsedFeedback)
+{
+  const std::size_t count = GetParam();
+  const std::string payload = makeFeedback(count).SerializeAsString();
+  expectSameSnapshot(payload, count, true);
+  expectSameSnapshot(payload, count, false);
+}
+
+TEST_P(CyclicFrameCodecTest, DecoderSkipsUnknownFields)
+{
+  const std::size_t count = GetParam();
+  k_api::BaseCyclic::Feedback feedback = makeFeedback(count);
+  addUnknownFields(feedback);
+  addUnknownFields(*feedback.mutable_base());
+  for (int i = 0; i < feedback.actuators_size(); i++)
+  {
+    addUnknownFields(*feedback.mutable_actuators(i));
+  }
+  addUnknownFields(*feedback.mutable_interconnect());
+  addUnknownFields(*feedback.mutable_interconnect()->mutable_gripper_feedback());
+  addUnknownFields(*feedback.mutable_interconnect()->mutable_gripper_feedback()->mutable_motor(0));
+  const std::string payload = feedback.SerializeAsString();
+  expectSameSnapshot(payload, count, true);
+  expectSameSnapshot(payload, count, false);
+}
+
+TEST_P(CyclicFrameCodecTest, DecoderAcceptsFieldsInAnyOrder)
+{
+  const std::size_t count = GetParam();
+  const k_api::BaseCyclic::Feedback feedback = makeFeedback(count);
+  const int actuators = fieldNumber(feedback, "actuators");
+  const int base = fieldNumber(feedback, "base");
+  const int interconnect = fieldNumber(feedback, "interconnect");
+
+  // the base and the interconnect between two actuators, every message with its fields reversed
+  std::string payload;
+  for (int i = 0; i < feedback.actuators_size(); i++)
+  {
+    if (i == 2)
+    {
+      payload += lengthDelimited(interconnect, reversedFields(feedback.interconnect()));
+      payload += lengthDelimited(base, reversedFields(feedback.base()));
+    }
+    payload += lengthDelimited(actuators, reversedFields(feedback.actuators(i)));
+  }
+  k_api::BaseCyclic::Feedback frame_id_only;
+  frame_id_only.set_frame_id(feedback.frame_id());
+  payload += frame_id_only.SerializeAsString();
+
+  expectSameSnapshot(payload, count, true);
+  expectSameSnapshot(payload, count, false);
+}
+
+TEST_P(CyclicFrameCodecTest, DecoderReadsMissingFieldsAsZero)
+{
+  const std::size_t count = GetParam();
+  // no base, no interconnect, fewer actuators than expected and some of their fields missing
+  k_api::BaseCyclic::Feedback feedback;
+  feedback.add_actuators()->set_velocity(5.0f);
+  feedback.add_actuators()->set_position(90.0f);
+  feedback.add_actuators()->set_fault_bank_b(4);
+  expectSameSnapshot(feedback.SerializeAsString(), count, true);
+  expectSameSnapshot(feedback.SerializeAsString(), count, false);
+  expectSameSnapshot(std::string(), count, true);
+
+  // a gripper feedback without any motor
+  feedback.mutable_interconnect()->mutable_gripper_feedback();
+  expectSameSnapshot(feedback.SerializeAsString(), count, true);
+}
+
+TEST_P(CyclicFrameCodecTest, DecoderRejectsMalformedFrames)
+{
+  const std::size_t count = GetParam();
+  const std::string payload = makeFeedback(count).SerializeAsString();
+  CyclicFeedbackDecoder decoder;
+  ASSERT_TRUE(decoder.configure(count));
+  FeedbackSnapshot snapshot;
+  snapshot.resize(count);
+  snapshot.positions[0] = 123.0;
+  snapshot.faults = 7.0;
+  for (const std::size_t length : {payload.size() - 1, payload.size() - 3, std::size_t{1}})
+  {
+    EXPECT_FALSE(decoder.decode(payload.substr(0, length), snapshot, true)) << length;
+    // left untouched
+    EXPECT_EQ(snapshot.positions[0], 123.0);
+    EXPECT_EQ(snapshot.faults, 7.0);
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+  ActuatorCounts, CyclicFrameCodecTest, ::testing::Values(std::size_t{6}, std::size_t{7}));
+
+}  // namespace kortex_driver
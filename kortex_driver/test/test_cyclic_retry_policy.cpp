@@ -0,0 +1,85 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+
+#include "kortex_driver/cyclic_retry_policy.hpp"
+
+namespace kortex_driver
+{
+TEST(CyclicRetryPolicy, ParsesKnownFailureActions)
+{
+  CyclicFailureAction action = CyclicFailureAction::REFRESH_FEEDBACK;
+  ASSERT_TRUE(CyclicRetryPolicy::parseFailureAction("skip", action));
+  EXPECT_EQ(action, CyclicFailureAction::SKIP);
+  ASSERT_TRUE(CyclicRetryPolicy::parseFailureAction("refresh_feedback", action));
+  EXPECT_EQ(action, CyclicFailureAction::REFRESH_FEEDBACK);
+}
+
+TEST(CyclicRetryPolicy, RejectsUnknownFailureActions)
+{
+  CyclicFailureAction action = CyclicFailureAction::REFRESH_FEEDBACK;
+  EXPECT_FALSE(CyclicRetryPolicy::parseFailureAction("", action));
+  EXPECT_FALSE(CyclicRetryPolicy::parseFailureAction("Skip", action));
+  EXPECT_FALSE(CyclicRetryPolicy::parseFailureAction("retry", action));
+  // left alone on failure
+  EXPECT_EQ(action, CyclicFailureAction::REFRESH_FEEDBACK);
+}
+
+TEST(CyclicRetryPolicy, DefaultsKeepTheDriverBehavior)
+{
+  const CyclicRetryPolicy policy;
+  EXPECT_EQ(policy.max_retries, 0u);
+  EXPECT_EQ(policy.timeout_ms, 3000u);
+  EXPECT_EQ(policy.max_consecutive_failures, 0u);
+  EXPECT_EQ(policy.on_failure, CyclicFailureAction::SKIP);
+}
+
+TEST(CyclicStatistics, RecordsPerErrorAndResets)
+{
+  CyclicStatistics statistics;
+  statistics.record(CyclicError::KORTEX);
+  statistics.record(CyclicError::KORTEX);
+  statistics.record(CyclicError::FUTURE);
+  statistics.retries = 3.0;
+  EXPECT_EQ(statistics.errors[static_cast<std::size_t>(CyclicError::KORTEX)], 2.0);
+  EXPECT_EQ(statistics.errors[static_cast<std::size_t>(CyclicError::FUTURE)], 1.0);
+  EXPECT_EQ(statistics.errors[static_cast<std::size_t>(CyclicError::RUNTIME)], 0.0);
+
+  statistics.reset();
+  for (const double count : statistics.errors)
+  {
+    EXPECT_EQ(count, 0.0);
+  }
+  EXPECT_EQ(statistics.retries, 0.0);
+}
+
+TEST(CyclicStatistics, ErrorNamesAreUniqueInterfaceNames)
+{
+  // the names are exported as state interfaces of cyclic_stats
+  for (std::size_t i = 1; i < static_cast<std::size_t>(CyclicError::COUNT); i++)
+  {
+    const std::string name = toString(static_cast<CyclicError>(i));
+    EXPECT_NE(name, "unknown");
+    for (std::size_t j = 1; j < i; j++)
+    {
+      EXPECT_NE(name, toString(static_cast<CyclicError>(j)));
+    }
+  }
+}
+
+}  // namespace kortex_driver
@@ -0,0 +1,193 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "kortex_driver/fake_hardware.hpp"
+
+#include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "rclcpp_lifecycle/state.hpp"
+
+// Runs whole control cycles of the fake hardware. Built with KORTEX_DRIVER_RT_CHECKS the test
+// runs under the real-time checker with KORTEX_RT_CHECKER=abort, so anything its read(),
+// write() or perform_command_mode_switch() do that is not real-time safe aborts it.
+
+namespace kortex_driver
+{
+namespace
+{
+constexpr std::size_t JOINT_COUNT = 7;
+
+hardware_interface::InterfaceInfo interfaceInfo(const std::string & name)
+{
+  hardware_interface::InterfaceInfo interface;
+  interface.name = name;
+  return interface;
+}
+
+hardware_interface::HardwareInfo makeInfo(const std::string & failure_rate)
+{
+  hardware_interface::HardwareInfo info;
+  info.name = "kortex_fake";
+  info.type = "system";
+  info.hardware_parameters["gripper_joint_name"] = "gripper_joint";
+  info.hardware_parameters["fake_lockstep_period_ms"] = "1";
+  info.hardware_parameters["fake_cyclic_latency_ms"] = "2";
+  info.hardware_parameters["fake_cyclic_failure_rate"] = failure_rate;
+  info.hardware_parameters["fake_fault_reset_latency_ms"] = "10";
+  info.hardware_parameters["fake_seed"] = "3";
+  for (std::size_t i = 0; i <= JOINT_COUNT; i++)
+  {
+    hardware_interface::ComponentInfo joint;
+    joint.name = i < JOINT_COUNT ? "joint_" + std::to_string(i + 1) : "gripper_joint";
+    joint.type = "joint";
+    joint.command_interfaces.push_back(interfaceInfo(hardware_interface::HW_IF_POSITION));
+    joint.state_interfaces.push_back(interfaceInfo(hardware_interface::HW_IF_POSITION));
+    joint.state_interfaces.push_back(interfaceInfo(hardware_interface::HW_IF_VELOCITY));
+    info.joints.push_back(joint);
+  }
+  return info;
+}
+
+class FakeHardwareTest : public ::testing::Test
+{
+protected:
+  void init(const std::string & failure_rate)
+  {
+    ASSERT_EQ(hardware_.on_init(makeInfo(failure_rate)), CallbackReturn::SUCCESS);
+    state_interfaces_ = hardware_.export_state_interfaces();
+    command_interfaces_ = hardware_.export_command_interfaces();
+  }
+
+  void switchControllers(
+    const std::vector<std::string> & start_interfaces,
+    const std::vector<std::string> & stop_interfaces)
+  {
+    ASSERT_EQ(
+      hardware_.prepare_command_mode_switch(start_interfaces, stop_interfaces), return_type::OK);
+    ASSERT_EQ(
+      hardware_.perform_command_mode_switch(start_interfaces, stop_interfaces), return_type::OK);
+  }
+
+  void runCycles(int count)
+  {
+    for (int i = 0; i < count; i++)
+    {
+      ASSERT_EQ(hardware_.read(time_, period_), return_type::OK);
+      ASSERT_EQ(hardware_.write(time_, period_), return_type::OK);
+      time_ += period_;
+    }
+  }
+
+  hardware_interface::StateInterface & state(const std::string & name)
+  {
+    for (auto & interface : state_interfaces_)
+    {
+      if (interface.get_name() == name)
+      {
+        return interface;
+      }
+    }
+    ADD_FAILURE() << "no state interface " << name;
+    return state_interfaces_.front();
+  }
+
+  hardware_interface::CommandInterface & command(const std::string & name)
+  {
+    for (auto & interface : command_interfaces_)
+    {
+      if (interface.get_name() == name)
+      {
+        return interface;
+      }
+    }
+    ADD_FAILURE() << "no command interface " << name;
+    return command_interfaces_.front();
+  }
+
+  static std::vector<std::string> jointInterfaces()
+  {
+    std::vector<std::string> interfaces;
+    for (std::size_t i = 0; i < JOINT_COUNT; i++)
+    {
+      interfaces.push_back("joint_" + std::to_string(i + 1) + "/position");
+    }
+    return interfaces;
+  }
+
+  KortexFakeHardware hardware_;
+  std::vector<hardware_interface::StateInterface> state_interfaces_;
+  std::vector<hardware_interface::CommandInterface> command_interfaces_;
+  rclcpp::Time time_{0, 0, RCL_STEADY_TIME};
+  const rclcpp::Duration period_ = rclcpp::Duration::from_nanoseconds(1000000);
+};
+}  // namespace
+
+TEST_F(FakeHardwareTest, JointsTrackTheirCommands)
+{
+  init("0");
+  switchControllers({"reset_fault/command", "reset_fault/async_success"}, {});
+  ASSERT_EQ(hardware_.on_activate(rclcpp_lifecycle::State()), CallbackReturn::SUCCESS);
+  runCycles(10);
+
+  switchControllers(jointInterfaces(), {});
+  command("joint_1/position").set_value(0.5);
+  command("joint_7/position").set_value(-0.25);
+  runCycles(500);
+  EXPECT_NEAR(state("joint_1/position").get_value(), 0.5, 1e-6);
+  EXPECT_NEAR(state("joint_7/position").get_value(), -0.25, 1e-6);
+  EXPECT_NEAR(state("joint_1/velocity").get_value(), 0.0, 1e-3);
+  EXPECT_EQ(state("latency_compensation/horizon").get_value(), 0.0);
+  EXPECT_EQ(state("joint_1/external_effort").get_value(), 0.0);
+  EXPECT_EQ(state("collision_detection/contact").get_value(), 0.0);
+  // without dynamics_feedforward
+  EXPECT_TRUE(std::isnan(state("joint_1/gravity_effort").get_value()));
+
+  // the arm holds where it is once its controller is stopped
+  switchControllers({}, jointInterfaces());
+  command("joint_1/position").set_value(1.0);
+  runCycles(100);
+  EXPECT_NEAR(state("joint_1/position").get_value(), 0.5, 1e-6);
+
+  // the gripper and a twist controller, twist commands are accepted but not simulated
+  switchControllers({"gripper_joint/position", "tcp/twist.linear.x"}, {});
+  command("gripper_joint/position").set_value(0.4);
+  command("tcp/twist.linear.x").set_value(0.1);
+  runCycles(2000);
+  EXPECT_NEAR(state("gripper_joint/position").get_value(), 0.4, 1e-6);
+}
+
+TEST_F(FakeHardwareTest, SurvivesFailedCyclesAndFaultResets)
+{
+  init("0.2");
+  switchControllers(jointInterfaces(), {});
+  switchControllers({"reset_fault/command", "reset_fault/async_success"}, {});
+  ASSERT_EQ(hardware_.on_activate(rclcpp_lifecycle::State()), CallbackReturn::SUCCESS);
+
+  command("joint_3/position").set_value(0.75);
+  runCycles(1000);
+  EXPECT_GT(state("cyclic_stats/failed_cycles").get_value(), 0.0);
+  EXPECT_NEAR(state("joint_3/position").get_value(), 0.75, 1e-6);
+
+  command("reset_fault/command").set_value(1.0);
+  runCycles(50);
+  EXPECT_EQ(command("reset_fault/async_success").get_value(), 1.0);
+  EXPECT_EQ(state("reset_fault/internal_fault").get_value(), 0.0);
+}
+
+}  // namespace kortex_driver
@@ -0,0 +1,89 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "kortex_driver/joint_state_estimator.hpp"
+#include "kortex_driver/kortex_math_util.hpp"
+
+namespace kortex_driver
+{
+TEST(JointStateEstimator, FirstUpdateTakesTheMeasurements)
+{
+  JointStateEstimator estimator;
+  estimator.configure(2, 0.9);
+  estimator.update({0.5, -1.0}, {0.1, 0.2}, 0.001);
+  EXPECT_EQ(estimator.positions()[0], 0.5);
+  EXPECT_EQ(estimator.positions()[1], -1.0);
+  EXPECT_EQ(estimator.velocities()[0], 0.1);
+  EXPECT_EQ(estimator.velocities()[1], 0.2);
+  EXPECT_EQ(estimator.accelerations()[0], 0.0);
+}
+
+TEST(JointStateEstimator, TracksAConstantVelocity)
+{
+  JointStateEstimator estimator;
+  estimator.configure(1, 0.9);
+  const double dt = 0.001;
+  const double velocity = 0.5;
+  double position = -1.0;
+  estimator.update({position}, {0.0}, dt);
+  for (int cycle = 0; cycle < 2000; cycle++)
+  {
+    position += velocity * dt;
+    estimator.update({position}, {0.0}, dt);
+  }
+  EXPECT_NEAR(estimator.positions()[0], position, 1e-6);
+  EXPECT_NEAR(estimator.velocities()[0], velocity, 1e-4);
+  EXPECT_NEAR(estimator.accelerations()[0], 0.0, 1e-2);
+}
+
+TEST(JointStateEstimator, NoJumpWhenThePositionWrapsAtPi)
+{
+  JointStateEstimator estimator;
+  estimator.configure(1, 0.9);
+  const double dt = 0.001;
+  const double velocity = 2.0;
+  double unwrapped = M_PI - 0.5;
+  estimator.update({unwrapped}, {velocity}, dt);
+  for (int cycle = 0; cycle < 1000; cycle++)
+  {
+    // crosses +pi to -pi after 250 cycles
+    unwrapped += velocity * dt;
+    estimator.update({KortexMathUtil::wrapRadiansFromMinusPiToPi(unwrapped)}, {0.0}, dt);
+    EXPECT_LE(std::abs(estimator.positions()[0]), M_PI + 1e-12);
+    EXPECT_NEAR(estimator.velocities()[0], velocity, 1e-6) << "cycle " << cycle;
+    EXPECT_NEAR(estimator.accelerations()[0], 0.0, 1e-3) << "cycle " << cycle;
+  }
+  EXPECT_NEAR(
+    estimator.positions()[0], KortexMathUtil::wrapRadiansFromMinusPiToPi(unwrapped), 1e-9);
+}
+
+TEST(JointStateEstimator, ResetRestartsFromTheMeasurements)
+{
+  JointStateEstimator estimator;
+  estimator.configure(1, 0.9);
+  estimator.update({0.0}, {0.0}, 0.001);
+  estimator.update({0.1}, {0.0}, 0.001);
+  estimator.reset();
+  estimator.update({-2.0}, {0.3}, 0.001);
+  EXPECT_EQ(estimator.positions()[0], -2.0);
+  EXPECT_EQ(estimator.velocities()[0], 0.3);
+  EXPECT_EQ(estimator.accelerations()[0], 0.0);
+}
+
+}  // namespace kortex_driver
@@ -0,0 +1,158 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "kortex_driver/latency_predictor.hpp"
+
+namespace kortex_driver
+{
+namespace
+{
+constexpr std::int64_t PERIOD_NS = 1000000;
+constexpr std::int64_t ROUND_TRIP_NS = 200000;
+
+// Exchanges every period after a first horizon of horizon_ns, measured from the first two
+// exchanges and then left unchanged. Each frame measures the joint at velocity rad/s, sampled
+// half a round trip before it is received, and predicts from it. Returns the sampling time of
+// the last frame.
+std::int64_t moveAtConstantVelocity(
+  LatencyPredictor & predictor, std::int64_t horizon_ns, double velocity, int frames)
+{
+  predictor.recordExchange(0, ROUND_TRIP_NS, true);
+  std::int64_t request_ns = horizon_ns;
+  predictor.recordExchange(request_ns, request_ns + ROUND_TRIP_NS, true);
+  std::int64_t sample_ns = request_ns + ROUND_TRIP_NS / 2;
+  for (int frame = 0; frame < frames; frame++)
+  {
+    if (frame > 0)
+    {
+      request_ns += PERIOD_NS;
+      predictor.recordExchange(request_ns, request_ns + ROUND_TRIP_NS, false);
+      sample_ns = request_ns + ROUND_TRIP_NS / 2;
+    }
+    std::vector<double> positions = {velocity * sample_ns / 1e9};
+    std::vector<double> velocities = {velocity};
+    predictor.predict(positions, velocities);
+  }
+  return sample_ns;
+}
+}  // namespace
+
+TEST(LatencyPredictor, HorizonSpansTheFrameAgeAndHalfTheRoundTrips)
+{
+  LatencyPredictor predictor;
+  predictor.configure(1, true, 1.0, 0.5);
+  // no horizon before a command was computed from a received frame
+  predictor.recordExchange(0, 1000000, true);
+  EXPECT_EQ(predictor.statistics().horizon, 0.0);
+  // received 1 ms ago, plus half of the previous and half of this 1 ms round trip
+  predictor.recordExchange(2000000, 3000000, true);
+  EXPECT_NEAR(predictor.statistics().horizon, 0.002, 1e-12);
+  // 1 ms since the last frame and a 2 ms round trip, smoothed with the first
+  predictor.recordExchange(4000000, 6000000, true);
+  EXPECT_NEAR(predictor.statistics().horizon, 0.0025, 1e-12);
+  // exchanges without a command do not measure it
+  predictor.recordExchange(8000000, 9000000, false);
+  EXPECT_NEAR(predictor.statistics().horizon, 0.0025, 1e-12);
+}
+
+TEST(LatencyPredictor, HorizonIsLimited)
+{
+  LatencyPredictor predictor;
+  predictor.configure(1, true, 0.001, 0.5);
+  predictor.recordExchange(0, 1000000, true);
+  predictor.recordExchange(10000000, 11000000, true);
+  EXPECT_EQ(predictor.statistics().horizon, 0.001);
+}
+
+TEST(LatencyPredictor, DisabledLeavesTheStates)
+{
+  LatencyPredictor predictor;
+  predictor.configure(1, false, 1.0, 0.5);
+  predictor.recordExchange(0, 1000000, true);
+  predictor.recordExchange(2000000, 3000000, true);
+  std::vector<double> positions = {0.5};
+  std::vector<double> velocities = {1.0};
+  predictor.predict(positions, velocities);
+  EXPECT_EQ(positions[0], 0.5);
+  EXPECT_EQ(velocities[0], 1.0);
+}
+
+TEST(LatencyPredictor, PredictionWrapsAtPi)
+{
+  LatencyPredictor predictor;
+  predictor.configure(2, true, 1.0, 0.5);
+  predictor.recordExchange(0, 1000000, true);
+  predictor.recordExchange(2000000, 3000000, true);
+  ASSERT_NEAR(predictor.statistics().horizon, 0.002, 1e-12);
+  // 2 mrad forward over the horizon, past +pi for the first joint and -pi for the second
+  std::vector<double> positions = {M_PI - 0.001, -M_PI + 0.001};
+  std::vector<double> velocities = {1.0, -1.0};
+  predictor.predict(positions, velocities);
+  EXPECT_NEAR(positions[0], -M_PI + 0.001, 1e-12);
+  EXPECT_NEAR(positions[1], M_PI - 0.001, 1e-12);
+  EXPECT_EQ(velocities[0], 1.0);
+  EXPECT_EQ(velocities[1], -1.0);
+}
+
+TEST(LatencyPredictor, ExactPredictionsHaveNoError)
+{
+  LatencyPredictor predictor;
+  predictor.configure(1, true, 1.0, 0.5);
+  // one period ahead, every prediction is checked against the next frame
+  const int frames = 20;
+  moveAtConstantVelocity(predictor, PERIOD_NS, 0.5, frames);
+  EXPECT_EQ(predictor.statistics().checked_predictions, frames - 1);
+  EXPECT_NEAR(predictor.statistics().error_max, 0.0, 1e-9);
+  EXPECT_NEAR(predictor.statistics().error_rms, 0.0, 1e-9);
+}
+
+TEST(LatencyPredictor, ChecksThePredictionClosestToTheFrame)
+{
+  const double velocity = 0.5;
+  // the frame sampled 0.4 period after the target of the earlier of two pending predictions,
+  // then 0.4 period before the target of the later one
+  for (const std::int64_t horizon_ns : {26 * PERIOD_NS / 10, 24 * PERIOD_NS / 10})
+  {
+    LatencyPredictor predictor;
+    predictor.configure(1, true, 1.0, 0.5);
+    moveAtConstantVelocity(predictor, horizon_ns, velocity, 20);
+    EXPECT_GT(predictor.statistics().checked_predictions, 0.0) << "horizon " << horizon_ns;
+    // the other prediction is 0.6 period away
+    EXPECT_NEAR(predictor.statistics().error_max, velocity * 0.4 * PERIOD_NS / 1e9, 1e-8)
+      << "horizon " << horizon_ns;
+  }
+}
+
+TEST(LatencyPredictor, ResetDropsThePendingPredictions)
+{
+  LatencyPredictor predictor;
+  predictor.configure(1, true, 1.0, 0.5);
+  moveAtConstantVelocity(predictor, PERIOD_NS, 0.5, 5);
+  predictor.reset();
+  EXPECT_EQ(predictor.statistics().horizon, 0.0);
+  EXPECT_EQ(predictor.statistics().checked_predictions, 0.0);
+  // nothing to predict from before the next exchange
+  std::vector<double> positions = {0.5};
+  std::vector<double> velocities = {1.0};
+  predictor.predict(positions, velocities);
+  EXPECT_EQ(positions[0], 0.5);
+}
+
+}  // namespace kortex_driver
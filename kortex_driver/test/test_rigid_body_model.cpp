@@ -0,0 +1,138 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "kortex_driver/rigid_body_model.hpp"
+
+namespace kortex_driver
+{
+namespace
+{
+using JointVector = RigidBodyModel::JointVector;
+using JointMatrix = RigidBodyModel::JointMatrix;
+
+// A serial chain with random geometry and mass properties, joint axes along z or random
+std::vector<RigidBodyModel::Body> randomBodies(int count, bool z_axes, std::mt19937 & random)
+{
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  const auto vector = [&]()
+  { return Eigen::Vector3d(uniform(random), uniform(random), uniform(random)); };
+  const auto rotation = [&]()
+  {
+    return Eigen::Quaterniond(uniform(random), uniform(random), uniform(random), uniform(random))
+      .normalized()
+      .toRotationMatrix();
+  };
+  std::vector<RigidBodyModel::Body> bodies(count);
+  for (auto & body : bodies)
+  {
+    body.rotation = rotation();
+    body.translation = 0.2 * vector();
+    body.axis = z_axes ? Eigen::Vector3d::UnitZ() : Eigen::Vector3d(vector().normalized());
+    body.mass = 0.5 + std::abs(uniform(random));
+    body.center_of_mass = 0.1 * vector();
+    // principal moments satisfying the triangle inequality, in a random orientation
+    const Eigen::Vector3d moments =
+      0.01 * Eigen::Vector3d(1.0 + std::abs(uniform(random)), 1.0 + std::abs(uniform(random)),
+                             1.0 + std::abs(uniform(random)));
+    const Eigen::Matrix3d principal = rotation();
+    body.inertia = principal * moments.asDiagonal() * principal.transpose();
+  }
+  return bodies;
+}
+
+JointVector randomJoints(int count, std::mt19937 & random)
+{
+  std::uniform_real_distribution<double> uniform(-3.0, 3.0);
+  JointVector q(count);
+  for (int i = 0; i < count; i++)
+  {
+    q[i] = uniform(random);
+  }
+  return q;
+}
+
+class RigidBodyModelTest : public ::testing::TestWithParam<bool>
+{
+};
+}  // namespace
+
+// The composite rigid body terms against the recursive Newton-Euler inverse dynamics
+TEST_P(RigidBodyModelTest, CompositesMatchInverseDynamics)
+{
+  const int count = 7;
+  std::mt19937 random(7);
+  RigidBodyModel model;
+  model.setBodies(randomBodies(count, GetParam(), random), Eigen::Vector3d(0.0, 0.0, -9.81));
+  ASSERT_EQ(model.jointCount(), count);
+
+  const JointVector zero = JointVector::Zero(count);
+  for (int trial = 0; trial < 20; trial++)
+  {
+    const JointVector q = randomJoints(count, random);
+    const JointVector qd = randomJoints(count, random);
+    const JointVector qdd = randomJoints(count, random);
+
+    // each column of the mass matrix is the torque of a unit acceleration at rest
+    JointMatrix mass_matrix;
+    model.massMatrix(q, mass_matrix);
+    for (int j = 0; j < count; j++)
+    {
+      JointVector unit = zero;
+      unit[j] = 1.0;
+      JointVector column;
+      model.inverseDynamics(q, zero, unit, false, column);
+      EXPECT_TRUE(mass_matrix.col(j).isApprox(column, 1e-9)) << "column " << j;
+    }
+    EXPECT_TRUE(mass_matrix.isApprox(mass_matrix.transpose(), 1e-12));
+
+    JointVector diagonal;
+    model.massMatrixDiagonal(q, diagonal);
+    EXPECT_TRUE(diagonal.isApprox(mass_matrix.diagonal(), 1e-12));
+
+    JointVector gravity;
+    JointVector static_torques;
+    model.gravityTorques(q, gravity);
+    model.inverseDynamics(q, zero, zero, true, static_torques);
+    EXPECT_TRUE(gravity.isApprox(static_torques, 1e-9));
+
+    // tau = M(q) qdd + C(q, qd) qd + g(q)
+    JointVector coriolis;
+    JointVector tau;
+    model.coriolisTorques(q, qd, coriolis);
+    model.inverseDynamics(q, qd, qdd, true, tau);
+    const JointVector sum = mass_matrix * qdd + coriolis + gravity;
+    EXPECT_TRUE(tau.isApprox(sum, 1e-9));
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(JointAxes, RigidBodyModelTest, ::testing::Values(true, false));
+
+TEST(RigidBodyModel, NoGravityTorqueAboutAVerticalAxis)
+{
+  std::mt19937 random(3);
+  std::vector<RigidBodyModel::Body> bodies = randomBodies(1, true, random);
+  bodies[0].rotation = Eigen::Matrix3d::Identity();
+  RigidBodyModel model;
+  model.setBodies(bodies, Eigen::Vector3d(0.0, 0.0, -9.81));
+  JointVector tau;
+  model.gravityTorques(JointVector::Constant(1, 0.7), tau);
+  EXPECT_NEAR(tau[0], 0.0, 1e-12);
+}
+
+}  // namespace kortex_driver
@@ -0,0 +1,102 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "kortex_driver/rpc_executor.hpp"
+
+namespace kortex_driver
+{
+TEST(RpcExecutor, CallRunsOnTheExecutorThread)
+{
+  RpcExecutor executor;
+  executor.start();
+  const std::thread::id caller = std::this_thread::get_id();
+  const std::thread::id runner = executor.call([]() { return std::this_thread::get_id(); });
+  EXPECT_NE(runner, caller);
+  EXPECT_EQ(executor.call([]() { return 42; }), 42);
+}
+
+TEST(RpcExecutor, CallRethrowsInTheCaller)
+{
+  RpcExecutor executor;
+  executor.start();
+  EXPECT_THROW(
+    executor.call([]() -> int { throw std::runtime_error("rpc failed"); }), std::runtime_error);
+  // the executor keeps running after a failed call
+  EXPECT_EQ(executor.call([]() { return 1; }), 1);
+}
+
+TEST(RpcExecutor, PostedTasksRunInOrder)
+{
+  RpcExecutor executor;
+  executor.start();
+  std::vector<int> order;
+  for (int i = 0; i < 10; i++)
+  {
+    ASSERT_TRUE(executor.post([&order, i]() { order.push_back(i); }));
+  }
+  // call() queues behind the posted tasks
+  executor.call([]() {});
+  ASSERT_EQ(order.size(), 10u);
+  for (int i = 0; i < 10; i++)
+  {
+    EXPECT_EQ(order[i], i);
+  }
+}
+
+TEST(RpcExecutor, PostRejectsWhenFull)
+{
+  // not started, nothing drains the queue
+  RpcExecutor executor(2);
+  EXPECT_TRUE(executor.post([]() {}));
+  EXPECT_TRUE(executor.post([]() {}));
+  EXPECT_FALSE(executor.post([]() {}));
+  EXPECT_EQ(executor.rejectedTasks(), 1u);
+}
+
+TEST(RpcExecutor, PostWakesASleepingExecutor)
+{
+  RpcExecutor executor;
+  executor.start();
+  // long enough for the executor to go to sleep on its eventfd
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  std::atomic<bool> ran{false};
+  ASSERT_TRUE(executor.post([&ran]() { ran = true; }));
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+  while (!ran && std::chrono::steady_clock::now() < deadline)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_TRUE(ran);
+}
+
+TEST(RpcExecutor, CallRunsInlineOnceStopped)
+{
+  RpcExecutor executor;
+  executor.start();
+  executor.stop();
+  // stopping twice is harmless
+  executor.stop();
+  const std::thread::id caller = std::this_thread::get_id();
+  EXPECT_EQ(executor.call([]() { return std::this_thread::get_id(); }), caller);
+}
+
+}  // namespace kortex_driver
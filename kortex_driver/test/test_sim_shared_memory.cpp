@@ -0,0 +1,137 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+
+#include "kortex_driver/sim_shared_memory.hpp"
+
+namespace kortex_driver
+{
+namespace
+{
+class SimSharedMemoryTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    name_ = "/kortex_driver_test_" + std::to_string(getpid()) + "_" +
+            ::testing::UnitTest::GetInstance()->current_test_info()->name();
+    shm_unlink(name_.c_str());
+  }
+  void TearDown() override { shm_unlink(name_.c_str()); }
+
+  std::string name_;
+};
+}  // namespace
+
+TEST_F(SimSharedMemoryTest, NothingToReadBeforeTheFirstWrite)
+{
+  SimSharedMemory memory;
+  ASSERT_TRUE(memory.open(name_, 7));
+  SimFrame frame;
+  std::uint32_t sequence = 0;
+  EXPECT_FALSE(memory.readState(frame, sequence));
+  EXPECT_FALSE(memory.readCommand(frame, sequence));
+}
+
+TEST_F(SimSharedMemoryTest, PeersExchangeTheLatestFrame)
+{
+  SimSharedMemory driver;
+  SimSharedMemory simulator;
+  ASSERT_TRUE(driver.open(name_, 7));
+  ASSERT_TRUE(simulator.open(name_, 7));
+
+  SimFrame command;
+  command.stamp_ns = 1234;
+  command.gripper_position = 0.5;
+  for (std::size_t i = 0; i < 7; i++)
+  {
+    command.positions[i] = 0.1 * static_cast<double>(i);
+    command.velocities[i] = -0.2 * static_cast<double>(i);
+  }
+  driver.writeCommand(command);
+
+  SimFrame received;
+  std::uint32_t first_sequence = 0;
+  ASSERT_TRUE(simulator.readCommand(received, first_sequence));
+  EXPECT_EQ(received.stamp_ns, 1234u);
+  EXPECT_EQ(received.gripper_position, 0.5);
+  for (std::size_t i = 0; i < 7; i++)
+  {
+    EXPECT_EQ(received.positions[i], command.positions[i]);
+    EXPECT_EQ(received.velocities[i], command.velocities[i]);
+  }
+
+  // the same frame read again keeps its sequence, a new one does not
+  std::uint32_t sequence = 0;
+  ASSERT_TRUE(simulator.readCommand(received, sequence));
+  EXPECT_EQ(sequence, first_sequence);
+  command.stamp_ns = 5678;
+  driver.writeCommand(command);
+  ASSERT_TRUE(simulator.readCommand(received, sequence));
+  EXPECT_NE(sequence, first_sequence);
+  EXPECT_EQ(received.stamp_ns, 5678u);
+
+  // the state slot is independent of the command slot
+  EXPECT_FALSE(driver.readState(received, sequence));
+  SimFrame state;
+  state.efforts[3] = 2.5;
+  simulator.writeState(state);
+  ASSERT_TRUE(driver.readState(received, sequence));
+  EXPECT_EQ(received.efforts[3], 2.5);
+}
+
+TEST_F(SimSharedMemoryTest, RejectsAnotherJointCount)
+{
+  SimSharedMemory creator;
+  ASSERT_TRUE(creator.open(name_, 7));
+  SimSharedMemory peer;
+  EXPECT_FALSE(peer.open(name_, 6));
+  EXPECT_FALSE(peer.isOpen());
+}
+
+TEST_F(SimSharedMemoryTest, RejectsAnotherVersion)
+{
+  {
+    SimSharedMemory creator;
+    ASSERT_TRUE(creator.open(name_, 7));
+  }
+  // a segment left over by a build with another layout
+  const int fd = shm_open(name_.c_str(), O_RDWR, 0600);
+  ASSERT_GE(fd, 0);
+  void * address =
+    mmap(nullptr, sizeof(SimSharedMemoryLayout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  ASSERT_NE(address, MAP_FAILED);
+  static_cast<SimSharedMemoryLayout *>(address)->version = SIM_SHARED_MEMORY_VERSION + 1;
+  munmap(address, sizeof(SimSharedMemoryLayout));
+
+  SimSharedMemory peer;
+  EXPECT_FALSE(peer.open(name_, 7));
+}
+
+TEST_F(SimSharedMemoryTest, RejectsTooManyJoints)
+{
+  SimSharedMemory memory;
+  EXPECT_FALSE(memory.open(name_, SIM_MAX_JOINTS + 1));
+}
+
+}  // namespace kortex_driver
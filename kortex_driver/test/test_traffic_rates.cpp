@@ -0,0 +1,76 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "kortex_driver/metered_transport.hpp"
+
+namespace kortex_driver
+{
+namespace
+{
+TrafficCounters counters(
+  std::uint64_t tx_bytes, std::uint64_t tx_packets, std::uint64_t rx_bytes,
+  std::uint64_t rx_packets)
+{
+  TrafficCounters result;
+  result.tx_bytes = tx_bytes;
+  result.tx_packets = tx_packets;
+  result.rx_bytes = rx_bytes;
+  result.rx_packets = rx_packets;
+  return result;
+}
+}  // namespace
+
+TEST(TrafficRates, FirstCycleOnlyStartsTheWindow)
+{
+  TrafficRates rates;
+  rates.update(counters(1000, 10, 2000, 20), 0.001, 0.01);
+  EXPECT_EQ(rates.tx_bytes_per_second, 0.0);
+  EXPECT_EQ(rates.rx_packets_per_second, 0.0);
+}
+
+TEST(TrafficRates, RatesAreRefreshedOncePerWindow)
+{
+  TrafficRates rates;
+  rates.update(counters(0, 0, 0, 0), 0.001, 0.01);
+  // 1 kHz loop, one 100 byte frame sent and one 300 byte frame received per cycle
+  for (std::uint64_t cycle = 1; cycle < 10; cycle++)
+  {
+    rates.update(counters(100 * cycle, cycle, 300 * cycle, cycle), 0.001, 0.01);
+    EXPECT_EQ(rates.tx_bytes_per_second, 0.0);
+  }
+  rates.update(counters(1000, 10, 3000, 10), 0.001, 0.01);
+  EXPECT_NEAR(rates.tx_bytes_per_second, 100000.0, 1e-6);
+  EXPECT_NEAR(rates.rx_bytes_per_second, 300000.0, 1e-6);
+  EXPECT_NEAR(rates.tx_packets_per_second, 1000.0, 1e-9);
+  EXPECT_NEAR(rates.rx_packets_per_second, 1000.0, 1e-9);
+  EXPECT_NEAR(rates.tx_packets_per_cycle, 1.0, 1e-12);
+}
+
+TEST(TrafficRates, NextWindowStartsFromTheLastCounters)
+{
+  TrafficRates rates;
+  rates.update(counters(0, 0, 0, 0), 0.5, 1.0);
+  rates.update(counters(10, 1, 0, 0), 0.5, 1.0);
+  rates.update(counters(20, 2, 0, 0), 0.5, 1.0);
+  EXPECT_NEAR(rates.tx_bytes_per_second, 20.0, 1e-12);
+  // a retry doubles the packets sent in this window
+  rates.update(counters(40, 4, 0, 0), 0.5, 1.0);
+  rates.update(counters(60, 6, 0, 0), 0.5, 1.0);
+  EXPECT_NEAR(rates.tx_bytes_per_second, 40.0, 1e-12);
+  EXPECT_NEAR(rates.tx_packets_per_cycle, 2.0, 1e-12);
+}
+
+}  // namespace kortex_driver
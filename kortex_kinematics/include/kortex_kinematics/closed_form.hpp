@@ -0,0 +1,55 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef KORTEX_KINEMATICS__CLOSED_FORM_HPP_
+#define KORTEX_KINEMATICS__CLOSED_FORM_HPP_
+
+#include <array>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+namespace kortex_kinematics
+{
+// Angles theta with a cos(theta) + b sin(theta) = k, returns how many of the two exist
+int solveCosineSine(double a, double b, double k, std::array<double, 2> & theta);
+
+// Angles of the joint rotations in
+//   rotation = Rz(theta[0]) first Rz(theta[1]) second Rz(theta[2])
+// with first and second the fixed rotations between three consecutive z axis joints. Returns
+// how many of the two branches exist. When the first and last axes are aligned only their sum
+// is defined, theta[0] then keeps the value of hint.
+int decomposeRotation(
+  const Eigen::Matrix3d & rotation, const Eigen::Matrix3d & first, const Eigen::Matrix3d & second,
+  double hint, std::array<Eigen::Vector3d, 2> & theta);
+
+// p^T Rz(theta) r written as a cos(theta) + b sin(theta) + c
+void cosineSineCoefficients(
+  const Eigen::Vector3d & p, const Eigen::Vector3d & r, double & a, double & b, double & c);
+
+// Angle in [-pi, pi]
+double wrapAngle(double angle);
+
+// Point of the line (point, direction) closest to the other line, directions of unit length
+Eigen::Vector3d closestPoint(
+  const Eigen::Vector3d & point, const Eigen::Vector3d & direction,
+  const Eigen::Vector3d & other_point, const Eigen::Vector3d & other_direction);
+
+double distanceToLine(
+  const Eigen::Vector3d & point, const Eigen::Vector3d & line_point,
+  const Eigen::Vector3d & line_direction);
+
+}  // namespace kortex_kinematics
+
+#endif  // KORTEX_KINEMATICS__CLOSED_FORM_HPP_
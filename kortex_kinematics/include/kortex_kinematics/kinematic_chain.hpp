@@ -0,0 +1,74 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef KORTEX_KINEMATICS__KINEMATIC_CHAIN_HPP_
+#define KORTEX_KINEMATICS__KINEMATIC_CHAIN_HPP_
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+namespace kortex_kinematics
+{
+// Serial chain of revolute joints turning about the z axis of their frame, as every joint of
+// the Kinova arms does. Nothing allocates once the chain is set.
+class KinematicChain
+{
+public:
+  static constexpr int MAX_JOINTS = 7;
+  using JointVector = Eigen::Matrix<double, Eigen::Dynamic, 1, 0, MAX_JOINTS, 1>;
+  using Jacobian = Eigen::Matrix<double, 6, Eigen::Dynamic, 0, 6, MAX_JOINTS>;
+  // room for every IK branch of the solvers
+  static constexpr int MAX_SOLUTIONS = 16;
+  using Solutions = std::array<JointVector, MAX_SOLUTIONS>;
+
+  // origins[i] is the frame of joint i at zero position in the frame of joint i - 1, the
+  // first one in the base frame. tool is the tip in the frame of the last joint.
+  void setJoints(const std::vector<Eigen::Isometry3d> & origins, const Eigen::Isometry3d & tool);
+
+  int size() const { return joint_count_; }
+  const Eigen::Isometry3d & origin(int joint) const { return origins_[joint]; }
+  const Eigen::Isometry3d & tool() const { return tool_; }
+
+  // Tip in the base frame, the second form also gives the frame of every joint
+  Eigen::Isometry3d forward(const JointVector & q) const;
+  Eigen::Isometry3d forward(
+    const JointVector & q, std::array<Eigen::Isometry3d, MAX_JOINTS> & joint_frames) const;
+
+  // Geometric Jacobian of the tip, angular rows last
+  void jacobian(const JointVector & q, Jacobian & jacobian) const;
+
+  // Newton iterations of a 6 joint chain towards target. False unless the tip ends within
+  // tolerance, in m and rad.
+  bool refine(
+    const Eigen::Isometry3d & target, JointVector & q, double tolerance, int max_iterations) const;
+
+  // Position and orientation error of the tip at q, orientation as a rotation vector
+  Eigen::Matrix<double, 6, 1> error(const Eigen::Isometry3d & target, const JointVector & q) const;
+
+private:
+  std::array<Eigen::Isometry3d, MAX_JOINTS> origins_;
+  Eigen::Isometry3d tool_ = Eigen::Isometry3d::Identity();
+  int joint_count_ = 0;
+};
+
+// Orientation error of current towards target as a rotation vector, in the base frame
+Eigen::Vector3d rotationError(const Eigen::Matrix3d & target, const Eigen::Matrix3d & current);
+
+}  // namespace kortex_kinematics
+
+#endif  // KORTEX_KINEMATICS__KINEMATIC_CHAIN_HPP_
@@ -0,0 +1,131 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef KORTEX_KINEMATICS__KORTEX_KINEMATICS_PLUGIN_HPP_
+#define KORTEX_KINEMATICS__KORTEX_KINEMATICS_PLUGIN_HPP_
+
+#include <string>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <moveit/kinematics_base/kinematics_base.h>
+
+#include "kortex_kinematics/kinematic_chain.hpp"
+#include "kortex_kinematics/seven_dof_solver.hpp"
+#include "kortex_kinematics/six_dof_solver.hpp"
+
+namespace kortex_kinematics
+{
+// Closed-form IK of the Gen3 7-DoF, Gen3 6-DoF and Gen3 lite, picked from the number of joints
+// in the group. The redundancy of the 7-DoF is the swivel angle of the elbow around the shoulder
+// to wrist line: a search starts at the swivel of the seed and steps away from it by the search
+// discretization until a solution fits the limits, or the timeout.
+class KortexKinematicsPlugin : public kinematics::KinematicsBase
+{
+public:
+  bool initialize(
+    const rclcpp::Node::SharedPtr & node, const moveit::core::RobotModel & robot_model,
+    const std::string & group_name, const std::string & base_frame,
+    const std::vector<std::string> & tip_frames, double search_discretization) override;
+
+  bool getPositionIK(
+    const geometry_msgs::msg::Pose & ik_pose, const std::vector<double> & ik_seed_state,
+    std::vector<double> & solution, moveit_msgs::msg::MoveItErrorCodes & error_code,
+    const kinematics::KinematicsQueryOptions & options =
+      kinematics::KinematicsQueryOptions()) const override;
+
+  // Every branch that fits the joint limits, at the swivel angle of the seed for the 7-DoF
+  bool getPositionIK(
+    const std::vector<geometry_msgs::msg::Pose> & ik_poses,
+    const std::vector<double> & ik_seed_state, std::vector<std::vector<double>> & solutions,
+    kinematics::KinematicsResult & result,
+    const kinematics::KinematicsQueryOptions & options) const override;
+
+  bool searchPositionIK(
+    const geometry_msgs::msg::Pose & ik_pose, const std::vector<double> & ik_seed_state,
+    double timeout, std::vector<double> & solution,
+    moveit_msgs::msg::MoveItErrorCodes & error_code,
+    const kinematics::KinematicsQueryOptions & options =
+      kinematics::KinematicsQueryOptions()) const override;
+
+  bool searchPositionIK(
+    const geometry_msgs::msg::Pose & ik_pose, const std::vector<double> & ik_seed_state,
+    double timeout, const std::vector<double> & consistency_limits,
+    std::vector<double> & solution, moveit_msgs::msg::MoveItErrorCodes & error_code,
+    const kinematics::KinematicsQueryOptions & options =
+      kinematics::KinematicsQueryOptions()) const override;
+
+  bool searchPositionIK(
+    const geometry_msgs::msg::Pose & ik_pose, const std::vector<double> & ik_seed_state,
+    double timeout, std::vector<double> & solution, const IKCallbackFn & solution_callback,
+    moveit_msgs::msg::MoveItErrorCodes & error_code,
+    const kinematics::KinematicsQueryOptions & options =
+      kinematics::KinematicsQueryOptions()) const override;
+
+  bool searchPositionIK(
+    const geometry_msgs::msg::Pose & ik_pose, const std::vector<double> & ik_seed_state,
+    double timeout, const std::vector<double> & consistency_limits,
+    std::vector<double> & solution, const IKCallbackFn & solution_callback,
+    moveit_msgs::msg::MoveItErrorCodes & error_code,
+    const kinematics::KinematicsQueryOptions & options =
+      kinematics::KinematicsQueryOptions()) const override;
+
+  bool getPositionFK(
+    const std::vector<std::string> & link_names, const std::vector<double> & joint_angles,
+    std::vector<geometry_msgs::msg::Pose> & poses) const override;
+
+  const std::vector<std::string> & getJointNames() const override { return joint_names_; }
+  const std::vector<std::string> & getLinkNames() const override { return link_names_; }
+
+private:
+  // Solver of the arm, the swivel angle is ignored by the 6-DoF arms
+  int approximate(
+    const Eigen::Isometry3d & tip, double swivel, KinematicChain::Solutions & solutions) const;
+  bool refine(
+    const Eigen::Isometry3d & tip, double swivel, KinematicChain::JointVector & q) const;
+
+  // Tries the branches at one swivel angle, closest to the seed first
+  bool solveAtSwivel(
+    const geometry_msgs::msg::Pose & ik_pose, const Eigen::Isometry3d & tip, double swivel,
+    const KinematicChain::JointVector & seed, const std::vector<double> & consistency_limits,
+    std::vector<double> & solution, const IKCallbackFn & solution_callback,
+    moveit_msgs::msg::MoveItErrorCodes & error_code) const;
+
+  // Moves each joint by whole turns towards the seed. False if it then violates the joint or
+  // consistency limits.
+  bool fitToLimits(
+    const KinematicChain::JointVector & seed, const std::vector<double> & consistency_limits,
+    KinematicChain::JointVector & q) const;
+
+  KinematicChain chain_;
+  SixDofSolver six_dof_solver_;
+  SevenDofSolver seven_dof_solver_;
+
+  std::vector<std::string> joint_names_;
+  std::vector<bool> position_bounded_;
+  std::vector<double> min_positions_;
+  std::vector<double> max_positions_;
+
+  // getPositionFK links: the child link of each joint, then the tip when it is another link
+  std::vector<std::string> link_names_;
+  std::vector<int> link_joints_;
+  std::vector<Eigen::Isometry3d> link_offsets_;
+};
+
+}  // namespace kortex_kinematics
+
+#endif  // KORTEX_KINEMATICS__KORTEX_KINEMATICS_PLUGIN_HPP_
@@ -0,0 +1,76 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef KORTEX_KINEMATICS__SEVEN_DOF_SOLVER_HPP_
+#define KORTEX_KINEMATICS__SEVEN_DOF_SOLVER_HPP_
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include "kortex_kinematics/kinematic_chain.hpp"
+
+namespace kortex_kinematics
+{
+// Closed-form inverse kinematics of a 7 joint shoulder-elbow-wrist arm such as the Gen3, whose
+// redundancy is the swivel angle of the elbow around the shoulder to wrist line. Zero swivel
+// puts the elbow in the vertical plane through that line, on the side of the base z axis.
+//
+// The Gen3 is not an exact S-R-S arm, its shoulder, elbow and wrist axes are offset by a few
+// millimeters. The closed form solves the arm without these offsets, then a few Newton steps
+// on the exact chain, with the swivel angle as seventh equation, correct every branch.
+class SevenDofSolver
+{
+public:
+  using Solutions = KinematicChain::Solutions;
+
+  // False if the chain does not have seven joints in a shoulder-elbow-wrist layout
+  bool configure(const KinematicChain & chain);
+
+  // Every branch reaching tip at this swivel angle: two shoulders, two elbows and two wrists.
+  // Returns the number of solutions, all within tolerance (m and rad) of tip.
+  int solve(
+    const Eigen::Isometry3d & tip, double swivel, Solutions & solutions,
+    double tolerance = 1e-9) const;
+
+  // The closed form alone, each branch within a few millimeters and milliradians of tip
+  int approximate(const Eigen::Isometry3d & tip, double swivel, Solutions & solutions) const;
+  // Newton iterations on the tip pose and the swivel angle, from an approximate solution.
+  // Joint values are wrapped to [-pi, pi] on success.
+  bool refine(
+    const Eigen::Isometry3d & tip, double swivel, KinematicChain::JointVector & q,
+    double tolerance = 1e-9) const;
+
+  // Swivel angle of the elbow at q
+  double swivel(const KinematicChain::JointVector & q) const;
+
+private:
+  // Unit vectors of the swivel plane around the shoulder to wrist direction
+  void swivelPlane(
+    const Eigen::Vector3d & direction, Eigen::Vector3d & reference, Eigen::Vector3d & normal) const;
+
+  KinematicChain chain_;
+  Eigen::Vector3d shoulder_ = Eigen::Vector3d::Zero();
+  // elbow in the frame of the fourth joint, wrist center in the tip frame
+  Eigen::Vector3d elbow_in_joint_ = Eigen::Vector3d::Zero();
+  Eigen::Vector3d wrist_in_tip_ = Eigen::Vector3d::Zero();
+  double upper_arm_ = 0.0;
+  double forearm_ = 0.0;
+  // +1 or -1, the upper arm and forearm along the z axes of the third and fifth joints
+  double upper_arm_sign_ = 1.0;
+  double forearm_sign_ = 1.0;
+};
+
+}  // namespace kortex_kinematics
+
+#endif  // KORTEX_KINEMATICS__SEVEN_DOF_SOLVER_HPP_
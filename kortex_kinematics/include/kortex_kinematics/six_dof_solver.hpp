@@ -0,0 +1,100 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef KORTEX_KINEMATICS__SIX_DOF_SOLVER_HPP_
+#define KORTEX_KINEMATICS__SIX_DOF_SOLVER_HPP_
+
+#include <array>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include "kortex_kinematics/kinematic_chain.hpp"
+
+namespace kortex_kinematics
+{
+// IK of a six joint arm with the second and third axes parallel, the first joint possibly offset
+// from their plane, and the fourth and fifth axes meeting at the wrist center.
+// With a spherical wrist, like the Gen3 6-DoF, the solution is in closed form. When the last
+// axis meets the fifth one away from the wrist center, like on the Gen3 lite, the closed form
+// of the first three joints is searched along the last joint for the wrist to close.
+class SixDofSolver
+{
+public:
+  using Solutions = KinematicChain::Solutions;
+
+  // False if the chain does not have six joints in that layout
+  bool configure(const KinematicChain & chain);
+
+  // Every branch reaching tip, returns the number of solutions, all within tolerance (m and
+  // rad) of tip
+  int solve(const Eigen::Isometry3d & tip, Solutions & solutions, double tolerance = 1e-9) const;
+
+  // The closed form alone, each branch within a few millimeters and milliradians of tip
+  int approximate(const Eigen::Isometry3d & tip, Solutions & solutions) const;
+  // Newton iterations on the tip pose from an approximate solution. Joint values are wrapped to
+  // [-pi, pi] on success.
+  bool refine(
+    const Eigen::Isometry3d & tip, KinematicChain::JointVector & q,
+    double tolerance = 1e-9) const;
+
+private:
+  static constexpr int ARM_BRANCHES = 4;
+  using ArmBranches = std::array<Eigen::Vector3d, ARM_BRANCHES>;
+
+  // First three joints placing the wrist center, two shoulders times two elbows. Returns a mask
+  // of the branches that exist, bit 2 * shoulder + elbow.
+  int placeWrist(const Eigen::Vector3d & wrist, ArmBranches & arm) const;
+  // Rotation of the fourth joint frame, before the fourth joint turns
+  Eigen::Matrix3d wristBase(const Eigen::Vector3d & arm) const;
+  // Last three joints giving the orientation of the last joint frame
+  int orientWrist(
+    const Eigen::Vector3d & arm, const Eigen::Matrix3d & last_frame,
+    std::array<Eigen::Vector3d, 2> & wrist) const;
+
+  // Fourth axis in the base frame
+  Eigen::Vector3d fourthAxis(const Eigen::Vector3d & arm) const;
+
+  // Offset wrist: how far the fourth axis is from its angle to the fifth axis, for each arm
+  // branch placing the wrist center where the last joint value puts it. NaN where the branch
+  // does not exist. crossing is where the fifth and last axes meet.
+  void offsetWristResiduals(
+    const Eigen::Vector3d & crossing, const Eigen::Matrix3d & last_frame, double last,
+    ArmBranches & arm, std::array<double, ARM_BRANCHES> & residuals) const;
+  // Appends the solution of one branch between two values of the last joint, if its residual
+  // changes sign there
+  void addOffsetWristRoot(
+    const Eigen::Vector3d & crossing, const Eigen::Matrix3d & last_frame, int branch, double low,
+    double low_value, double high, double high_value, Solutions & solutions, int & count) const;
+  int approximateOffsetWrist(const Eigen::Isometry3d & tip, Solutions & solutions) const;
+
+  KinematicChain chain_;
+  // wrist center in the third joint frame, and in the tip frame where the offset wrist has the
+  // crossing of the fifth and last axes instead
+  Eigen::Vector3d wrist_in_joint_ = Eigen::Vector3d::Zero();
+  Eigen::Vector3d wrist_in_tip_ = Eigen::Vector3d::Zero();
+  // wrist center along the second axis, in the first joint frame
+  double lateral_offset_ = 0.0;
+
+  bool offset_wrist_ = false;
+  // offset wrist: from the fifth and last axes crossing to the wrist center, in the last joint
+  // frame at zero position, and the cosine of its angle to the fourth axis
+  Eigen::Vector3d wrist_offset_ = Eigen::Vector3d::Zero();
+  double wrist_offset_cosine_ = 0.0;
+};
+
+}  // namespace kortex_kinematics
+
+#endif  // KORTEX_KINEMATICS__SIX_DOF_SOLVER_HPP_
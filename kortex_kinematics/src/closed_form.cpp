@@ -0,0 +1,118 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+
+#include "kortex_kinematics/closed_form.hpp"
+
+namespace kortex_kinematics
+{
+namespace
+{
+constexpr double EPSILON = 1e-12;
+// reach beyond which rounding errors are clamped rather than reported as unreachable
+constexpr double CLAMP_TOLERANCE = 1e-9;
+
+Eigen::Matrix3d rotationZ(double theta)
+{
+  return Eigen::AngleAxisd(theta, Eigen::Vector3d::UnitZ()).toRotationMatrix();
+}
+}  // namespace
+
+int solveCosineSine(double a, double b, double k, std::array<double, 2> & theta)
+{
+  const double norm = std::hypot(a, b);
+  if (norm < EPSILON)
+  {
+    return 0;
+  }
+  double ratio = k / norm;
+  if (std::abs(ratio) > 1.0 + CLAMP_TOLERANCE)
+  {
+    return 0;
+  }
+  ratio = std::min(1.0, std::max(-1.0, ratio));
+  const double phase = std::atan2(b, a);
+  const double offset = std::acos(ratio);
+  theta[0] = wrapAngle(phase + offset);
+  theta[1] = wrapAngle(phase - offset);
+  return offset < CLAMP_TOLERANCE ? 1 : 2;
+}
+
+void cosineSineCoefficients(
+  const Eigen::Vector3d & p, const Eigen::Vector3d & r, double & a, double & b, double & c)
+{
+  // Rz(theta) r = (cos r_x - sin r_y, sin r_x + cos r_y, r_z)
+  a = p.x() * r.x() + p.y() * r.y();
+  b = p.y() * r.x() - p.x() * r.y();
+  c = p.z() * r.z();
+}
+
+int decomposeRotation(
+  const Eigen::Matrix3d & rotation, const Eigen::Matrix3d & first, const Eigen::Matrix3d & second,
+  double hint, std::array<Eigen::Vector3d, 2> & theta)
+{
+  // the last joint does not move the z axis of its frame, nor does the first move z components:
+  //   z^T rotation z = z^T first Rz(theta[1]) second z
+  const Eigen::Vector3d last_axis = rotation.col(2);
+  double a = 0.0;
+  double b = 0.0;
+  double c = 0.0;
+  cosineSineCoefficients(first.transpose().col(2), second.col(2), a, b, c);
+  std::array<double, 2> middle;
+  const int count = solveCosineSine(a, b, last_axis.z() - c, middle);
+
+  for (int i = 0; i < count; i++)
+  {
+    const Eigen::Vector3d axis = first * rotationZ(middle[i]) * second.col(2);
+    double theta_first = hint;
+    if (std::hypot(axis.x(), axis.y()) > 1e-9 && std::hypot(last_axis.x(), last_axis.y()) > 1e-9)
+    {
+      theta_first = std::atan2(last_axis.y(), last_axis.x()) - std::atan2(axis.y(), axis.x());
+    }
+    const Eigen::Matrix3d remaining =
+      (rotationZ(theta_first) * first * rotationZ(middle[i]) * second).transpose() * rotation;
+    theta[i] = Eigen::Vector3d(
+      wrapAngle(theta_first), middle[i], std::atan2(remaining(1, 0), remaining(0, 0)));
+  }
+  return count;
+}
+
+double wrapAngle(double angle) { return std::remainder(angle, 2.0 * M_PI); }
+
+Eigen::Vector3d closestPoint(
+  const Eigen::Vector3d & point, const Eigen::Vector3d & direction,
+  const Eigen::Vector3d & other_point, const Eigen::Vector3d & other_direction)
+{
+  const Eigen::Vector3d offset = point - other_point;
+  const double b = direction.dot(other_direction);
+  const double denominator = 1.0 - b * b;
+  if (denominator < 1e-12)
+  {
+    return point;
+  }
+  const double d = direction.dot(offset);
+  const double e = other_direction.dot(offset);
+  return point + direction * ((b * e - d) / denominator);
+}
+
+double distanceToLine(
+  const Eigen::Vector3d & point, const Eigen::Vector3d & line_point,
+  const Eigen::Vector3d & line_direction)
+{
+  return (point - line_point).cross(line_direction).norm();
+}
+
+}  // namespace kortex_kinematics
@@ -0,0 +1,123 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+
+#include <Eigen/LU>
+
+#include "kortex_kinematics/kinematic_chain.hpp"
+
+namespace kortex_kinematics
+{
+namespace
+{
+Eigen::Isometry3d jointTransform(const Eigen::Isometry3d & origin, double q)
+{
+  // origin * Rz(q), only the first two columns of the rotation change
+  Eigen::Isometry3d transform = origin;
+  const double c = std::cos(q);
+  const double s = std::sin(q);
+  transform.linear().col(0) = c * origin.linear().col(0) + s * origin.linear().col(1);
+  transform.linear().col(1) = c * origin.linear().col(1) - s * origin.linear().col(0);
+  return transform;
+}
+}  // namespace
+
+Eigen::Vector3d rotationError(const Eigen::Matrix3d & target, const Eigen::Matrix3d & current)
+{
+  const Eigen::AngleAxisd error(target * current.transpose());
+  return error.angle() * error.axis();
+}
+
+void KinematicChain::setJoints(
+  const std::vector<Eigen::Isometry3d> & origins, const Eigen::Isometry3d & tool)
+{
+  joint_count_ = static_cast<int>(std::min<std::size_t>(origins.size(), MAX_JOINTS));
+  std::copy(origins.begin(), origins.begin() + joint_count_, origins_.begin());
+  tool_ = tool;
+}
+
+Eigen::Isometry3d KinematicChain::forward(const JointVector & q) const
+{
+  Eigen::Isometry3d frame = Eigen::Isometry3d::Identity();
+  for (int i = 0; i < joint_count_; i++)
+  {
+    frame = frame * jointTransform(origins_[i], q[i]);
+  }
+  return frame * tool_;
+}
+
+Eigen::Isometry3d KinematicChain::forward(
+  const JointVector & q, std::array<Eigen::Isometry3d, MAX_JOINTS> & joint_frames) const
+{
+  Eigen::Isometry3d frame = Eigen::Isometry3d::Identity();
+  for (int i = 0; i < joint_count_; i++)
+  {
+    frame = frame * jointTransform(origins_[i], q[i]);
+    joint_frames[i] = frame;
+  }
+  return frame * tool_;
+}
+
+void KinematicChain::jacobian(const JointVector & q, Jacobian & jacobian) const
+{
+  std::array<Eigen::Isometry3d, MAX_JOINTS> frames;
+  const Eigen::Vector3d tip = forward(q, frames).translation();
+  jacobian.resize(6, joint_count_);
+  for (int i = 0; i < joint_count_; i++)
+  {
+    const Eigen::Vector3d axis = frames[i].linear().col(2);
+    jacobian.block<3, 1>(0, i) = axis.cross(tip - frames[i].translation());
+    jacobian.block<3, 1>(3, i) = axis;
+  }
+}
+
+Eigen::Matrix<double, 6, 1> KinematicChain::error(
+  const Eigen::Isometry3d & target, const JointVector & q) const
+{
+  const Eigen::Isometry3d tip = forward(q);
+  Eigen::Matrix<double, 6, 1> error;
+  error.head<3>() = target.translation() - tip.translation();
+  error.tail<3>() = rotationError(target.linear(), tip.linear());
+  return error;
+}
+
+bool KinematicChain::refine(
+  const Eigen::Isometry3d & target, JointVector & q, double tolerance, int max_iterations) const
+{
+  Jacobian square;
+  for (int iteration = 0; iteration <= max_iterations; iteration++)
+  {
+    const Eigen::Matrix<double, 6, 1> residual = error(target, q);
+    if (residual.head<3>().norm() < tolerance && residual.tail<3>().norm() < tolerance)
+    {
+      return true;
+    }
+    if (iteration == max_iterations || joint_count_ != 6)
+    {
+      break;
+    }
+    jacobian(q, square);
+    const Eigen::FullPivLU<Eigen::Matrix<double, 6, 6>> lu(square.leftCols<6>());
+    if (!lu.isInvertible())
+    {
+      return false;
+    }
+    q += lu.solve(residual);
+  }
+  return false;
+}
+
+}  // namespace kortex_kinematics
@@ -0,0 +1,209 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// Compares IK plugins over random reachable poses, each solved from an unrelated random seed:
+//   ros2 run kortex_kinematics kinematics_benchmark robot.urdf robot.srdf group [samples] [timeout]
+// The URDF is the expanded xacro of the arm, for instance
+//   xacro kortex_description/robots/gen3_lite_gen3_lite_2f.xacro > gen3_lite.urdf
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <moveit/kinematics_base/kinematics_base.h>
+#include <moveit/robot_model/robot_model.h>
+#include <moveit/robot_state/robot_state.h>
+#include <pluginlib/class_loader.hpp>
+#include <rclcpp/rclcpp.hpp>
+#include <srdfdom/model.h>
+#include <tf2_eigen/tf2_eigen.hpp>
+#include <urdf/model.h>
+
+namespace
+{
+const rclcpp::Logger LOGGER = rclcpp::get_logger("kinematics_benchmark");
+
+const std::vector<std::string> PLUGINS = {
+  "kdl_kinematics_plugin/KDLKinematicsPlugin",
+  "kortex_kinematics/KortexKinematicsPlugin",
+};
+constexpr double SEARCH_DISCRETIZATION = 0.005;
+// a solution further than this from the pose does not count
+constexpr double POSITION_TOLERANCE = 1e-5;
+constexpr double ORIENTATION_TOLERANCE = 1e-4;
+
+struct Sample
+{
+  geometry_msgs::msg::Pose pose;
+  std::vector<double> seed;
+};
+
+bool readFile(const std::string & path, std::string & content)
+{
+  std::ifstream file(path);
+  if (!file)
+  {
+    return false;
+  }
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  content = buffer.str();
+  return true;
+}
+
+double percentile(std::vector<double> values, double fraction)
+{
+  if (values.empty())
+  {
+    return 0.0;
+  }
+  const std::size_t index = std::min(
+    values.size() - 1, static_cast<std::size_t>(fraction * static_cast<double>(values.size())));
+  std::nth_element(values.begin(), values.begin() + index, values.end());
+  return values[index];
+}
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  rclcpp::init(argc, argv);
+  const std::vector<std::string> args = rclcpp::remove_ros_arguments(argc, argv);
+  if (args.size() < 4)
+  {
+    std::fprintf(
+      stderr, "usage: %s robot.urdf robot.srdf group [samples] [timeout]\n", args[0].c_str());
+    return 1;
+  }
+  const std::size_t sample_count = args.size() > 4 ? std::stoul(args[4]) : 10000;
+  const double timeout = args.size() > 5 ? std::stod(args[5]) : 0.005;
+
+  std::string urdf_xml;
+  std::string srdf_xml;
+  if (!readFile(args[1], urdf_xml) || !readFile(args[2], srdf_xml))
+  {
+    RCLCPP_ERROR(LOGGER, "Cannot read '%s' or '%s'", args[1].c_str(), args[2].c_str());
+    return 1;
+  }
+  auto urdf_model = std::make_shared<urdf::Model>();
+  auto srdf_model = std::make_shared<srdf::Model>();
+  if (!urdf_model->initString(urdf_xml) || !srdf_model->initString(*urdf_model, srdf_xml))
+  {
+    RCLCPP_ERROR(LOGGER, "Cannot parse the robot description");
+    return 1;
+  }
+  const auto robot_model = std::make_shared<moveit::core::RobotModel>(urdf_model, srdf_model);
+  const moveit::core::JointModelGroup * group = robot_model->getJointModelGroup(args[3]);
+  if (group == nullptr)
+  {
+    RCLCPP_ERROR(LOGGER, "No group '%s'", args[3].c_str());
+    return 1;
+  }
+  const std::string base_frame = group->getJointModels().front()->getParentLinkModel()->getName();
+  const std::string tip_frame = group->getLinkModelNames().back();
+
+  // the same poses and seeds for every plugin
+  moveit::core::RobotState state(robot_model);
+  std::vector<Sample> samples(sample_count);
+  for (Sample & sample : samples)
+  {
+    state.setToRandomPositions(group);
+    state.update();
+    sample.pose = tf2::toMsg(
+      state.getGlobalLinkTransform(base_frame).inverse() * state.getGlobalLinkTransform(tip_frame));
+    state.setToRandomPositions(group);
+    state.copyJointGroupPositions(group, sample.seed);
+  }
+
+  const auto node = std::make_shared<rclcpp::Node>("kinematics_benchmark");
+  pluginlib::ClassLoader<kinematics::KinematicsBase> loader(
+    "moveit_core", "kinematics::KinematicsBase");
+  std::printf(
+    "%zu poses of '%s' from '%s' to '%s', %.1f ms timeout\n", samples.size(), args[3].c_str(),
+    base_frame.c_str(), tip_frame.c_str(), timeout * 1e3);
+  std::printf(
+    "%-45s %9s %10s %10s %10s\n", "plugin", "solved", "mean (us)", "p50 (us)", "p99 (us)");
+  for (const std::string & name : PLUGINS)
+  {
+    std::shared_ptr<kinematics::KinematicsBase> solver;
+    try
+    {
+      solver = loader.createSharedInstance(name);
+    }
+    catch (const pluginlib::PluginlibException & e)
+    {
+      RCLCPP_ERROR(LOGGER, "Cannot load %s: %s", name.c_str(), e.what());
+      continue;
+    }
+    if (!solver->initialize(
+          node, *robot_model, args[3], base_frame, {tip_frame}, SEARCH_DISCRETIZATION))
+    {
+      RCLCPP_ERROR(LOGGER, "Cannot initialize %s", name.c_str());
+      continue;
+    }
+
+    std::size_t solved = 0;
+    std::vector<double> latencies;
+    latencies.reserve(samples.size());
+    std::vector<double> solution;
+    for (const Sample & sample : samples)
+    {
+      moveit_msgs::msg::MoveItErrorCodes error_code;
+      const auto start = std::chrono::steady_clock::now();
+      const bool success =
+        solver->searchPositionIK(sample.pose, sample.seed, timeout, solution, error_code);
+      latencies.push_back(
+        std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start)
+          .count());
+      if (!success)
+      {
+        continue;
+      }
+
+      // checked with the robot model, not with the forward kinematics of the plugin
+      state.setJointGroupPositions(group, solution);
+      state.update();
+      const Eigen::Isometry3d reached = state.getGlobalLinkTransform(base_frame).inverse() *
+                                        state.getGlobalLinkTransform(tip_frame);
+      Eigen::Isometry3d target;
+      tf2::fromMsg(sample.pose, target);
+      if (
+        (reached.translation() - target.translation()).norm() < POSITION_TOLERANCE &&
+        Eigen::AngleAxisd(reached.linear().transpose() * target.linear()).angle() <
+          ORIENTATION_TOLERANCE)
+      {
+        solved++;
+      }
+    }
+
+    double total = 0.0;
+    for (double latency : latencies)
+    {
+      total += latency;
+    }
+    std::printf(
+      "%-45s %8.2f%% %10.1f %10.1f %10.1f\n", name.c_str(),
+      100.0 * static_cast<double>(solved) / static_cast<double>(samples.size()),
+      total / static_cast<double>(latencies.size()), percentile(latencies, 0.5),
+      percentile(latencies, 0.99));
+  }
+
+  rclcpp::shutdown();
+  return 0;
+}
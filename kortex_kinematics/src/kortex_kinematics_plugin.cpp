@@ -0,0 +1,391 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+
+#include <moveit/robot_model/revolute_joint_model.h>
+#include <moveit/robot_state/robot_state.h>
+#include <pluginlib/class_list_macros.hpp>
+#include <tf2_eigen/tf2_eigen.hpp>
+
+#include "kortex_kinematics/kortex_kinematics_plugin.hpp"
+
+namespace kortex_kinematics
+{
+namespace
+{
+const rclcpp::Logger LOGGER = rclcpp::get_logger("KortexKinematicsPlugin");
+
+constexpr double DEFAULT_SEARCH_DISCRETIZATION = 0.01;
+
+const kinematics::KinematicsBase::IKCallbackFn NO_CALLBACK;
+const std::vector<double> NO_CONSISTENCY_LIMITS;
+
+KinematicChain::JointVector toJointVector(const std::vector<double> & values)
+{
+  return Eigen::Map<const Eigen::VectorXd>(values.data(), static_cast<Eigen::Index>(values.size()));
+}
+}  // namespace
+
+bool KortexKinematicsPlugin::initialize(
+  const rclcpp::Node::SharedPtr & node, const moveit::core::RobotModel & robot_model,
+  const std::string & group_name, const std::string & base_frame,
+  const std::vector<std::string> & tip_frames, double search_discretization)
+{
+  node_ = node;
+  storeValues(robot_model, group_name, base_frame, tip_frames, search_discretization);
+
+  const moveit::core::JointModelGroup * group = robot_model_->getJointModelGroup(group_name);
+  if (group == nullptr || !group->isChain() || tip_frames_.size() != 1)
+  {
+    RCLCPP_ERROR(LOGGER, "Group '%s' is not a chain with a single tip", group_name.c_str());
+    return false;
+  }
+
+  // joint frames at zero position, each rotated so that its axis is z
+  moveit::core::RobotState state(robot_model_);
+  std::vector<double> zero(robot_model_->getVariableCount(), 0.0);
+  state.setVariablePositions(zero);
+  state.update();
+
+  const Eigen::Isometry3d base = state.getFrameTransform(base_frame_);
+  Eigen::Isometry3d previous = base;
+  std::vector<Eigen::Isometry3d> origins;
+  joint_names_.clear();
+  position_bounded_.clear();
+  min_positions_.clear();
+  max_positions_.clear();
+  link_names_.clear();
+  link_joints_.clear();
+  link_offsets_.clear();
+  for (const moveit::core::JointModel * joint : group->getActiveJointModels())
+  {
+    if (joint->getType() != moveit::core::JointModel::REVOLUTE)
+    {
+      RCLCPP_ERROR(LOGGER, "Joint '%s' is not revolute", joint->getName().c_str());
+      return false;
+    }
+    const Eigen::Vector3d & axis =
+      static_cast<const moveit::core::RevoluteJointModel *>(joint)->getAxis();
+    const Eigen::Isometry3d alignment(
+      Eigen::Quaterniond::FromTwoVectors(Eigen::Vector3d::UnitZ(), axis));
+    const Eigen::Isometry3d frame =
+      state.getGlobalLinkTransform(joint->getChildLinkModel()) * alignment;
+    origins.push_back(previous.inverse() * frame);
+    previous = frame;
+
+    const moveit::core::VariableBounds & bounds = joint->getVariableBounds()[0];
+    joint_names_.push_back(joint->getName());
+    position_bounded_.push_back(bounds.position_bounded_);
+    min_positions_.push_back(bounds.min_position_);
+    max_positions_.push_back(bounds.max_position_);
+    link_names_.push_back(joint->getChildLinkModel()->getName());
+    link_joints_.push_back(static_cast<int>(origins.size()) - 1);
+    link_offsets_.push_back(alignment.inverse());
+  }
+  if (origins.size() != 6 && origins.size() != 7)
+  {
+    RCLCPP_ERROR(
+      LOGGER, "Group '%s' has %zu joints, expected 6 or 7", group_name.c_str(), origins.size());
+    return false;
+  }
+  const Eigen::Isometry3d tool = previous.inverse() * state.getFrameTransform(tip_frames_[0]);
+  if (link_names_.back() != tip_frames_[0])
+  {
+    link_names_.push_back(tip_frames_[0]);
+    link_joints_.push_back(static_cast<int>(origins.size()) - 1);
+    link_offsets_.push_back(tool);
+  }
+
+  chain_.setJoints(origins, tool);
+  if (chain_.size() == 7 && !seven_dof_solver_.configure(chain_))
+  {
+    RCLCPP_ERROR(
+      LOGGER, "Group '%s' does not have a spherical shoulder and wrist", group_name.c_str());
+    return false;
+  }
+  if (chain_.size() == 6 && !six_dof_solver_.configure(chain_))
+  {
+    RCLCPP_ERROR(
+      LOGGER, "Group '%s' does not have a planar elbow and a wrist center", group_name.c_str());
+    return false;
+  }
+  if (search_discretization_ <= 0.0)
+  {
+    search_discretization_ = DEFAULT_SEARCH_DISCRETIZATION;
+  }
+  RCLCPP_INFO(
+    LOGGER, "Closed-form IK for '%s' from '%s' to '%s', swivel resolution %f rad",
+    group_name.c_str(), base_frame_.c_str(), tip_frames_[0].c_str(), search_discretization_);
+  return true;
+}
+
+bool KortexKinematicsPlugin::getPositionIK(
+  const geometry_msgs::msg::Pose & ik_pose, const std::vector<double> & ik_seed_state,
+  std::vector<double> & solution, moveit_msgs::msg::MoveItErrorCodes & error_code,
+  const kinematics::KinematicsQueryOptions & options) const
+{
+  return searchPositionIK(
+    ik_pose, ik_seed_state, default_timeout_, NO_CONSISTENCY_LIMITS, solution, NO_CALLBACK,
+    error_code, options);
+}
+
+bool KortexKinematicsPlugin::getPositionIK(
+  const std::vector<geometry_msgs::msg::Pose> & ik_poses,
+  const std::vector<double> & ik_seed_state, std::vector<std::vector<double>> & solutions,
+  kinematics::KinematicsResult & result, const kinematics::KinematicsQueryOptions & /*options*/)
+  const
+{
+  solutions.clear();
+  result.solution_percentage = 0.0;
+  if (ik_poses.empty())
+  {
+    result.kinematic_error = kinematics::KinematicErrors::EMPTY_TIP_POSES;
+    return false;
+  }
+  if (ik_poses.size() != 1)
+  {
+    result.kinematic_error = kinematics::KinematicErrors::MULTIPLE_TIPS_NOT_SUPPORTED;
+    return false;
+  }
+  if (ik_seed_state.size() != joint_names_.size())
+  {
+    result.kinematic_error = kinematics::KinematicErrors::NO_SOLUTION;
+    return false;
+  }
+
+  Eigen::Isometry3d tip;
+  tf2::fromMsg(ik_poses[0], tip);
+  const KinematicChain::JointVector seed = toJointVector(ik_seed_state);
+  const double swivel = chain_.size() == 7 ? seven_dof_solver_.swivel(seed) : 0.0;
+  KinematicChain::Solutions branches;
+  const int count = approximate(tip, swivel, branches);
+  for (int i = 0; i < count; i++)
+  {
+    if (refine(tip, swivel, branches[i]) && fitToLimits(seed, NO_CONSISTENCY_LIMITS, branches[i]))
+    {
+      solutions.emplace_back(branches[i].data(), branches[i].data() + branches[i].size());
+    }
+  }
+  if (solutions.empty())
+  {
+    result.kinematic_error = kinematics::KinematicErrors::NO_SOLUTION;
+    return false;
+  }
+  result.kinematic_error = kinematics::KinematicErrors::OK;
+  result.solution_percentage = 1.0;
+  return true;
+}
+
+bool KortexKinematicsPlugin::searchPositionIK(
+  const geometry_msgs::msg::Pose & ik_pose, const std::vector<double> & ik_seed_state,
+  double timeout, std::vector<double> & solution, moveit_msgs::msg::MoveItErrorCodes & error_code,
+  const kinematics::KinematicsQueryOptions & options) const
+{
+  return searchPositionIK(
+    ik_pose, ik_seed_state, timeout, NO_CONSISTENCY_LIMITS, solution, NO_CALLBACK, error_code,
+    options);
+}
+
+bool KortexKinematicsPlugin::searchPositionIK(
+  const geometry_msgs::msg::Pose & ik_pose, const std::vector<double> & ik_seed_state,
+  double timeout, const std::vector<double> & consistency_limits, std::vector<double> & solution,
+  moveit_msgs::msg::MoveItErrorCodes & error_code,
+  const kinematics::KinematicsQueryOptions & options) const
+{
+  return searchPositionIK(
+    ik_pose, ik_seed_state, timeout, consistency_limits, solution, NO_CALLBACK, error_code,
+    options);
+}
+
+bool KortexKinematicsPlugin::searchPositionIK(
+  const geometry_msgs::msg::Pose & ik_pose, const std::vector<double> & ik_seed_state,
+  double timeout, std::vector<double> & solution, const IKCallbackFn & solution_callback,
+  moveit_msgs::msg::MoveItErrorCodes & error_code,
+  const kinematics::KinematicsQueryOptions & options) const
+{
+  return searchPositionIK(
+    ik_pose, ik_seed_state, timeout, NO_CONSISTENCY_LIMITS, solution, solution_callback,
+    error_code, options);
+}
+
+bool KortexKinematicsPlugin::searchPositionIK(
+  const geometry_msgs::msg::Pose & ik_pose, const std::vector<double> & ik_seed_state,
+  double timeout, const std::vector<double> & consistency_limits, std::vector<double> & solution,
+  const IKCallbackFn & solution_callback, moveit_msgs::msg::MoveItErrorCodes & error_code,
+  const kinematics::KinematicsQueryOptions & /*options*/) const
+{
+  const auto start = std::chrono::steady_clock::now();
+  if (
+    ik_seed_state.size() != joint_names_.size() ||
+    (!consistency_limits.empty() && consistency_limits.size() != joint_names_.size()))
+  {
+    RCLCPP_ERROR(
+      LOGGER, "Expected %zu seed values and consistency limits, got %zu and %zu",
+      joint_names_.size(), ik_seed_state.size(), consistency_limits.size());
+    error_code.val = moveit_msgs::msg::MoveItErrorCodes::NO_IK_SOLUTION;
+    return false;
+  }
+
+  Eigen::Isometry3d tip;
+  tf2::fromMsg(ik_pose, tip);
+  const KinematicChain::JointVector seed = toJointVector(ik_seed_state);
+  const bool redundant = chain_.size() == 7;
+  const double seed_swivel = redundant ? seven_dof_solver_.swivel(seed) : 0.0;
+
+  // 0, +1, -1, +2, -2, ... steps from the swivel of the seed, once around the circle
+  const int steps = redundant ? static_cast<int>(std::ceil(M_PI / search_discretization_)) : 0;
+  for (int i = 0; i <= 2 * steps; i++)
+  {
+    const int step = i % 2 == 1 ? (i + 1) / 2 : -(i / 2);
+    if (
+      i > 0 &&
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() > timeout)
+    {
+      error_code.val = moveit_msgs::msg::MoveItErrorCodes::TIMED_OUT;
+      return false;
+    }
+    if (solveAtSwivel(
+          ik_pose, tip, seed_swivel + step * search_discretization_, seed, consistency_limits,
+          solution, solution_callback, error_code))
+    {
+      return true;
+    }
+  }
+  error_code.val = moveit_msgs::msg::MoveItErrorCodes::NO_IK_SOLUTION;
+  return false;
+}
+
+bool KortexKinematicsPlugin::getPositionFK(
+  const std::vector<std::string> & link_names, const std::vector<double> & joint_angles,
+  std::vector<geometry_msgs::msg::Pose> & poses) const
+{
+  if (joint_angles.size() != joint_names_.size())
+  {
+    RCLCPP_ERROR(
+      LOGGER, "Expected %zu joint values, got %zu", joint_names_.size(), joint_angles.size());
+    return false;
+  }
+
+  std::array<Eigen::Isometry3d, KinematicChain::MAX_JOINTS> frames;
+  chain_.forward(toJointVector(joint_angles), frames);
+  poses.resize(link_names.size());
+  for (std::size_t i = 0; i < link_names.size(); i++)
+  {
+    const auto link = std::find(link_names_.begin(), link_names_.end(), link_names[i]);
+    if (link == link_names_.end())
+    {
+      RCLCPP_ERROR(LOGGER, "Link '%s' is not in the chain", link_names[i].c_str());
+      return false;
+    }
+    const std::size_t index = static_cast<std::size_t>(link - link_names_.begin());
+    poses[i] = tf2::toMsg(frames[link_joints_[index]] * link_offsets_[index]);
+  }
+  return true;
+}
+
+int KortexKinematicsPlugin::approximate(
+  const Eigen::Isometry3d & tip, double swivel, KinematicChain::Solutions & solutions) const
+{
+  return chain_.size() == 7 ? seven_dof_solver_.approximate(tip, swivel, solutions)
+                            : six_dof_solver_.approximate(tip, solutions);
+}
+
+bool KortexKinematicsPlugin::refine(
+  const Eigen::Isometry3d & tip, double swivel, KinematicChain::JointVector & q) const
+{
+  return chain_.size() == 7 ? seven_dof_solver_.refine(tip, swivel, q)
+                            : six_dof_solver_.refine(tip, q);
+}
+
+bool KortexKinematicsPlugin::solveAtSwivel(
+  const geometry_msgs::msg::Pose & ik_pose, const Eigen::Isometry3d & tip, double swivel,
+  const KinematicChain::JointVector & seed, const std::vector<double> & consistency_limits,
+  std::vector<double> & solution, const IKCallbackFn & solution_callback,
+  moveit_msgs::msg::MoveItErrorCodes & error_code) const
+{
+  // the closed form is close enough to rank the branches, only the tried ones are refined
+  KinematicChain::Solutions branches;
+  const int count = approximate(tip, swivel, branches);
+  std::array<double, KinematicChain::MAX_SOLUTIONS> distances;
+  std::array<int, KinematicChain::MAX_SOLUTIONS> order;
+  for (int i = 0; i < count; i++)
+  {
+    fitToLimits(seed, NO_CONSISTENCY_LIMITS, branches[i]);
+    distances[i] = (branches[i] - seed).squaredNorm();
+    order[i] = i;
+  }
+  std::sort(
+    order.begin(), order.begin() + count,
+    [&distances](int a, int b) { return distances[a] < distances[b]; });
+
+  for (int i = 0; i < count; i++)
+  {
+    KinematicChain::JointVector & q = branches[order[i]];
+    if (!refine(tip, swivel, q) || !fitToLimits(seed, consistency_limits, q))
+    {
+      continue;
+    }
+    solution.assign(q.data(), q.data() + q.size());
+    error_code.val = moveit_msgs::msg::MoveItErrorCodes::SUCCESS;
+    if (solution_callback)
+    {
+      solution_callback(ik_pose, solution, error_code);
+    }
+    if (error_code.val == moveit_msgs::msg::MoveItErrorCodes::SUCCESS)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool KortexKinematicsPlugin::fitToLimits(
+  const KinematicChain::JointVector & seed, const std::vector<double> & consistency_limits,
+  KinematicChain::JointVector & q) const
+{
+  bool valid = true;
+  for (int i = 0; i < q.size(); i++)
+  {
+    const std::size_t joint = static_cast<std::size_t>(i);
+    q[i] += 2.0 * M_PI * std::round((seed[i] - q[i]) / (2.0 * M_PI));
+    if (position_bounded_[joint])
+    {
+      // the closest turn may be out of bounds when another one is not
+      if (q[i] > max_positions_[joint])
+      {
+        q[i] -= 2.0 * M_PI;
+      }
+      else if (q[i] < min_positions_[joint])
+      {
+        q[i] += 2.0 * M_PI;
+      }
+      valid &= q[i] >= min_positions_[joint] && q[i] <= max_positions_[joint];
+    }
+    if (!consistency_limits.empty())
+    {
+      valid &= std::abs(q[i] - seed[i]) <= consistency_limits[joint];
+    }
+  }
+  return valid;
+}
+
+}  // namespace kortex_kinematics
+
+PLUGINLIB_EXPORT_CLASS(kortex_kinematics::KortexKinematicsPlugin, kinematics::KinematicsBase)
@@ -0,0 +1,257 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+
+#include <Eigen/LU>
+
+#include "kortex_kinematics/closed_form.hpp"
+#include "kortex_kinematics/seven_dof_solver.hpp"
+
+namespace kortex_kinematics
+{
+namespace
+{
+constexpr int JOINTS = 7;
+// a joint offset larger than this is not an S-R-S arm anymore
+constexpr double MAX_AXIS_OFFSET = 0.02;
+constexpr int REFINE_ITERATIONS = 8;
+}  // namespace
+
+bool SevenDofSolver::configure(const KinematicChain & chain)
+{
+  if (chain.size() != JOINTS)
+  {
+    return false;
+  }
+  chain_ = chain;
+
+  std::array<Eigen::Isometry3d, KinematicChain::MAX_JOINTS> frames;
+  const Eigen::Isometry3d tip = chain_.forward(KinematicChain::JointVector::Zero(JOINTS), frames);
+  const auto axis = [&frames](int joint) { return Eigen::Vector3d(frames[joint].linear().col(2)); };
+  const auto point = [&frames](int joint) { return Eigen::Vector3d(frames[joint].translation()); };
+
+  // shoulder on the first two axes, elbow on the fourth, wrist center on the last three
+  shoulder_ = closestPoint(point(1), axis(1), point(0), axis(0));
+  const Eigen::Vector3d elbow = closestPoint(point(3), axis(3), point(2), axis(2));
+  const Eigen::Vector3d wrist = closestPoint(point(5), axis(5), point(4), axis(4));
+  if (
+    distanceToLine(shoulder_, point(0), axis(0)) > MAX_AXIS_OFFSET ||
+    distanceToLine(shoulder_, point(2), axis(2)) > MAX_AXIS_OFFSET ||
+    distanceToLine(elbow, point(4), axis(4)) > MAX_AXIS_OFFSET ||
+    distanceToLine(wrist, point(6), axis(6)) > MAX_AXIS_OFFSET)
+  {
+    return false;
+  }
+
+  upper_arm_ = (elbow - shoulder_).norm();
+  forearm_ = (wrist - elbow).norm();
+  if (upper_arm_ < MAX_AXIS_OFFSET || forearm_ < MAX_AXIS_OFFSET)
+  {
+    return false;
+  }
+  upper_arm_sign_ = axis(2).dot(elbow - shoulder_) >= 0.0 ? 1.0 : -1.0;
+  forearm_sign_ = axis(4).dot(wrist - elbow) >= 0.0 ? 1.0 : -1.0;
+  elbow_in_joint_ = frames[3].inverse() * elbow;
+  wrist_in_tip_ = tip.inverse() * wrist;
+  return true;
+}
+
+void SevenDofSolver::swivelPlane(
+  const Eigen::Vector3d & direction, Eigen::Vector3d & reference, Eigen::Vector3d & normal) const
+{
+  reference = Eigen::Vector3d::UnitZ() - direction.z() * direction;
+  if (reference.norm() < 1e-6)
+  {
+    // wrist straight above or below the shoulder, any horizontal reference does
+    reference = Eigen::Vector3d::UnitX() - direction.x() * direction;
+  }
+  reference.normalize();
+  normal = direction.cross(reference);
+}
+
+int SevenDofSolver::solve(
+  const Eigen::Isometry3d & tip, double swivel, Solutions & solutions, double tolerance) const
+{
+  const int approximate_count = approximate(tip, swivel, solutions);
+  int count = 0;
+  for (int i = 0; i < approximate_count; i++)
+  {
+    if (refine(tip, swivel, solutions[i], tolerance))
+    {
+      solutions[count++] = solutions[i];
+    }
+  }
+  return count;
+}
+
+int SevenDofSolver::approximate(
+  const Eigen::Isometry3d & tip, double swivel, Solutions & solutions) const
+{
+  const Eigen::Vector3d wrist = tip * wrist_in_tip_;
+  const Eigen::Vector3d shoulder_to_wrist = wrist - shoulder_;
+  const double reach = shoulder_to_wrist.norm();
+  if (reach < 1e-9 || reach > upper_arm_ + forearm_ + 1e-9)
+  {
+    return 0;
+  }
+  const Eigen::Vector3d direction = shoulder_to_wrist / reach;
+
+  // elbow on its circle around the shoulder to wrist line, at the swivel angle
+  const double cos_shoulder = std::min(
+    1.0, std::max(
+           -1.0, (upper_arm_ * upper_arm_ + reach * reach - forearm_ * forearm_) /
+                   (2.0 * upper_arm_ * reach)));
+  Eigen::Vector3d reference;
+  Eigen::Vector3d normal;
+  swivelPlane(direction, reference, normal);
+  const Eigen::Vector3d elbow =
+    shoulder_ + upper_arm_ * (cos_shoulder * direction +
+                              std::sqrt(1.0 - cos_shoulder * cos_shoulder) *
+                                (std::cos(swivel) * reference + std::sin(swivel) * normal));
+  const Eigen::Vector3d upper_arm = (elbow - shoulder_) / upper_arm_;
+  const Eigen::Vector3d forearm = (wrist - elbow) / forearm_;
+
+  // fourth joint from the angle between the upper arm and the forearm, in the third joint frame
+  const Eigen::Matrix3d & elbow_origin = chain_.origin(3).linear();
+  const Eigen::Matrix3d & wrist_origin = chain_.origin(4).linear();
+  double a = 0.0;
+  double b = 0.0;
+  double c = 0.0;
+  cosineSineCoefficients(
+    elbow_origin.transpose().col(2), wrist_origin.col(2), a, b, c);
+  const double sign = upper_arm_sign_ * forearm_sign_;
+  std::array<double, 2> elbow_angles;
+  const int elbow_count = solveCosineSine(a, b, sign * upper_arm.dot(forearm) - c, elbow_angles);
+
+  const Eigen::Matrix3d tip_in_last = chain_.tool().linear();
+  const Eigen::Matrix3d last_frame = tip.linear() * tip_in_last.transpose();
+  int count = 0;
+  for (int e = 0; e < elbow_count; e++)
+  {
+    const double q4 = elbow_angles[e];
+    // third joint frame maps its z axis to the upper arm and the forearm direction it sees
+    const Eigen::Vector3d forearm_in_joint =
+      forearm_sign_ * (elbow_origin * Eigen::AngleAxisd(q4, Eigen::Vector3d::UnitZ()) *
+                       wrist_origin.col(2));
+    const Eigen::Vector3d upper_arm_in_joint = upper_arm_sign_ * Eigen::Vector3d::UnitZ();
+    Eigen::Vector3d in_joint = forearm_in_joint - forearm_in_joint.dot(upper_arm_in_joint) *
+                                                    upper_arm_in_joint;
+    Eigen::Vector3d in_base = forearm - forearm.dot(upper_arm) * upper_arm;
+    if (in_joint.norm() < 1e-9 || in_base.norm() < 1e-9)
+    {
+      // stretched elbow, the swivel plane sets the rest of the frame
+      in_joint = Eigen::Vector3d::UnitX();
+      in_base = std::cos(swivel) * normal - std::sin(swivel) * reference;
+    }
+    in_joint.normalize();
+    in_base.normalize();
+    Eigen::Matrix3d joint_basis;
+    joint_basis << upper_arm_in_joint, in_joint, upper_arm_in_joint.cross(in_joint);
+    Eigen::Matrix3d base_basis;
+    base_basis << upper_arm, in_base, upper_arm.cross(in_base);
+    const Eigen::Matrix3d third_frame = base_basis * joint_basis.transpose();
+
+    // both shoulders give the same third joint frame, and so the same wrist
+    std::array<Eigen::Vector3d, 2> shoulder_angles;
+    const int shoulder_count = decomposeRotation(
+      chain_.origin(0).linear().transpose() * third_frame, chain_.origin(1).linear(),
+      chain_.origin(2).linear(), 0.0, shoulder_angles);
+    const Eigen::Matrix3d fourth_frame =
+      third_frame * elbow_origin * Eigen::AngleAxisd(q4, Eigen::Vector3d::UnitZ());
+    std::array<Eigen::Vector3d, 2> wrist_angles;
+    const int wrist_count = decomposeRotation(
+      (fourth_frame * wrist_origin).transpose() * last_frame, chain_.origin(5).linear(),
+      chain_.origin(6).linear(), 0.0, wrist_angles);
+    for (int s = 0; s < shoulder_count; s++)
+    {
+      for (int w = 0; w < wrist_count; w++)
+      {
+        KinematicChain::JointVector & q = solutions[count++];
+        q.resize(JOINTS);
+        q << shoulder_angles[s], q4, wrist_angles[w];
+      }
+    }
+  }
+  return count;
+}
+
+bool SevenDofSolver::refine(
+  const Eigen::Isometry3d & tip, double swivel, KinematicChain::JointVector & q,
+  double tolerance) const
+{
+  const Eigen::Vector3d direction = (tip * wrist_in_tip_ - shoulder_).normalized();
+  Eigen::Vector3d reference;
+  Eigen::Vector3d normal;
+  swivelPlane(direction, reference, normal);
+
+  std::array<Eigen::Isometry3d, KinematicChain::MAX_JOINTS> frames;
+  Eigen::Matrix<double, 7, 7> jacobian;
+  Eigen::Matrix<double, 7, 1> residual;
+  for (int iteration = 0; iteration <= REFINE_ITERATIONS; iteration++)
+  {
+    const Eigen::Isometry3d current = chain_.forward(q, frames);
+    residual.head<3>() = tip.translation() - current.translation();
+    residual.segment<3>(3) = rotationError(tip.linear(), current.linear());
+    // the swivel of the elbow around the line to the target wrist center, it only depends on the
+    // first joints once the tip is on target
+    const Eigen::Vector3d elbow = frames[3] * elbow_in_joint_;
+    const Eigen::Vector3d arm = elbow - shoulder_;
+    const double x = reference.dot(arm);
+    const double y = normal.dot(arm);
+    residual[6] = wrapAngle(swivel - std::atan2(y, x));
+    if (
+      residual.head<3>().norm() < tolerance && residual.segment<3>(3).norm() < tolerance &&
+      std::abs(residual[6]) < tolerance)
+    {
+      for (int i = 0; i < JOINTS; i++)
+      {
+        q[i] = wrapAngle(q[i]);
+      }
+      return true;
+    }
+    if (iteration == REFINE_ITERATIONS || x * x + y * y < 1e-12)
+    {
+      break;
+    }
+
+    const Eigen::Vector3d swivel_gradient = (x * normal - y * reference) / (x * x + y * y);
+    for (int i = 0; i < JOINTS; i++)
+    {
+      const Eigen::Vector3d axis = frames[i].linear().col(2);
+      jacobian.block<3, 1>(0, i) = axis.cross(current.translation() - frames[i].translation());
+      jacobian.block<3, 1>(3, i) = axis;
+      jacobian(6, i) =
+        i < 3 ? swivel_gradient.dot(axis.cross(elbow - frames[i].translation())) : 0.0;
+    }
+    const Eigen::PartialPivLU<Eigen::Matrix<double, 7, 7>> lu(jacobian);
+    q += lu.solve(residual);
+  }
+  return false;
+}
+
+double SevenDofSolver::swivel(const KinematicChain::JointVector & q) const
+{
+  std::array<Eigen::Isometry3d, KinematicChain::MAX_JOINTS> frames;
+  const Eigen::Isometry3d tip = chain_.forward(q, frames);
+  const Eigen::Vector3d direction = (tip * wrist_in_tip_ - shoulder_).normalized();
+  Eigen::Vector3d reference;
+  Eigen::Vector3d normal;
+  swivelPlane(direction, reference, normal);
+  const Eigen::Vector3d elbow = frames[3] * elbow_in_joint_ - shoulder_;
+  return std::atan2(normal.dot(elbow), reference.dot(elbow));
+}
+
+}  // namespace kortex_kinematics
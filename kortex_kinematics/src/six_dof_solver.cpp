@@ -0,0 +1,338 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <cmath>
+#include <limits>
+
+#include "kortex_kinematics/closed_form.hpp"
+#include "kortex_kinematics/six_dof_solver.hpp"
+
+namespace kortex_kinematics
+{
+namespace
+{
+constexpr int JOINTS = 6;
+// axes further apart than this do not meet, and a wrist this far off the last axis is offset
+constexpr double MAX_AXIS_OFFSET = 0.02;
+constexpr double MAX_AXIS_ANGLE = 0.01;
+constexpr int REFINE_ITERATIONS = 8;
+// offset wrist: samples of the last joint over a turn, and iterations on each root between two
+constexpr int WRIST_SAMPLES = 32;
+constexpr int ROOT_ITERATIONS = 4;
+// and bisections towards the end of a branch, when it stops between two samples
+constexpr int EDGE_ITERATIONS = 12;
+
+Eigen::Vector3d rotateZ(double angle, const Eigen::Vector3d & vector)
+{
+  const double c = std::cos(angle);
+  const double s = std::sin(angle);
+  return Eigen::Vector3d(
+    c * vector.x() - s * vector.y(), s * vector.x() + c * vector.y(), vector.z());
+}
+}  // namespace
+
+bool SixDofSolver::configure(const KinematicChain & chain)
+{
+  if (chain.size() != JOINTS)
+  {
+    return false;
+  }
+  chain_ = chain;
+
+  std::array<Eigen::Isometry3d, KinematicChain::MAX_JOINTS> frames;
+  const Eigen::Isometry3d tip = chain_.forward(KinematicChain::JointVector::Zero(JOINTS), frames);
+  const auto axis = [&frames](int joint) { return Eigen::Vector3d(frames[joint].linear().col(2)); };
+  const auto point = [&frames](int joint) { return Eigen::Vector3d(frames[joint].translation()); };
+
+  // planar elbow on the second and third axes, wrist center where the fourth and fifth meet
+  const Eigen::Vector3d wrist = closestPoint(point(3), axis(3), point(4), axis(4));
+  const Eigen::Vector3d last_crossing = closestPoint(point(5), axis(5), point(4), axis(4));
+  if (
+    axis(1).cross(axis(2)).norm() > MAX_AXIS_ANGLE ||
+    distanceToLine(wrist, point(4), axis(4)) > MAX_AXIS_OFFSET ||
+    distanceToLine(last_crossing, point(4), axis(4)) > MAX_AXIS_OFFSET)
+  {
+    return false;
+  }
+
+  wrist_in_joint_ = frames[2].inverse() * wrist;
+  lateral_offset_ = chain_.origin(1).linear().col(2).dot(frames[0].inverse() * wrist);
+  const Eigen::Vector3d offset = wrist - last_crossing;
+  offset_wrist_ = offset.norm() > MAX_AXIS_OFFSET;
+  if (!offset_wrist_)
+  {
+    wrist_in_tip_ = tip.inverse() * wrist;
+    return true;
+  }
+  wrist_in_tip_ = tip.inverse() * last_crossing;
+  wrist_offset_ = frames[5].linear().transpose() * offset;
+  wrist_offset_cosine_ = axis(3).dot(offset.normalized());
+  return true;
+}
+
+int SixDofSolver::solve(
+  const Eigen::Isometry3d & tip, Solutions & solutions, double tolerance) const
+{
+  const int approximate_count = approximate(tip, solutions);
+  int count = 0;
+  for (int i = 0; i < approximate_count; i++)
+  {
+    if (refine(tip, solutions[i], tolerance))
+    {
+      solutions[count++] = solutions[i];
+    }
+  }
+  return count;
+}
+
+int SixDofSolver::approximate(const Eigen::Isometry3d & tip, Solutions & solutions) const
+{
+  if (offset_wrist_)
+  {
+    return approximateOffsetWrist(tip, solutions);
+  }
+
+  ArmBranches arm;
+  const int mask = placeWrist(tip * wrist_in_tip_, arm);
+  const Eigen::Matrix3d last_frame = tip.linear() * chain_.tool().linear().transpose();
+  int count = 0;
+  for (int branch = 0; branch < ARM_BRANCHES; branch++)
+  {
+    if ((mask & (1 << branch)) == 0)
+    {
+      continue;
+    }
+    std::array<Eigen::Vector3d, 2> wrist;
+    const int wrist_count = orientWrist(arm[branch], last_frame, wrist);
+    for (int w = 0; w < wrist_count; w++)
+    {
+      KinematicChain::JointVector & q = solutions[count++];
+      q.resize(JOINTS);
+      q << arm[branch], wrist[w];
+    }
+  }
+  return count;
+}
+
+bool SixDofSolver::refine(
+  const Eigen::Isometry3d & tip, KinematicChain::JointVector & q, double tolerance) const
+{
+  if (!chain_.refine(tip, q, tolerance, REFINE_ITERATIONS))
+  {
+    return false;
+  }
+  for (int i = 0; i < JOINTS; i++)
+  {
+    q[i] = wrapAngle(q[i]);
+  }
+  return true;
+}
+
+int SixDofSolver::placeWrist(const Eigen::Vector3d & wrist, ArmBranches & arm) const
+{
+  // first joint keeps the wrist center at its offset along the second axis
+  const Eigen::Vector3d wrist_in_first = chain_.origin(0).inverse() * wrist;
+  double a = 0.0;
+  double b = 0.0;
+  double c = 0.0;
+  cosineSineCoefficients(wrist_in_first, chain_.origin(1).linear().col(2), a, b, c);
+  std::array<double, 2> shoulder_angles;
+  const int shoulder_count = solveCosineSine(a, b, lateral_offset_ - c, shoulder_angles);
+
+  // third joint from the distance of the wrist center to the second joint, which the second
+  // joint does not change
+  const Eigen::Isometry3d & elbow_origin = chain_.origin(2);
+  cosineSineCoefficients(
+    elbow_origin.linear().transpose() * elbow_origin.translation(), wrist_in_joint_, a, b, c);
+  const double distance_constant =
+    elbow_origin.translation().squaredNorm() + wrist_in_joint_.squaredNorm();
+
+  int mask = 0;
+  for (int s = 0; s < shoulder_count; s++)
+  {
+    const double q1 = shoulder_angles[s];
+    const Eigen::Vector3d wrist_in_second =
+      chain_.origin(1).inverse() * rotateZ(-q1, wrist_in_first);
+    std::array<double, 2> elbow_angles;
+    const int elbow_count = solveCosineSine(
+      a, b, 0.5 * (wrist_in_second.squaredNorm() - distance_constant) - c, elbow_angles);
+    for (int e = 0; e < elbow_count; e++)
+    {
+      const double q3 = elbow_angles[e];
+      const Eigen::Vector3d wrist_at_zero = elbow_origin * rotateZ(q3, wrist_in_joint_);
+      const double q2 = std::atan2(wrist_in_second.y(), wrist_in_second.x()) -
+                        std::atan2(wrist_at_zero.y(), wrist_at_zero.x());
+      arm[2 * s + e] << q1, q2, q3;
+      mask |= 1 << (2 * s + e);
+    }
+  }
+  return mask;
+}
+
+Eigen::Matrix3d SixDofSolver::wristBase(const Eigen::Vector3d & arm) const
+{
+  return chain_.origin(0).linear() * Eigen::AngleAxisd(arm[0], Eigen::Vector3d::UnitZ()) *
+         chain_.origin(1).linear() * Eigen::AngleAxisd(arm[1], Eigen::Vector3d::UnitZ()) *
+         chain_.origin(2).linear() * Eigen::AngleAxisd(arm[2], Eigen::Vector3d::UnitZ()) *
+         chain_.origin(3).linear();
+}
+
+Eigen::Vector3d SixDofSolver::fourthAxis(const Eigen::Vector3d & arm) const
+{
+  return chain_.origin(0).linear() *
+         rotateZ(
+           arm[0], chain_.origin(1).linear() *
+                     rotateZ(
+                       arm[1], chain_.origin(2).linear() *
+                                 rotateZ(arm[2], chain_.origin(3).linear().col(2))));
+}
+
+int SixDofSolver::orientWrist(
+  const Eigen::Vector3d & arm, const Eigen::Matrix3d & last_frame,
+  std::array<Eigen::Vector3d, 2> & wrist) const
+{
+  return decomposeRotation(
+    wristBase(arm).transpose() * last_frame, chain_.origin(4).linear(),
+    chain_.origin(5).linear(), 0.0, wrist);
+}
+
+void SixDofSolver::offsetWristResiduals(
+  const Eigen::Vector3d & crossing, const Eigen::Matrix3d & last_frame, double last,
+  ArmBranches & arm, std::array<double, ARM_BRANCHES> & residuals) const
+{
+  // the offset turns with the fifth joint frame, that is against the last joint
+  const Eigen::Vector3d offset = last_frame * rotateZ(-last, wrist_offset_);
+  const int mask = placeWrist(crossing + offset, arm);
+  const Eigen::Vector3d direction = offset.normalized();
+  for (int branch = 0; branch < ARM_BRANCHES; branch++)
+  {
+    residuals[branch] = (mask & (1 << branch)) == 0
+                          ? std::numeric_limits<double>::quiet_NaN()
+                          : fourthAxis(arm[branch]).dot(direction) - wrist_offset_cosine_;
+  }
+}
+
+void SixDofSolver::addOffsetWristRoot(
+  const Eigen::Vector3d & crossing, const Eigen::Matrix3d & last_frame, int branch, double low,
+  double low_value, double high, double high_value, Solutions & solutions, int & count) const
+{
+  if (count >= KinematicChain::MAX_SOLUTIONS || (low_value < 0.0) == (high_value < 0.0))
+  {
+    return;
+  }
+
+  // regula falsi, halving the weight of a side that stays to speed it up
+  ArmBranches arm;
+  std::array<double, ARM_BRANCHES> residuals;
+  double last = high;
+  int side = 0;
+  for (int iteration = 0; iteration < ROOT_ITERATIONS; iteration++)
+  {
+    last = (low * high_value - high * low_value) / (high_value - low_value);
+    offsetWristResiduals(crossing, last_frame, last, arm, residuals);
+    const double value = residuals[branch];
+    if (std::isnan(value))
+    {
+      return;
+    }
+    if ((value < 0.0) == (low_value < 0.0))
+    {
+      low = last;
+      low_value = value;
+      high_value *= side == -1 ? 0.5 : 1.0;
+      side = -1;
+    }
+    else
+    {
+      high = last;
+      high_value = value;
+      low_value *= side == 1 ? 0.5 : 1.0;
+      side = 1;
+    }
+  }
+
+  // of the two wrists, the one turning the last joint to the root
+  std::array<Eigen::Vector3d, 2> wrist;
+  const int wrist_count = orientWrist(arm[branch], last_frame, wrist);
+  if (wrist_count == 0)
+  {
+    return;
+  }
+  const int closest =
+    wrist_count == 2 &&
+        std::abs(wrapAngle(wrist[1][2] - last)) < std::abs(wrapAngle(wrist[0][2] - last))
+      ? 1
+      : 0;
+  KinematicChain::JointVector & q = solutions[count++];
+  q.resize(JOINTS);
+  q << arm[branch], wrist[closest];
+}
+
+int SixDofSolver::approximateOffsetWrist(
+  const Eigen::Isometry3d & tip, Solutions & solutions) const
+{
+  const Eigen::Vector3d crossing = tip * wrist_in_tip_;
+  const Eigen::Matrix3d last_frame = tip.linear() * chain_.tool().linear().transpose();
+  const double step = 2.0 * M_PI / WRIST_SAMPLES;
+  ArmBranches arm;
+  std::array<double, ARM_BRANCHES> previous;
+  std::array<double, ARM_BRANCHES> current;
+  std::array<double, ARM_BRANCHES> edge;
+  offsetWristResiduals(crossing, last_frame, -M_PI, arm, previous);
+
+  int count = 0;
+  for (int i = 1; i <= WRIST_SAMPLES; i++)
+  {
+    const double high = -M_PI + i * step;
+    const double low = high - step;
+    offsetWristResiduals(crossing, last_frame, high, arm, current);
+    for (int branch = 0; branch < ARM_BRANCHES; branch++)
+    {
+      if (std::isnan(previous[branch]) == std::isnan(current[branch]))
+      {
+        // NaN on both sides compares false, nothing to add
+        addOffsetWristRoot(
+          crossing, last_frame, branch, low, previous[branch], high, current[branch], solutions,
+          count);
+        continue;
+      }
+      // The branch ends between the samples, where it meets another one. Solutions gather
+      // close to that end, so every step of the bisection towards it brackets roots too.
+      const bool low_exists = !std::isnan(previous[branch]);
+      double inside = low_exists ? low : high;
+      double inside_value = low_exists ? previous[branch] : current[branch];
+      double outside = low_exists ? high : low;
+      for (int iteration = 0; iteration < EDGE_ITERATIONS; iteration++)
+      {
+        const double middle = 0.5 * (inside + outside);
+        offsetWristResiduals(crossing, last_frame, middle, arm, edge);
+        if (std::isnan(edge[branch]))
+        {
+          outside = middle;
+          continue;
+        }
+        addOffsetWristRoot(
+          crossing, last_frame, branch, inside, inside_value, middle, edge[branch], solutions,
+          count);
+        inside = middle;
+        inside_value = edge[branch];
+      }
+    }
+    previous = current;
+  }
+  return count;
+}
+
+}  // namespace kortex_kinematics
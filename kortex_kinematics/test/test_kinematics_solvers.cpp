@@ -0,0 +1,247 @@
+// Copyright 2021, PickNik Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include <Eigen/SVD>
+
+#include "kortex_kinematics/kinematic_chain.hpp"
+#include "kortex_kinematics/seven_dof_solver.hpp"
+#include "kortex_kinematics/six_dof_solver.hpp"
+
+namespace kortex_kinematics
+{
+namespace
+{
+using JointVector = KinematicChain::JointVector;
+
+constexpr int SAMPLES = 1000;
+constexpr double TOLERANCE = 1e-9;
+
+// A joint of the kortex_description arms: origin in the parent joint frame and position limit,
+// pi for the continuous joints whose solutions are wrapped to [-pi, pi]
+struct Joint
+{
+  Eigen::Vector3d xyz;
+  Eigen::Vector3d rpy;
+  double limit;
+};
+
+Eigen::Isometry3d urdfOrigin(const Eigen::Vector3d & xyz, const Eigen::Vector3d & rpy)
+{
+  Eigen::Isometry3d origin = Eigen::Isometry3d::Identity();
+  origin.translation() = xyz;
+  origin.linear() = (Eigen::AngleAxisd(rpy.z(), Eigen::Vector3d::UnitZ()) *
+                     Eigen::AngleAxisd(rpy.y(), Eigen::Vector3d::UnitY()) *
+                     Eigen::AngleAxisd(rpy.x(), Eigen::Vector3d::UnitX()))
+                      .toRotationMatrix();
+  return origin;
+}
+
+// Chain of the URDF joints, all turning about z, as the plugin builds it from the robot model
+KinematicChain makeChain(const std::vector<Joint> & joints, const Joint & tool)
+{
+  std::vector<Eigen::Isometry3d> origins;
+  for (const auto & joint : joints)
+  {
+    origins.push_back(urdfOrigin(joint.xyz, joint.rpy));
+  }
+  KinematicChain chain;
+  chain.setJoints(origins, urdfOrigin(tool.xyz, tool.rpy));
+  return chain;
+}
+
+const std::vector<Joint> GEN3_7DOF = {
+  {{0.0, 0.0, 0.15643}, {3.1416, 0.0, 0.0}, M_PI},
+  {{0.0, 0.005375, -0.12838}, {1.5708, 0.0, 0.0}, 2.24},
+  {{0.0, -0.21038, -0.006375}, {-1.5708, 0.0, 0.0}, M_PI},
+  {{0.0, 0.006375, -0.21038}, {1.5708, 0.0, 0.0}, 2.57},
+  {{0.0, -0.20843, -0.006375}, {-1.5708, 0.0, 0.0}, M_PI},
+  {{0.0, 0.00017505, -0.10593}, {1.5708, 0.0, 0.0}, 2.09},
+  {{0.0, -0.10593, -0.00017505}, {-1.5708, 0.0, 0.0}, M_PI},
+};
+const Joint GEN3_7DOF_TOOL = {{0.0, 0.0, -0.061525}, {M_PI, 0.0, 0.0}, 0.0};
+
+const std::vector<Joint> GEN3_6DOF = {
+  {{0.0, 0.0, 0.15643}, {-3.1416, 0.0, 0.0}, M_PI},
+  {{0.0, 0.005375, -0.12838}, {1.5708, 0.0, 0.0}, 2.24},
+  {{0.0, -0.41, 0.0}, {3.1416, 0.0, 0.0}, 2.57},
+  {{0.0, 0.20843, -0.006375}, {1.5708, 0.0, 0.0}, M_PI},
+  {{0.0, -0.00017505, -0.10593}, {-1.5708, 0.0, 0.0}, 2.09},
+  {{0.0, 0.10593, -0.00017505}, {1.5708, 0.0, 0.0}, M_PI},
+};
+const Joint GEN3_6DOF_TOOL = {{0.0, 0.0, -0.061525}, {M_PI, 0.0, M_PI}, 0.0};
+
+const std::vector<Joint> GEN3_LITE = {
+  {{0.0, 0.0, 0.12825}, {0.0, 0.0, 0.0}, 2.68},
+  {{0.0, -0.03, 0.115}, {1.5708, 0.0, 0.0}, 2.61},
+  {{0.0, 0.28, 0.0}, {-3.1416, 0.0, 0.0}, 2.61},
+  {{0.0, -0.14, 0.02}, {1.5708, 0.0, 0.0}, 2.6},
+  {{0.0285, 0.0, 0.105}, {0.0, 1.5708, 0.0}, 2.53},
+  {{-0.105, 0.0, 0.0285}, {0.0, -1.5708, 0.0}, 2.6},
+};
+const Joint GEN3_LITE_TOOL = {{0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, 0.0};
+
+// Random joint values within the limits, away from the singular configurations where the
+// Newton steps of the solvers are ill-conditioned and branches merge
+JointVector randomJoints(
+  const std::vector<Joint> & joints, const std::function<bool(const JointVector &)> & regular,
+  std::mt19937 & random)
+{
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  JointVector q(joints.size());
+  do
+  {
+    for (std::size_t i = 0; i < joints.size(); ++i)
+    {
+      q[i] = joints[i].limit * uniform(random);
+    }
+  } while (!regular(q));
+  return q;
+}
+
+// Shoulder, elbow and wrist of the 7 joint arm, the shoulder being singular for the swivel angle
+bool regularSevenDof(const JointVector & q)
+{
+  constexpr double MIN_SINE = 0.2;
+  return std::abs(std::sin(q[1])) > MIN_SINE && std::abs(std::sin(q[3])) > MIN_SINE &&
+         std::abs(std::sin(q[5])) > MIN_SINE;
+}
+
+// Six joint arms, whose singularities do not all sit at fixed joint values on the lite
+std::function<bool(const JointVector &)> regularSixDof(const KinematicChain & chain)
+{
+  return [&chain](const JointVector & q)
+  {
+    constexpr double MIN_SINGULAR_VALUE = 0.03;
+    KinematicChain::Jacobian jacobian;
+    chain.jacobian(q, jacobian);
+    const Eigen::JacobiSVD<Eigen::MatrixXd> svd(jacobian);
+    return svd.singularValues().minCoeff() > MIN_SINGULAR_VALUE;
+  };
+}
+
+// Whether two joint vectors are the same configuration, modulo full turns
+bool sameConfiguration(const JointVector & a, const JointVector & b, double tolerance)
+{
+  for (int i = 0; i < a.size(); ++i)
+  {
+    if (std::abs(std::remainder(a[i] - b[i], 2.0 * M_PI)) > tolerance)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Every solution reaches tip with its joints in [-pi, pi], and one of them is q
+void expectSolutions(
+  const KinematicChain & chain, const Eigen::Isometry3d & tip, const JointVector & q,
+  const KinematicChain::Solutions & solutions, int count)
+{
+  ASSERT_GE(count, 1) << "q = " << q.transpose();
+  ASSERT_LE(count, KinematicChain::MAX_SOLUTIONS);
+  bool found = false;
+  for (int i = 0; i < count; ++i)
+  {
+    const JointVector & solution = solutions[i];
+    ASSERT_EQ(solution.size(), chain.size());
+    EXPECT_LT(chain.error(tip, solution).norm(), 1e-6) << "solution = " << solution.transpose();
+    EXPECT_LE(solution.cwiseAbs().maxCoeff(), M_PI + 1e-12);
+    found = found || sameConfiguration(solution, q, 1e-6);
+  }
+  EXPECT_TRUE(found) << "q = " << q.transpose();
+}
+
+TEST(KinematicsSolversTest, ForwardOfSevenDofSolutionsIsTheTarget)
+{
+  const KinematicChain chain = makeChain(GEN3_7DOF, GEN3_7DOF_TOOL);
+  SevenDofSolver solver;
+  ASSERT_TRUE(solver.configure(chain));
+
+  std::mt19937 random(7);
+  KinematicChain::Solutions solutions;
+  for (int sample = 0; sample < SAMPLES; ++sample)
+  {
+    const JointVector q = randomJoints(GEN3_7DOF, regularSevenDof, random);
+    const Eigen::Isometry3d tip = chain.forward(q);
+    const int count = solver.solve(tip, solver.swivel(q), solutions, TOLERANCE);
+    expectSolutions(chain, tip, q, solutions, count);
+    for (int i = 0; i < count; ++i)
+    {
+      EXPECT_NEAR(std::remainder(solver.swivel(solutions[i]) - solver.swivel(q), 2.0 * M_PI),
+                  0.0, 1e-6);
+    }
+  }
+}
+
+TEST(KinematicsSolversTest, ForwardOfSixDofSolutionsIsTheTarget)
+{
+  const KinematicChain chain = makeChain(GEN3_6DOF, GEN3_6DOF_TOOL);
+  SixDofSolver solver;
+  ASSERT_TRUE(solver.configure(chain));
+
+  std::mt19937 random(6);
+  KinematicChain::Solutions solutions;
+  for (int sample = 0; sample < SAMPLES; ++sample)
+  {
+    const JointVector q = randomJoints(GEN3_6DOF, regularSixDof(chain), random);
+    const Eigen::Isometry3d tip = chain.forward(q);
+    expectSolutions(chain, tip, q, solutions, solver.solve(tip, solutions, TOLERANCE));
+  }
+}
+
+TEST(KinematicsSolversTest, ForwardOfLiteSolutionsIsTheTarget)
+{
+  const KinematicChain chain = makeChain(GEN3_LITE, GEN3_LITE_TOOL);
+  SixDofSolver solver;
+  ASSERT_TRUE(solver.configure(chain));
+
+  std::mt19937 random(5);
+  KinematicChain::Solutions solutions;
+  for (int sample = 0; sample < SAMPLES; ++sample)
+  {
+    const JointVector q = randomJoints(GEN3_LITE, regularSixDof(chain), random);
+    const Eigen::Isometry3d tip = chain.forward(q);
+    expectSolutions(chain, tip, q, solutions, solver.solve(tip, solutions, TOLERANCE));
+  }
+}
+
+TEST(KinematicsSolversTest, UnreachableTargetsHaveNoSolution)
+{
+  const KinematicChain seven_dof = makeChain(GEN3_7DOF, GEN3_7DOF_TOOL);
+  const KinematicChain six_dof = makeChain(GEN3_6DOF, GEN3_6DOF_TOOL);
+  const KinematicChain lite = makeChain(GEN3_LITE, GEN3_LITE_TOOL);
+  SevenDofSolver seven_dof_solver;
+  SixDofSolver six_dof_solver;
+  SixDofSolver lite_solver;
+  ASSERT_TRUE(seven_dof_solver.configure(seven_dof));
+  ASSERT_TRUE(six_dof_solver.configure(six_dof));
+  ASSERT_TRUE(lite_solver.configure(lite));
+
+  Eigen::Isometry3d far = Eigen::Isometry3d::Identity();
+  far.translation() = Eigen::Vector3d(2.0, 0.0, 0.5);
+  KinematicChain::Solutions solutions;
+  EXPECT_EQ(seven_dof_solver.solve(far, 0.0, solutions), 0);
+  EXPECT_EQ(six_dof_solver.solve(far, solutions), 0);
+  EXPECT_EQ(lite_solver.solve(far, solutions), 0);
+}
+
+}  // namespace
+}  // namespace kortex_kinematics
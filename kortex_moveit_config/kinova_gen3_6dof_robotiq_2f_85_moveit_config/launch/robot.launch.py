@@ -35,6 +35,7 @@ def launch_setup(context, *args, **kwargs):
     gripper_max_velocity = LaunchConfiguration("gripper_max_velocity")
     gripper_max_force = LaunchConfiguration("gripper_max_force")
     launch_rviz = LaunchConfiguration("launch_rviz")
+    use_convex_collision = LaunchConfiguration("use_convex_collision")
     use_sim_time = LaunchConfiguration("use_sim_time")
     use_internal_bus_gripper_comm = LaunchConfiguration("use_internal_bus_gripper_comm")
 
@@ -47,6 +48,7 @@ def launch_setup(context, *args, **kwargs):
         "gripper_max_velocity": gripper_max_velocity,
         "gripper_max_force": gripper_max_force,
         "use_internal_bus_gripper_comm": use_internal_bus_gripper_comm,
+        "use_convex_collision": use_convex_collision,
     }
 
     moveit_config = (
@@ -222,6 +224,13 @@ def generate_launch_description():
         )
     )
 
+    declared_arguments.append(
+        DeclareLaunchArgument(
+            "use_convex_collision",
+            default_value="false",
+            description="Collide the arm links as the convex hulls of their meshes",
+        )
+    )
     declared_arguments.append(
         DeclareLaunchArgument(
             "use_sim_time",